@@ -84,6 +84,7 @@
 
 /* USER CODE BEGIN Includes */   	      
 /* Section where include file can be added */
+#include "lasertag_config.h"
 /* USER CODE END Includes */ 
 
 /* Ensure stdint is only used by the compiler, and not the assembler. */
@@ -164,6 +165,51 @@ standard names. */
 
 /* USER CODE BEGIN Defines */   	      
 /* Section where parameter definitions can be added (for instance, to override default ones in FreeRTOS.h) */
+/* All kernel objects are allocated statically, heap_4.c is not linked. The
+CubeMX heap size is dropped so nothing can size a heap from it. Stack sizes
+are set from the worst case estimate of pc/test "make ram" (freertos.c),
+high water marks of the running firmware are in the LASERTAG_DIAG report. */
+#undef  configTOTAL_HEAP_SIZE
+#define configSUPPORT_STATIC_ALLOCATION          1
+#define configSUPPORT_DYNAMIC_ALLOCATION         0
+#define configCHECK_FOR_STACK_OVERFLOW           2
+#define INCLUDE_uxTaskGetStackHighWaterMark      1
+/* Idle task enters SLEEP/STOP, see lasertag_power.h */
+#define configUSE_TICKLESS_IDLE                  1
+/* Queue registry only names queues for a kernel aware debugger, no RAM for it
+(lasertag_config.h) */
+#undef  configQUEUE_REGISTRY_SIZE
+#define configQUEUE_REGISTRY_SIZE                0
+/* Task names as long as the LASERTAG_DIAG report keeps them, TCB and queue
+numbers only for the DIAG report (lasertag_config.h) */
+#undef  configMAX_TASK_NAME_LEN
+#define configMAX_TASK_NAME_LEN                  ( 8 )
+#if !LASERTAG_DIAG
+#undef  configUSE_TRACE_FACILITY
+#define configUSE_TRACE_FACILITY                 0
+#endif
+
+/* Run time stats on TIM2 cycle counter (started before the scheduler),
+queue depth maxima via trace hook, see lasertag_diag.h. Diagnostic builds
+only (lasertag_config.h). */
+#if LASERTAG_DIAG
+#if defined(__ICCARM__) || defined(__CC_ARM) || defined(__GNUC__)
+    #include "stm32f0xx.h"
+    void LASERTAG_DIAG_QueueDepth(uint32_t Number, uint32_t Depth);
+#endif
+#define configGENERATE_RUN_TIME_STATS            1
+#define portCONFIGURE_TIMER_FOR_RUN_TIME_STATS()
+#define portGET_RUN_TIME_COUNTER_VALUE()         (TIM2->CNT)
+#define traceQUEUE_SEND( pxQueue )               LASERTAG_DIAG_QueueDepth( ( pxQueue )->uxQueueNumber, ( pxQueue )->uxMessagesWaiting + 1 )
+#define traceQUEUE_SEND_FROM_ISR( pxQueue )      LASERTAG_DIAG_QueueDepth( ( pxQueue )->uxQueueNumber, ( pxQueue )->uxMessagesWaiting + 1 )
+#endif
+/* task switch record in trace ring, see lasertag_trace.h */
+#if LASERTAG_TRACE
+#if defined(__ICCARM__) || defined(__CC_ARM) || defined(__GNUC__)
+    void LASERTAG_TRACE_TaskIn(const char *pName);
+#endif
+#define traceTASK_SWITCHED_IN()                  LASERTAG_TRACE_TaskIn( pxCurrentTCB->pcTaskName )
+#endif
 /* USER CODE END Defines */ 
 
 #endif /* FREERTOS_CONFIG_H */
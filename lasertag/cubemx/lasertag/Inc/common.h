@@ -17,6 +17,7 @@
 
 /* Includes ------------------------------------------------------------------*/
 #include "stm32f0xx_hal.h"
+#include "lasertag_config.h"
 	 
 
 
@@ -25,6 +26,30 @@
 #define TRUE		1
 #define FALSE		0
 
+#define CRC16_INIT	0xFFFF
+
+// TIM2 free running at SystemCoreClock (MX_TIM2_Init) - cycle time stamps,
+// host builds bring their own (pc/test/host_cm0.h)
+#ifndef CYCLE_COUNTER
+#define CYCLE_COUNTER()			(TIM2->CNT)
+#endif
+#define CYCLES_PER_US				48
+
+/**	GPIO fast path, single store to BSRR/BRR, no HAL call
+		Port/pin resolved at compile time, Name = CubeMX label (mxconstants.h)
+
+		PIN_HIGH(LD3);		GPIO_LOW(FLASH_SPI_CS_GPIO_PORT, FLASH_SPI_CS_PIN);
+*/
+#define GPIO_HIGH(Port, Pin)		((Port)->BSRR = (Pin))
+#define GPIO_LOW(Port, Pin)			((Port)->BRR = (Pin))
+#define GPIO_TOGGLE(Port, Pin)	((Port)->BSRR = (((Port)->ODR & (Pin)) << 16) | (~(Port)->ODR & (Pin)))
+#define GPIO_READ(Port, Pin)		(((Port)->IDR & (Pin)) != 0)
+
+#define PIN_HIGH(Name)					GPIO_HIGH(Name##_GPIO_Port, Name##_Pin)
+#define PIN_LOW(Name)						GPIO_LOW(Name##_GPIO_Port, Name##_Pin)
+#define PIN_TOGGLE(Name)				GPIO_TOGGLE(Name##_GPIO_Port, Name##_Pin)
+#define PIN_READ(Name)					GPIO_READ(Name##_GPIO_Port, Name##_Pin)
+
 
 
 /**	Error file name, file line
@@ -33,6 +58,15 @@
 */
 void Error_Handler(void);
 
+/**	CRC-16/CCITT, Crc = CRC16_INIT for new calculation
+*/
+uint16_t CRC16_Calc(uint16_t Crc, const uint8_t *pData, uint32_t Size);
+
+/**	Wait for task notification bits, other bits stay pending
+		retval: received Bits, 0 = timeout
+*/
+uint32_t NOTIFY_Wait(uint32_t Bits, uint32_t Timeout);
+
 #ifdef __cplusplus
 }
 #endif
@@ -1,29 +0,0 @@
-/**
-  ******************************************************************************
-  * File Name          : flash.h
-  * Description        : flash spi memory driver
-  ******************************************************************************
-  * author: Tomas Krejci <info@tomaskrejci.com>
-  * 
-  *
-  ******************************************************************************
-  */
-/* Define to prevent recursive inclusion -------------------------------------*/
-#ifndef __flash_H
-#define __flash_H
-#ifdef __cplusplus
- extern "C" {
-#endif
-
-/* Includes ------------------------------------------------------------------*/
-#include "stm32f0xx_hal.h"
-	 
-	 
-void Flash_Init(void);
-void Flash_CS(uint8_t active);
-void Flash_ReadID(uint8_t *pJdecId);	 
-	 
-#ifdef __cplusplus
-}
-#endif
-#endif /*__ flash_H */
@@ -0,0 +1,54 @@
+/**
+  ******************************************************************************
+  * File Name          : flash_cache.h
+  * Description        : RAM line cache with read-ahead over the serial flash
+  ******************************************************************************
+  * author: Tomas Krejci <info@tomaskrejci.com>
+  *
+  *
+  ******************************************************************************
+  */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __flash_cache_H
+#define __flash_cache_H
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f0xx_hal.h"
+
+/**		FLASH_CACHE_LINES lines of one flash page, least recently used line
+			is replaced. Used by lasertag_storage.c only:
+			- FLASH_CACHE_Lookup		any task, hit = memcpy with scheduler locked
+			- FLASH_CACHE_Read			storage task, fills missing lines
+			- FLASH_CACHE_Prefetch	storage task, fills read-ahead line
+			- FLASH_CACHE_Invalidate	storage task, after any flash write
+
+			Read starting where the previous one ended = sequential stream
+			(audio), the line after it is marked for read-ahead. A line is
+			filled while it is invalid, lookups never see partial data.
+*/
+#define		FLASH_CACHE_LINES				2
+#define		FLASH_CACHE_LINE_SIZE		128			//2 audio reads (AUDIO_BLOCK, lasertag_audio.c)
+
+typedef struct
+{
+	uint32_t Hit;						/*!< reads served from RAM */
+	uint32_t Miss;					/*!< reads with flash access */
+	uint32_t Prefetch;			/*!< read-ahead line fills */
+	uint32_t PrefetchHit;		/*!< read-ahead lines used before replaced */
+} FLASH_CACHE_StatsTypeDef;
+
+extern FLASH_CACHE_StatsTypeDef FLASH_CACHE_Stats;
+
+uint8_t FLASH_CACHE_Lookup(uint32_t Address, uint8_t *pData, uint32_t Size);
+uint8_t FLASH_CACHE_Read(uint32_t Address, uint8_t *pData, uint32_t Size);
+uint8_t FLASH_CACHE_Pending(void);
+void    FLASH_CACHE_Prefetch(void);
+void    FLASH_CACHE_Invalidate(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /*__flash_cache_H */
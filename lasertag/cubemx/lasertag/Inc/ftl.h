@@ -0,0 +1,89 @@
+/**
+  ******************************************************************************
+  * File Name          : ftl.h
+  * Description        : flash translation layer, 512B sectors for FatFs
+  ******************************************************************************
+  * author: Tomas Krejci <info@tomaskrejci.com>
+  *
+  *
+  ******************************************************************************
+  */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __ftl_H
+#define __ftl_H
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+
+/**		log region layout (LASERTAG_ADR_LOG, 4kB erase blocks)
+
+			Every block is in one pool: FTL_MAP_PARTS map blocks, mapped data
+			blocks and at least FTL_SPARE free blocks. Map blocks are found at
+			mount by their header, they rotate through the pool like data.
+
+			Logical block (8 sectors) -> block mapping, in flash only:
+			map block:	FTL_MAP_PER_BLOCK entries	<header 32B at end>
+			entry:			FTL_MAP_SLOTS slots, last valid slot wins
+			slot:				<pb 2B>	<~pb 2B>	<sequence 4B>		erased = empty
+			header:			<magic 4B>	<sequence 4B>	<part>	<~part>	<crc16 2B>
+
+			Remap = one 8B slot program. Entry full = compaction of the map part
+			into a free block, header written last - power fail keeps old block,
+			then the old block is erased.
+
+			Sector write:
+			- target sector still erased in current block -> programmed in place
+			  (log append costs no copy)
+			- otherwise written into an open replacement block, following writes
+			  of the same logical block go there too (coalescing); on switch to
+			  another block or sync the rest is copied and the map updated
+			Free blocks are taken round robin, every FTL_WEAR_INTERVAL allocations
+			one more logical block is moved (static wear leveling).
+
+			All calls from storage task (FatFs disk I/O).
+*/
+#define		FTL_SECTOR_SIZE				512
+#define		FTL_BLOCK_SIZE				0x1000
+#define		FTL_BLOCK_SECTORS			(FTL_BLOCK_SIZE / FTL_SECTOR_SIZE)
+#define		FTL_BLOCKS						(LASERTAG_ADR_LOG_SIZE / FTL_BLOCK_SIZE)
+
+#define		FTL_MAP_SLOTS					4
+#define		FTL_MAP_ENTRY_SIZE		(FTL_MAP_SLOTS * 8)
+#define		FTL_MAP_PER_BLOCK			((FTL_BLOCK_SIZE - 32) / FTL_MAP_ENTRY_SIZE)
+#define		FTL_MAP_PARTS					12
+#define		FTL_SPARE							24
+#define		FTL_WEAR_INTERVAL			64
+
+#define		FTL_LOGICAL_BLOCKS		(FTL_BLOCKS - FTL_MAP_PARTS - FTL_SPARE)
+#define		FTL_SECTORS						(FTL_LOGICAL_BLOCKS * FTL_BLOCK_SECTORS)
+
+// return value
+#define		FTL_OK								0x00
+#define		FTL_ERROR							0x01
+
+typedef struct
+{
+	uint32_t HostWrite;			/*!< sectors written by FatFs */
+	uint32_t FlashWrite;		/*!< sectors programmed incl. copies, WA = FlashWrite / HostWrite */
+	uint32_t InPlace;				/*!< sectors programmed into erased space of current block */
+	uint32_t Erase;					/*!< block erases incl. map */
+	uint32_t MapCompact;		/*!< map pair compactions */
+	uint32_t WearMove;			/*!< static wear leveling moves */
+	uint32_t HostRead;			/*!< sectors read by FatFs */
+	uint32_t FlashRead;			/*!< flash read transfers, contiguous sectors are one */
+} FTL_StatsTypeDef;
+
+extern FTL_StatsTypeDef FTL_Stats;
+
+uint8_t FTL_Mount(void);
+uint8_t FTL_Read(uint32_t Sector, uint8_t *pData, uint32_t Count);
+uint8_t FTL_Write(uint32_t Sector, const uint8_t *pData, uint32_t Count);
+uint8_t FTL_Sync(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /*__ftl_H */
@@ -53,6 +53,7 @@
 void MX_GPIO_Init(void);
 
 /* USER CODE BEGIN Prototypes */
+void LASERTAG_GPIO_Init(void);
 
 /* USER CODE END Prototypes */
 
@@ -0,0 +1,63 @@
+/**
+  ******************************************************************************
+  * File Name          : lasertag_audio.h
+  * Description        : sound playback from serial flash to DAC
+  ******************************************************************************
+  * author: Tomas Krejci <info@tomaskrejci.com>
+  *
+  *
+  ******************************************************************************
+  */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __LASERTAG_AUDIO_H
+#define __LASERTAG_AUDIO_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "cmsis_os.h"
+
+/**		audio region layout (LASERTAG_ADR_AUDIO)
+			<directory LASERTAG_AUDIO_SLOTS x <offset 4B> <size 4B>>	<sound data>...
+
+			offset - from LASERTAG_ADR_AUDIO, size - bytes, 0 / 0xFFFFFFFF = empty slot
+			sound  - IMA ADPCM 4 bit mono 8kHz, low nibble first, decoder starts
+			         from predictor 0 / step index 0
+
+			TIM15 update (8kHz) writes one sample to DAC channel 1, audio task
+			refills the other half of the sample buffer via the storage task.
+*/
+#define		LASERTAG_AUDIO_SLOTS				16
+#define		LASERTAG_AUDIO_RATE					8000
+// samples in half buffer, power of 2, 32ms at 8kHz = time a storage read
+// may wait for the storage task (FatFs write, FTL merge) without a dropout
+#define		LASERTAG_AUDIO_HALF					256
+#define		LASERTAG_AUDIO_QUEUE_LEN		4
+
+// task notification bits
+#define		LASERTAG_AUDIO_NOTIFY_HALF	0x00000001
+
+// IMA ADPCM decoder state
+typedef struct
+{
+	int32_t Predictor;
+	int8_t  StepIndex;
+} LASERTAG_AUDIO_DecoderTypeDef;
+
+extern osThreadId audioTaskHandle;
+
+void    LASERTAG_AUDIO_Init(void);
+void    LASERTAG_AUDIO_Task(void const *argument);
+void    LASERTAG_AUDIO_SampleCallback(void);
+uint8_t LASERTAG_AUDIO_Play(uint8_t Event);
+void    LASERTAG_AUDIO_DecodeReset(LASERTAG_AUDIO_DecoderTypeDef *pDecoder);
+void    LASERTAG_AUDIO_Decode(LASERTAG_AUDIO_DecoderTypeDef *pDecoder, const uint8_t *pCode, uint32_t Size, uint8_t *pOut);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LASERTAG_AUDIO_H */
@@ -0,0 +1,52 @@
+/**
+  ******************************************************************************
+  * File Name          : lasertag_bench.h
+  * Description        : cycle benchmarks of hot paths, run over pc link
+  ******************************************************************************
+  * author: Tomas Krejci <info@tomaskrejci.com>
+  *
+  *
+  ******************************************************************************
+  */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __LASERTAG_BENCH_H
+#define __LASERTAG_BENCH_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+
+/**		Benchmark = registered function timed by CYCLE_COUNTER per call,
+			call overhead (empty function) subtracted. Runs in storage task
+			(pc link command) with interrupts on: min = cost of the routine,
+			max = with ISR/higher task interference.
+
+			pc link answer data, little endian:
+			<bench cnt>	<index>	<iterations 2B>	<min 4B>	<avg 4B>	<max 4B>	<name>
+			iterations = count really run, request clamped to 1..LASERTAG_BENCH_ITER_MAX
+
+			Built with LASERTAG_BENCH only (lasertag_config.h). pc/test "make
+			cycles" runs the same table on the host, cycles estimated there.
+*/
+#define		LASERTAG_BENCH_NAME_LEN			16
+#define		LASERTAG_BENCH_ITER_MAX			1000
+
+typedef struct
+{
+	uint32_t Min;							/*!< [cycles] */
+	uint32_t Avg;
+	uint32_t Max;
+} LASERTAG_BENCH_ResultTypeDef;
+
+uint8_t  LASERTAG_BENCH_Count(void);
+uint8_t  LASERTAG_BENCH_Run(uint8_t Index, uint16_t Iterations, LASERTAG_BENCH_ResultTypeDef *pResult);
+uint16_t LASERTAG_BENCH_Read(uint8_t Index, uint16_t Iterations, uint8_t *pData);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LASERTAG_BENCH_H */
@@ -16,6 +16,8 @@
  extern "C" {
 #endif
 
+#include "cmsis_os.h"
+
 /**		command packet 
 			<1.byte>	<2.byte>	<3.byte> 
 	    <command>	<target>	<count page>	
@@ -29,6 +31,14 @@
 #define 	 LASERTAG_TAR_SETUP					0x11 
 #define 	 LASERTAG_TAR_AUDIO					0x12 
 #define 	 LASERTAG_TAR_LOG					  0x13
+// DIAG, TRACE, BENCH answer with error unless built in (lasertag_config.h)
+#define 	 LASERTAG_TAR_DIAG					0x14
+#define 	 LASERTAG_TAR_TRACE					0x15
+#define 	 LASERTAG_TAR_BENCH					0x16
+
+// answer status
+#define 	 LASERTAG_STATUS_OK					0x00
+#define 	 LASERTAG_STATUS_ERROR			0x01
 
 // page and buffer size	 
 #define		 LASERTAG_DATA_PAGE_SIZE	 	0x200 //512 
@@ -40,13 +50,16 @@
 #define 	 LASERTAG_ADR_AUDIO_SIZE	  0x200000 //2048kB	
 #define 	 LASERTAG_ADR_LOG						0x202000 //0x202000-0x7FFFFF 
 #define 	 LASERTAG_ADR_LOG_SIZE	  	0x5FE000 //6136kB		 
-	 
+
+// storage task notification bit, log sector sent (commands run as storage jobs)
+#define 	 LASERTAG_BOARD_NOTIFY_TX		0x00000001
 	 
 void LASERTAG_BOARD_Init(void);
 void LASERTAG_BOARD_TxHalfCpltCallback(void);
 void LASERTAG_BOARD_TxCpltCallback(void);
 void LASERTAG_BOARD_RxHalfCpltCallback(void);	
 void LASERTAG_BOARD_RxCpltCallback(void);
+void LASERTAG_BOARD_Command(uint8_t *pPage);
 
 	 
 #ifdef __cplusplus
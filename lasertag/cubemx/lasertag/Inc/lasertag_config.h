@@ -0,0 +1,59 @@
+/**
+  ******************************************************************************
+  * File Name          : lasertag_config.h
+  * Description        : build switches and RAM budget
+  ******************************************************************************
+  * author: Tomas Krejci <info@tomaskrejci.com>
+  *
+  *
+  ******************************************************************************
+  */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __LASERTAG_CONFIG_H
+#define __LASERTAG_CONFIG_H
+
+/**		RAM budget, STM32F051R8 = 8 KB SRAM:
+			0x0300	main stack (startup, ISRs and scheduler start), worst case
+							668 B = init path to f_mount + one IRQ + TIM6 tick nesting
+			0x0000	heap, nothing allocates (FreeRTOS static, FatFs no LFN)
+			0x1D00	.data + .bss (7424 B), checked in the map file
+							"Total RW Size (RW Data + ZI Data)"
+
+			The release build (all switches 0) must fit in that, pc/test
+			"make ram" checks it and the stack depths (stack.txt) on the host.
+			Largest users:
+			FatFs object, window, name hash		~650
+			task stacks (4 tasks and idle)				1976
+			TCBs, static queues, mutexes				~800
+			pc link page (RX and answer)				 512
+			audio samples (2 x 32 ms)						 512
+			flash cache (2 lines)								 256
+			setup store record buffer						 256
+			FTL free bitmap, copy buffer, map		~360
+			IR RX/TX run from interrupts, the pc link commands run as storage
+			jobs, none of them has a task stack.
+
+			Profiling builds set a switch in the project defines (-D), one at a
+			time. DIAG and BENCH add RAM on top of the release budget, check the
+			map file. TRACE runs without the led task and fits (72 B free), it
+			is the one to take a hit response trace on the target:
+			LASERTAG_DIAG		~370 B	TAR_DIAG report, run time stats, queue depth
+			LASERTAG_TRACE	 -28 B	TAR_TRACE ring of 32, ISR, task switch, hit records
+			LASERTAG_BENCH	~610 B	TAR_BENCH cycle benchmarks
+*/
+// idle task stack [words], runs vPortSuppressTicksAndSleep (freertos.c)
+#define		LASERTAG_IDLE_STACK_SIZE			56
+
+#ifndef LASERTAG_DIAG
+#define		LASERTAG_DIAG									0
+#endif
+
+#ifndef LASERTAG_TRACE
+#define		LASERTAG_TRACE								0
+#endif
+
+#ifndef LASERTAG_BENCH
+#define		LASERTAG_BENCH								0
+#endif
+
+#endif /* __LASERTAG_CONFIG_H */
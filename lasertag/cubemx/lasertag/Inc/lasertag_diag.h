@@ -0,0 +1,77 @@
+/**
+  ******************************************************************************
+  * File Name          : lasertag_diag.h
+  * Description        : run time diagnostics - CPU, stacks, queues, latency
+  ******************************************************************************
+  * author: Tomas Krejci <info@tomaskrejci.com>
+  *
+  *
+  ******************************************************************************
+  */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __LASERTAG_DIAG_H
+#define __LASERTAG_DIAG_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+
+/**		Run time stats clock = CYCLE_COUNTER (TIM2, 48MHz, wraps after 89s).
+			CPU load is computed from counter deltas over the window since the
+			previous report read, each read closes the window. A window longer
+			than LASERTAG_DIAG_WINDOW_MAX_MS (counter may have wrapped) reports
+			cpu LASERTAG_DIAG_CPU_UNKNOWN, poll faster. STOP time is not counted
+			(TIM2 stopped), see power part of the report.
+
+			pc link answer data, little endian:
+			<task cnt>	{<name 8B>	<cpu [0.1%] 2B>	<stack free [words] 2B>	<priority>	<state>}
+			<queue cnt>	{<number>	<max depth>	<length>}
+			<hit last [us] 4B>	<hit max [us] 4B>	<hit cnt 4B>
+			<phase cnt>	{<time [ms] 4B>	<sleep [ms] 4B>	<stop [ms] 4B>	<current [uA] 4B>}
+			<cache hit 4B>	<cache miss 4B>	<prefetch 4B>	<prefetch hit 4B>
+			<ftl host write 4B>	<flash write 4B>	<in place 4B>	<erase 4B>	<map compact 4B>	<wear move 4B>
+			<ftl host read 4B>	<flash read 4B>
+			<main stack free [words] 2B>
+
+			Stack free is the high water mark of each stack: tasks and idle from
+			uxTaskGetStackHighWaterMark, main stack (interrupts after scheduler
+			start) from the fill written by LASERTAG_DIAG_StackFill at reset.
+			Stack sizes in freertos.c and lasertag_config.h are checked against
+			it after a full load run (shooting, sounds, pc link log download).
+
+			Built with LASERTAG_DIAG only (lasertag_config.h).
+*/
+#define		LASERTAG_DIAG_WINDOW_MAX_MS		80000
+#define		LASERTAG_DIAG_CPU_UNKNOWN			0xFFFF
+#define		LASERTAG_DIAG_TASKS						5 //4 tasks + idle (freertos.c)
+#define		LASERTAG_DIAG_NAME_LEN				8
+// main stack, Stack_Size in startup_stm32f051x8.s
+#define		LASERTAG_DIAG_MAIN_STACK_SIZE	0x300
+#define		LASERTAG_DIAG_STACK_FILL			0xA5A5A5A5 //as FreeRTOS task stacks
+
+// queue numbers (vQueueSetQueueNumber), 0 = not tracked
+#define		LASERTAG_DIAG_QUEUE_STORAGE		1
+#define		LASERTAG_DIAG_QUEUE_GAME			2
+#define		LASERTAG_DIAG_QUEUE_AUDIO			3
+#define		LASERTAG_DIAG_QUEUES					4
+
+#if LASERTAG_DIAG
+void     LASERTAG_DIAG_StackFill(void);
+void     LASERTAG_DIAG_Sample(void);
+void     LASERTAG_DIAG_Queue(QueueHandle_t xQueue, uint8_t Number);
+void     LASERTAG_DIAG_QueueDepth(uint32_t Number, uint32_t Depth);
+uint16_t LASERTAG_DIAG_Read(uint8_t *pData);
+void     LASERTAG_DIAG_Reset(void);
+#else
+#define		LASERTAG_DIAG_StackFill()
+#define		LASERTAG_DIAG_Queue(xQueue, Number)
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LASERTAG_DIAG_H */
@@ -0,0 +1,61 @@
+/**
+  ******************************************************************************
+  * File Name          : lasertag_game.h
+  * Description        : game logic task - shots, hits, respawn, game time
+  ******************************************************************************
+  * author: Tomas Krejci <info@tomaskrejci.com>
+  *
+  *
+  ******************************************************************************
+  */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __LASERTAG_GAME_H
+#define __LASERTAG_GAME_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "cmsis_os.h"
+
+#define		LASERTAG_GAME_QUEUE_LEN			8
+// min time between shots, also trigger debounce
+#define		LASERTAG_GAME_SHOT_MS				100
+#define		LASERTAG_GAME_RELOAD_MS			2000
+
+// event type
+#define		LASERTAG_GAME_EVENT_HIT			0x01	/*!< Data = IR packet */
+#define		LASERTAG_GAME_EVENT_TRIGGER	0x02
+
+typedef struct
+{
+	uint8_t  Type;						/*!< LASERTAG_GAME_EVENT_x */
+	uint8_t  Reserved;
+	uint16_t Data;
+	uint32_t Time;						/*!< CYCLE_COUNTER at event source */
+} LASERTAG_GAME_EventTypeDef;
+
+// hit response = IR packet last edge -> game state updated, sound requested
+typedef struct
+{
+	uint32_t HitLast;					/*!< [cycles] */
+	uint32_t HitMax;					/*!< [cycles] */
+	uint32_t HitCnt;
+} LASERTAG_GAME_StatsTypeDef;
+
+extern osThreadId gameTaskHandle;
+extern LASERTAG_GAME_StatsTypeDef LASERTAG_GAME_Stats;
+
+void    LASERTAG_GAME_Init(void);
+void    LASERTAG_GAME_Task(void const *argument);
+uint8_t LASERTAG_GAME_Post(const LASERTAG_GAME_EventTypeDef *pEvent);
+uint8_t LASERTAG_GAME_PostFromISR(const LASERTAG_GAME_EventTypeDef *pEvent, BaseType_t *pWoken);
+void    LASERTAG_GAME_TriggerCallback(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LASERTAG_GAME_H */
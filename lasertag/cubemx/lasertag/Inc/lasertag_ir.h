@@ -0,0 +1,75 @@
+/**
+  ******************************************************************************
+  * File Name          : lasertag_ir.h
+  * Description        : IR shot packet receive (EXTI) and transmit (IRTIM)
+  ******************************************************************************
+  * author: Tomas Krejci <info@tomaskrejci.com>
+  *
+  *
+  ******************************************************************************
+  */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __LASERTAG_IR_H
+#define __LASERTAG_IR_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "cmsis_os.h"
+
+/**		shot packet (LASERTAG_IR_PROTOCOL_MILESTAG), 14 bits MSB first
+			<header mark 2400us>	<space 600us>	{<bit mark 600/1200us>	<space 600us>} x14
+			bit:	13				12..6			5..4		3..0
+						<0>				<player>	<team>	<damage code>
+
+			RX: TSOP output on IR_RX_Pin (active low), EXTI on both edges measures
+			mark widths with CYCLE_COUNTER and decodes them, no task involved.
+			Frame holds LASERTAG_POWER_HOLD_IR_RX from first edge until
+			LASERTAG_IR_GAP_MS without edge (LASERTAG_IR_Tick).
+			TX: IRTIM = TIM17 carrier AND TIM16 envelope, TIM16 update interrupt
+			steps through mark/space durations and starts the next waiting
+			packet, no task involved.
+*/
+#define		LASERTAG_IR_BITS						14
+#define		LASERTAG_IR_HEADER_US				2400
+#define		LASERTAG_IR_ZERO_US					600
+#define		LASERTAG_IR_ONE_US					1200
+#define		LASERTAG_IR_SPACE_US				600
+#define		LASERTAG_IR_TOLERANCE_US		200
+// header edge wakes MCU from STOP, time stamp is late by PLL restart
+#define		LASERTAG_IR_WAKE_US					300
+// no edge for this long = frame aborted
+#define		LASERTAG_IR_GAP_MS					5
+
+#define		LASERTAG_IR_PACKET(Player, Team, Damage)	\
+					((((uint16_t)(Player) & 0x7F) << 6) | (((Team) & 0x03) << 4) | ((Damage) & 0x0F))
+#define		LASERTAG_IR_PLAYER(Packet)	(((Packet) >> 6) & 0x7F)
+#define		LASERTAG_IR_TEAM(Packet)		(((Packet) >> 4) & 0x03)
+#define		LASERTAG_IR_DAMAGE(Packet)	((Packet) & 0x0F)
+
+// shots waiting behind the one on air
+#define		LASERTAG_IR_TX_QUEUE_LEN		2
+
+// decoder state, one mark at a time
+typedef struct
+{
+	uint8_t  Bit;						/*!< received bits, 0xFF = waiting for header */
+	uint16_t Packet;
+} LASERTAG_IR_DecoderTypeDef;
+
+void    LASERTAG_IR_Init(void);
+void    LASERTAG_IR_EdgeCallback(void);
+void    LASERTAG_IR_Tick(void);
+void    LASERTAG_IR_TxTimerCallback(void);
+uint8_t LASERTAG_IR_Send(uint16_t Packet);
+void    LASERTAG_IR_DecodeReset(LASERTAG_IR_DecoderTypeDef *pDecoder);
+uint8_t LASERTAG_IR_Decode(LASERTAG_IR_DecoderTypeDef *pDecoder, uint16_t MarkUs);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LASERTAG_IR_H */
@@ -0,0 +1,43 @@
+/**
+  ******************************************************************************
+  * File Name          : lasertag_led.h
+  * Description        : activity LEDs, low rate indicator task
+  ******************************************************************************
+  * author: Tomas Krejci <info@tomaskrejci.com>
+  *
+  *
+  ******************************************************************************
+  */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __LASERTAG_LED_H
+#define __LASERTAG_LED_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "cmsis_os.h"
+
+/**		Drivers only report activity (one notification), the LED task makes
+			one blink per LASERTAG_LED_PERIOD_MS at most. No GPIO work in the
+			flash or uart paths, task blocks forever without activity (STOP).
+*/
+#define		LASERTAG_LED_LINK						0x01		//LD3 green, pc link packet
+#define		LASERTAG_LED_FLASH					0x02		//LD4 blue, storage job
+
+#define		LASERTAG_LED_ON_MS					20
+#define		LASERTAG_LED_PERIOD_MS			100
+
+extern osThreadId ledTaskHandle;
+
+void LASERTAG_LED_Task(void const *argument);
+void LASERTAG_LED_Activity(uint32_t Led);
+void LASERTAG_LED_ActivityFromISR(uint32_t Led, BaseType_t *pWoken);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LASERTAG_LED_H */
@@ -0,0 +1,83 @@
+/**
+  ******************************************************************************
+  * File Name          : lasertag_power.h
+  * Description        : tickless idle, STOP mode and energy accounting
+  ******************************************************************************
+  * author: Tomas Krejci <info@tomaskrejci.com>
+  *
+  *
+  ******************************************************************************
+  */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __LASERTAG_POWER_H
+#define __LASERTAG_POWER_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+
+/**		Idle task (configUSE_TICKLESS_IDLE) picks the deepest allowed state:
+			- SLEEP	WFI, tick running - a hold bit is set, awake window runs or
+							expected idle time is shorter than LASERTAG_POWER_STOP_MIN_MS
+			- STOP	all clocks off, RTC alarm (LSI) ends the suppressed ticks,
+							wake-up also by EXTI (IR RX, B1) and USART1 start bit
+
+			Hold bits mark peripherals needing clocks: TIM15/DAC audio, IRTIM,
+			UART TX DMA, TIM2 time stamps of an IR frame, SPI flash DMA read.
+*/
+#define		LASERTAG_POWER_HOLD_AUDIO			0x01
+#define		LASERTAG_POWER_HOLD_IR_TX			0x02
+#define		LASERTAG_POWER_HOLD_IR_RX			0x04
+#define		LASERTAG_POWER_HOLD_LINK			0x08
+#define		LASERTAG_POWER_HOLD_SPI				0x20
+
+#define		LASERTAG_POWER_STOP_MIN_MS		5
+// RTC sub second alarm range
+#define		LASERTAG_POWER_STOP_MAX_MS		500
+// no STOP after pc link activity, USART wakes on every start bit otherwise
+#define		LASERTAG_POWER_LINK_MS				2000
+
+// game phase for energy accounting
+#define		LASERTAG_POWER_PHASE_IDLE			0		/*!< no game / game over */
+#define		LASERTAG_POWER_PHASE_ALIVE		1
+#define		LASERTAG_POWER_PHASE_DEAD			2
+#define		LASERTAG_POWER_PHASE_CNT			3
+
+/**		current model [uA], STM32F051 datasheet typ. at 3.3V 48MHz with
+			used peripherals on, board = IR receiver + serial flash standby.
+			Edit for real board measurement.
+*/
+#define		LASERTAG_POWER_RUN_UA					16000
+#define		LASERTAG_POWER_SLEEP_UA				6000
+#define		LASERTAG_POWER_STOP_UA				10
+#define		LASERTAG_POWER_BOARD_UA				400
+
+// residency per game phase
+typedef struct
+{
+	uint32_t Time;						/*!< [ms] total */
+	uint32_t Sleep;						/*!< [ms] in SLEEP */
+	uint32_t Stop;						/*!< [ms] in STOP */
+	uint32_t StopCnt;					/*!< STOP entries */
+} LASERTAG_POWER_StatsTypeDef;
+
+extern LASERTAG_POWER_StatsTypeDef LASERTAG_POWER_Stats[LASERTAG_POWER_PHASE_CNT];
+
+void     LASERTAG_POWER_Init(void);
+void     LASERTAG_POWER_Hold(uint32_t Hold);
+void     LASERTAG_POWER_Release(uint32_t Hold);
+uint8_t  LASERTAG_POWER_Held(uint32_t Hold);
+void     LASERTAG_POWER_Awake(uint32_t Ms);
+void     LASERTAG_POWER_Phase(uint8_t Phase);
+uint32_t LASERTAG_POWER_Current(uint8_t Phase);
+void     LASERTAG_POWER_AlarmCallback(void);
+void     LASERTAG_POWER_LinkWakeupCallback(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LASERTAG_POWER_H */
@@ -0,0 +1,104 @@
+/**
+  ******************************************************************************
+  * File Name          : lasertag_setup.h
+  * Description        : game configuration schema, shared by firmware and pc tool
+  ******************************************************************************
+  * author: Tomas Krejci <info@tomaskrejci.com>
+  *
+  *
+  ******************************************************************************
+  */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __LASERTAG_SETUP_H
+#define __LASERTAG_SETUP_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/**		This header is the only definition of the setup image. The pc tool (pc/setuptool.c)
+			includes it as is - keep it free of firmware headers.
+
+			Binary image = packed little endian struct, stored under setup store
+			key LASERTAG_SETUP_KEY. Schema rules:
+			- new fields are only appended before Crc, Version is incremented
+			- older image (smaller Size) is migrated at boot: defaults overlaid
+			  with the stored prefix
+			- Crc = CRC-16/CCITT (init 0xFFFF) over all bytes before Crc
+*/
+#include <stdint.h>
+
+#define 	 LASERTAG_SETUP_KEY					0x00
+#define 	 LASERTAG_SETUP_MAGIC				0x534C //"LS"
+#define 	 LASERTAG_SETUP_VERSION			1
+
+// damage code from IR packet -> health points
+#define 	 LASERTAG_SETUP_DAMAGE_CNT	16
+
+// IR protocol
+#define 	 LASERTAG_IR_PROTOCOL_MILESTAG	0x00
+#define 	 LASERTAG_IR_PROTOCOL_RAW				0x01
+
+// sound event -> audio slot mapping
+#define 	 LASERTAG_SOUND_SHOT				0
+#define 	 LASERTAG_SOUND_HIT					1
+#define 	 LASERTAG_SOUND_DEAD				2
+#define 	 LASERTAG_SOUND_RESPAWN			3
+#define 	 LASERTAG_SOUND_RELOAD			4
+#define 	 LASERTAG_SOUND_EMPTY				5
+#define 	 LASERTAG_SOUND_START				6
+#define 	 LASERTAG_SOUND_END					7
+#define 	 LASERTAG_SOUND_CNT					8
+#define 	 LASERTAG_SOUND_NONE				0xFF
+
+#if defined(__CC_ARM) || defined(__GNUC__) || defined(_MSC_VER)
+#pragma pack(push, 1)
+#endif
+
+typedef struct
+{
+	/* header - never changes */
+	uint16_t Magic;						/*!< LASERTAG_SETUP_MAGIC */
+	uint8_t  Version;					/*!< LASERTAG_SETUP_VERSION of stored image */
+	uint8_t  Size;						/*!< sizeof stored image incl. Crc */
+
+	/* version 1 */
+	uint8_t  Team;						/*!< team 0..3 */
+	uint8_t  Player;					/*!< player id 0..127 */
+	uint8_t  Health;					/*!< health on respawn */
+	uint8_t  Lives;						/*!< respawn count, 0 = unlimited */
+	uint16_t Ammo;						/*!< magazine size */
+	uint16_t RespawnTime;			/*!< respawn delay [100ms] */
+	uint16_t GameTime;				/*!< game length [s], 0 = unlimited */
+	uint8_t  FriendlyFire;		/*!< TRUE = team hits count */
+	uint8_t  Damage;					/*!< own damage code sent in shot packet */
+	uint8_t  DamageTable[LASERTAG_SETUP_DAMAGE_CNT];
+	uint8_t  IrProtocol;			/*!< LASERTAG_IR_PROTOCOL_x */
+	uint8_t  IrPower;					/*!< IR LED power 0..3 */
+	uint8_t  IrCarrier;				/*!< IR carrier [kHz] */
+	uint8_t  Volume;					/*!< audio volume 0..255 */
+	uint8_t  SoundMap[LASERTAG_SOUND_CNT];	/*!< audio slot per event */
+
+	/* add new fields here, increment LASERTAG_SETUP_VERSION */
+
+	uint16_t Crc;
+} LASERTAG_SetupTypeDef;
+
+#if defined(__CC_ARM) || defined(__GNUC__) || defined(_MSC_VER)
+#pragma pack(pop)
+#endif
+
+
+#ifndef LASERTAG_SETUP_PC
+extern LASERTAG_SetupTypeDef LASERTAG_Setup;
+
+void    LASERTAG_SETUP_Init(void);
+uint8_t LASERTAG_SETUP_Save(void);
+uint8_t LASERTAG_SETUP_Patch(uint8_t Offset, const uint8_t *pData, uint8_t Size);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LASERTAG_SETUP_H */
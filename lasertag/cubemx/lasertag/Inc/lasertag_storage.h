@@ -0,0 +1,71 @@
+/**
+  ******************************************************************************
+  * File Name          : lasertag_storage.h
+  * Description        : flash I/O task - the only task touching the serial flash
+  ******************************************************************************
+  * author: Tomas Krejci <info@tomaskrejci.com>
+  *
+  *
+  ******************************************************************************
+  */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __LASERTAG_STORAGE_H
+#define __LASERTAG_STORAGE_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "main.h"
+#include "cmsis_os.h"
+
+/**		Before the scheduler starts the flash is used directly (setup store).
+			After that every flash access goes through the storage task:
+			- LASERTAG_STORAGE_Read		read block into caller buffer
+			- LASERTAG_STORAGE_Call		run function in storage task context
+			                          (setup store, erase, bench)
+			Caller blocks until the job is done, jobs are served in FIFO order.
+			- LASERTAG_STORAGE_Queue	static job nobody waits for (pc link
+			                          packet from UART ISR, log stream)
+			Reads go through flash_cache.c - hits are copied in caller task,
+			Call jobs invalidate the cache (they may write flash).
+			The FatFs log volume locks itself (_FS_REENTRANT) and may be used
+			from other tasks too, the FTL shares the flash on the SPI bus mutex
+			and does not touch cached (audio) addresses.
+*/
+#define		LASERTAG_STORAGE_QUEUE_LEN		4
+
+// task notification bit of the caller, see NOTIFY_Wait
+#define		LASERTAG_STORAGE_NOTIFY				0x80000000
+
+typedef uint8_t (*LASERTAG_STORAGE_FunctionTypeDef)(void *pArg);
+
+typedef struct
+{
+	LASERTAG_STORAGE_FunctionTypeDef Function;	/*!< NULL = read job */
+	void					*pArg;
+	uint32_t			Address;
+	uint8_t				*pData;
+	uint32_t			Size;
+	TaskHandle_t	Caller;							/*!< NULL = nobody waits */
+	uint8_t				Result;
+} LASERTAG_STORAGE_JobTypeDef;
+
+// static job for LASERTAG_STORAGE_Queue
+#define		LASERTAG_STORAGE_JOB(Function)		{ (Function), NULL, 0, NULL, 0, NULL, 0 }
+
+extern osThreadId storageTaskHandle;
+
+void    LASERTAG_STORAGE_Init(void);
+void    LASERTAG_STORAGE_Task(void const *argument);
+uint8_t LASERTAG_STORAGE_Read(uint32_t Address, uint8_t *pData, uint32_t Size);
+uint8_t LASERTAG_STORAGE_Call(LASERTAG_STORAGE_FunctionTypeDef Function, void *pArg);
+uint8_t LASERTAG_STORAGE_Queue(LASERTAG_STORAGE_JobTypeDef *pJob);
+uint8_t LASERTAG_STORAGE_QueueFromISR(LASERTAG_STORAGE_JobTypeDef *pJob, BaseType_t *pWoken);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LASERTAG_STORAGE_H */
@@ -0,0 +1,116 @@
+/**
+  ******************************************************************************
+  * File Name          : lasertag_trace.h
+  * Description        : RAM trace ring for ISR and task events
+  ******************************************************************************
+  * author: Tomas Krejci <info@tomaskrejci.com>
+  *
+  *
+  ******************************************************************************
+  */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __LASERTAG_TRACE_H
+#define __LASERTAG_TRACE_H
+
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/**		Record = <time 4B> <event 1B> <arg 3B>, time = CYCLE_COUNTER.
+			One record costs ~15 cycles (PRIMASK section, no call), the ring
+			keeps last LASERTAG_TRACE_SIZE records. Classes are switched by mask
+			(pc link SET), 0 = trace frozen for download.
+
+			Shared with pc decoder (pc/trace2json.c) - define LASERTAG_TRACE_PC
+			there, firmware part is excluded. Records are compiled out unless
+			the build sets LASERTAG_TRACE (lasertag_config.h).
+			LASERTAG_TRACE_HOLD_HIT in the mask freezes the ring after a hit
+			slower than all before it, the worst hit response of a game stays
+			for download (hit done record = firmware latency, pc/trace2json.c).
+*/
+#include <stdint.h>
+
+#define		LASERTAG_TRACE_SIZE					32		// power of 2
+#define		LASERTAG_TRACE_REC_SIZE			8
+
+// class mask
+#define		LASERTAG_TRACE_ISR					0x01	/*!< peripheral ISR enter/exit */
+#define		LASERTAG_TRACE_TICK					0x02	/*!< SysTick, TIM6 - 1kHz each */
+#define		LASERTAG_TRACE_AUDIO				0x04	/*!< TIM15 - 8kHz */
+#define		LASERTAG_TRACE_TASK					0x08	/*!< task switch */
+#define		LASERTAG_TRACE_APP					0x10	/*!< game, storage, power events */
+#define		LASERTAG_TRACE_HOLD_HIT			0x80	/*!< freeze on a new worst hit response */
+#define		LASERTAG_TRACE_DEFAULT			(LASERTAG_TRACE_ISR | LASERTAG_TRACE_TASK | LASERTAG_TRACE_APP)
+
+// event, arg
+#define		LASERTAG_TRACE_ISR_ENTER		0x01	/*!< IRQn */
+#define		LASERTAG_TRACE_ISR_EXIT			0x02	/*!< IRQn */
+#define		LASERTAG_TRACE_TASK_IN			0x03	/*!< first 3 chars of task name */
+#define		LASERTAG_TRACE_HIT					0x10	/*!< IR packet */
+#define		LASERTAG_TRACE_SHOT					0x11	/*!< IR packet */
+#define		LASERTAG_TRACE_STORAGE_BEGIN	0x12	/*!< read size, 0 = function */
+#define		LASERTAG_TRACE_STORAGE_END	0x13	/*!< result */
+#define		LASERTAG_TRACE_STOP_ENTER		0x14	/*!< expected idle [ms] */
+#define		LASERTAG_TRACE_STOP_EXIT		0x15	/*!< slept [ms] */
+#define		LASERTAG_TRACE_HIT_DONE			0x16	/*!< response from edge time stamp [cycles] */
+
+// SysTick has negative IRQn
+#define		LASERTAG_TRACE_IRQ_SYSTICK	0xFF
+
+#ifndef LASERTAG_TRACE_PC
+#include "stm32f0xx_hal.h"
+#include "common.h"
+
+#if LASERTAG_TRACE
+typedef struct
+{
+	uint32_t Time;
+	uint32_t Event;						/*!< event << 24 | arg */
+} LASERTAG_TRACE_RecordTypeDef;
+
+extern LASERTAG_TRACE_RecordTypeDef LASERTAG_TraceRing[LASERTAG_TRACE_SIZE];
+extern uint32_t LASERTAG_TraceIndex;
+extern volatile uint32_t LASERTAG_TraceMask;
+
+__STATIC_INLINE void LASERTAG_TRACE_Put(uint32_t Class, uint32_t Event, uint32_t Arg)
+{
+	LASERTAG_TRACE_RecordTypeDef *pRec;
+	uint32_t Primask;
+	
+	if ((LASERTAG_TraceMask & Class) == 0)
+		return;
+	
+	Primask = __get_PRIMASK();
+	__disable_irq();
+	pRec = &LASERTAG_TraceRing[LASERTAG_TraceIndex++ & (LASERTAG_TRACE_SIZE - 1)];
+	pRec->Time = CYCLE_COUNTER();
+	pRec->Event = (Event << 24) | (Arg & 0x00FFFFFF);
+	__set_PRIMASK(Primask);
+}
+
+/**		Freeze the ring (mask 0) when the mask has Hold set
+*/
+__STATIC_INLINE void LASERTAG_TRACE_Hold(uint32_t Hold)
+{
+	if (LASERTAG_TraceMask & Hold)
+		LASERTAG_TraceMask = 0;
+}
+
+#define		LASERTAG_TRACE_ENTER(Class, IRQn)		LASERTAG_TRACE_Put((Class), LASERTAG_TRACE_ISR_ENTER, (uint8_t)(IRQn))
+#define		LASERTAG_TRACE_EXIT(Class, IRQn)		LASERTAG_TRACE_Put((Class), LASERTAG_TRACE_ISR_EXIT, (uint8_t)(IRQn))
+
+void     LASERTAG_TRACE_TaskIn(const char *pName);
+uint32_t LASERTAG_TRACE_Read(uint8_t Page, uint8_t *pData);
+#else
+#define		LASERTAG_TRACE_Put(Class, Event, Arg)
+#define		LASERTAG_TRACE_Hold(Hold)
+#define		LASERTAG_TRACE_ENTER(Class, IRQn)
+#define		LASERTAG_TRACE_EXIT(Class, IRQn)
+#endif
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __LASERTAG_TRACE_H */
@@ -0,0 +1,36 @@
+/**
+  ******************************************************************************
+  * File Name          : mem_fast.h
+  * Description        : copy, fill and compare tuned for Cortex-M0
+  ******************************************************************************
+  * author: Tomas Krejci <info@tomaskrejci.com>
+  *
+  *
+  ******************************************************************************
+  */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __mem_fast_H
+#define __mem_fast_H
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include <stdint.h>
+
+/**		Cortex-M0 faults on unaligned word access, microlib string functions
+			go byte by byte. These routines align the destination with byte
+			moves, run the middle in 16 byte blocks (LDM/STM of 4 registers)
+			and finish with bytes. A source with other alignment than the
+			destination is read as aligned words and shifted together.
+
+			Used by FatFs (ffconf.h) for sector buffer moves.
+*/
+void MEM_FAST_Copy(void *pDst, const void *pSrc, uint32_t Size);
+void MEM_FAST_Set(void *pDst, int Value, uint32_t Size);
+int  MEM_FAST_Compare(const void *pData1, const void *pData2, uint32_t Size);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /*__mem_fast_H */
@@ -51,6 +51,13 @@
 #define SWCLK_Pin GPIO_PIN_14
 #define SWCLK_GPIO_Port GPIOA
 /* USER CODE BEGIN Private defines */
+// pins not in lasertag.ioc, configured by LASERTAG_GPIO_Init (gpio.c)
+#define B1_EXTI_IRQn EXTI0_1_IRQn
+#define IR_RX_Pin GPIO_PIN_1
+#define IR_RX_GPIO_Port GPIOA
+#define IR_RX_EXTI_IRQn EXTI0_1_IRQn
+#define AUDIO_OUT_Pin GPIO_PIN_4
+#define AUDIO_OUT_GPIO_Port GPIOA
 
 /* USER CODE END Private defines */
 
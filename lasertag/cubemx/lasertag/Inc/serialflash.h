@@ -19,6 +19,7 @@
 
 /* Includes ------------------------------------------------------------------*/
 #include "main.h"
+#include "spi_bus.h"
 
 /** @addtogroup BSP
   * @{
@@ -67,28 +68,14 @@ uint8_t  BSP_SERIAL_FLASH_WriteData(uint32_t uwStartAddress, uint8_t* pData, uin
 uint8_t  BSP_SERIAL_FLASH_ReadData( uint32_t uwStartAddress, uint8_t* pData, uint32_t uwDataSize);
 uint32_t BSP_SERIAL_FLASH_ReadID(void);
 
+extern const SPI_BUS_DeviceTypeDef FLASH_SPI_Device;
 
+/* Link function, raw byte on the flash SPI bus (bus acquired by caller) */
+uint8_t  FLASH_SPI_IO_WriteByte(uint8_t Data);
+uint8_t  FLASH_SPI_IO_ReadByte(void);
 
-/*##################### SPIx ###################################*/
-#define EVAL_SPIx                               SPI1
-#define EVAL_SPIx_CLK_ENABLE()                  __HAL_RCC_SPI1_CLK_ENABLE()
 
-#define EVAL_SPIx_SCK_GPIO_PORT                 GPIOA             /* PA.05*/
-#define EVAL_SPIx_SCK_PIN                       GPIO_PIN_5
-#define EVAL_SPIx_SCK_GPIO_CLK_ENABLE()         __HAL_RCC_GPIOA_CLK_ENABLE()
-#define EVAL_SPIx_SCK_GPIO_CLK_DISABLE()        __HAL_RCC_GPIOA_CLK_DISABLE()
 
-#define EVAL_SPIx_MISO_MOSI_GPIO_PORT           GPIOA
-#define EVAL_SPIx_MISO_MOSI_GPIO_CLK_ENABLE()   __HAL_RCC_GPIOA_CLK_ENABLE()
-#define EVAL_SPIx_MISO_MOSI_GPIO_CLK_DISABLE()  __HAL_RCC_GPIOA_CLK_DISABLE()
-#define EVAL_SPIx_MISO_PIN                      GPIO_PIN_6       /* PA.06*/
-#define EVAL_SPIx_MOSI_PIN                      GPIO_PIN_7       /* PA.07*/
-/* Maximum Timeout values for flags waiting loops. These timeouts are not based
-   on accurate values, they just guarantee that the application will not remain
-   stuck if the SPI communication is corrupted.
-   You may modify these timeout values depending on CPU frequency and application
-   conditions (interrupts routines ...). */   
-#define EVAL_SPIx_TIMEOUT_MAX                   1000
 
 /**
   * @}
@@ -102,8 +89,8 @@ uint32_t BSP_SERIAL_FLASH_ReadID(void);
 /**
   * @brief  FLASH SPI Chip Select macro definition 
   */
-#define FLASH_SPI_CS_LOW()       HAL_GPIO_WritePin(FLASH_SPI_CS_GPIO_PORT, FLASH_SPI_CS_PIN, GPIO_PIN_RESET)
-#define FLASH_SPI_CS_HIGH()      HAL_GPIO_WritePin(FLASH_SPI_CS_GPIO_PORT, FLASH_SPI_CS_PIN, GPIO_PIN_SET)
+#define FLASH_SPI_CS_LOW()       GPIO_LOW(FLASH_SPI_CS_GPIO_PORT, FLASH_SPI_CS_PIN)
+#define FLASH_SPI_CS_HIGH()      GPIO_HIGH(FLASH_SPI_CS_GPIO_PORT, FLASH_SPI_CS_PIN)
 
 /**
   * @brief  FLASH SPI Control Interface pins
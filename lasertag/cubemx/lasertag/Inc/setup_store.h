@@ -0,0 +1,49 @@
+/**
+  ******************************************************************************
+  * File Name          : setup_store.h
+  * Description        : wear-leveled key/value store in the setup flash region
+  ******************************************************************************
+  * author: Tomas Krejci <info@tomaskrejci.com>
+  *
+  *
+  ******************************************************************************
+  */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __setup_store_H
+#define __setup_store_H
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f0xx_hal.h"
+
+/**		setup region layout (LASERTAG_ADR_SETUP, 2x 4kB sector)
+
+			sector:	<header 8B>	<record>	<record>	...	<0xFF erased>
+			header:	<magic 4B>	<sequence 2B>	<crc16 2B>
+			record:	<key>	<size>	<crc16 2B>	<data 0..SETUP_STORE_VALUE_MAX>
+
+			Update = append new record (one page program), newest record of key wins.
+			Full sector = compaction of newest records into alternate sector,
+			alternate header written last -> power fail keeps old sector valid.
+*/
+#define		SETUP_STORE_SECTOR_SIZE		0x1000 //4kB erase sector
+#define		SETUP_STORE_KEYS					32		 //key 0..31
+#define		SETUP_STORE_VALUE_MAX			252		 //record <= one 256B page
+
+// return value
+#define		SETUP_STORE_OK						0x00
+#define		SETUP_STORE_ERROR					0x01
+#define		SETUP_STORE_NOT_FOUND			0x02
+
+
+uint8_t SETUP_STORE_Init(void);
+uint8_t SETUP_STORE_Read(uint8_t Key, uint8_t *pData, uint8_t *pSize);
+uint8_t SETUP_STORE_Write(uint8_t Key, const uint8_t *pData, uint8_t Size);
+uint8_t SETUP_STORE_Compact(void);
+
+#ifdef __cplusplus
+}
+#endif
+#endif /*__setup_store_H */
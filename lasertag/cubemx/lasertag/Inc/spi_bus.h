@@ -0,0 +1,80 @@
+/**
+  ******************************************************************************
+  * File Name          : spi_bus.h
+  * Description        : SPI1 bus owner - arbitration, per device CS and clock
+  ******************************************************************************
+  * author: Tomas Krejci <info@tomaskrejci.com>
+  *
+  *
+  ******************************************************************************
+  */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __spi_bus_H
+#define __spi_bus_H
+#ifdef __cplusplus
+ extern "C" {
+#endif
+
+/* Includes ------------------------------------------------------------------*/
+#include "stm32f0xx_hal.h"
+#include "common.h"
+
+/**		hspi1 (spi.c, MX_SPI1_Init) is the only SPI1 handle, drivers keep a
+			device descriptor and talk to the bus through this layer.
+
+			SPI_BUS_Acquire(&Device);		// wait for bus, set clock/mode of Device
+			SPI_BUS_Select(&Device);		// CS low
+			SPI_BUS_Transfer(...);			// any number of bytes/blocks
+			SPI_BUS_Deselect(&Device);	// CS high
+			...													// more transactions, no re-arbitration
+			SPI_BUS_Release();
+
+			Waiting clients are served by task priority (mutex wait list, with
+			priority inheritance). Re-acquire by the last device skips the CR1
+			reload. Before the scheduler runs there is no locking.
+
+			SPI_BUS_ReadBlock of SPI_BUS_DMA_MIN bytes and more runs on DMA1
+			channel 2 (RX) / 3 (TX, dummy byte), the caller blocks until the
+			last byte is in, LASERTAG_POWER_HOLD_SPI keeps the clocks meanwhile.
+			A DMA transfer error returns HAL_ERROR. Before the scheduler runs it
+			stays byte by byte.
+*/
+typedef struct
+{
+	GPIO_TypeDef	*CsPort;
+	uint16_t			CsPin;
+	uint16_t			Config;			/*!< CR1 bits: SPI_BAUDRATEPRESCALER_x | SPI_POLARITY_x | SPI_PHASE_x */
+} SPI_BUS_DeviceTypeDef;
+
+#define		SPI_BUS_CONFIG_MASK		(SPI_CR1_BR | SPI_CR1_CPOL | SPI_CR1_CPHA)
+#define		SPI_BUS_DMA_MIN				64
+// task notification bit of the DMA reader, see NOTIFY_Wait
+#define		SPI_BUS_NOTIFY				0x40000000
+
+extern SPI_HandleTypeDef hspi1;
+
+void SPI_BUS_Init(void);
+void SPI_BUS_Register(const SPI_BUS_DeviceTypeDef *pDevice);
+void SPI_BUS_Acquire(const SPI_BUS_DeviceTypeDef *pDevice);
+void SPI_BUS_Release(void);
+void SPI_BUS_WriteBlock(const uint8_t *pData, uint32_t Size);
+HAL_StatusTypeDef SPI_BUS_ReadBlock(uint8_t *pData, uint32_t Size, uint8_t Dummy);
+void SPI_BUS_DMA_IRQHandler(void);
+
+#define		SPI_BUS_Select(pDevice)			GPIO_LOW((pDevice)->CsPort, (pDevice)->CsPin)
+#define		SPI_BUS_Deselect(pDevice)		GPIO_HIGH((pDevice)->CsPort, (pDevice)->CsPin)
+
+/**		One byte, direct register access (FRXTH set in SPI_BUS_Init, 8 bit DR)
+*/
+static __INLINE uint8_t SPI_BUS_Transfer(uint8_t Value)
+{
+	*(__IO uint8_t *)&SPI1->DR = Value;
+	while ((SPI1->SR & SPI_SR_RXNE) == 0);
+	
+	return *(__IO uint8_t *)&SPI1->DR;
+}
+
+#ifdef __cplusplus
+}
+#endif
+#endif /*__spi_bus_H */
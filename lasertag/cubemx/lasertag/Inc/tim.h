@@ -49,6 +49,9 @@ extern TIM_HandleTypeDef htim16;
 extern TIM_HandleTypeDef htim17;
 
 /* USER CODE BEGIN Private defines */
+// timers not in lasertag.ioc, init functions in tim.c USER CODE
+extern TIM_HandleTypeDef htim2;
+extern TIM_HandleTypeDef htim15;
 
 /* USER CODE END Private defines */
 
@@ -56,6 +59,8 @@ void MX_TIM16_Init(void);
 void MX_TIM17_Init(void);
 
 /* USER CODE BEGIN Prototypes */
+void MX_TIM2_Init(void);
+void MX_TIM15_Init(void);
 
 /* USER CODE END Prototypes */
 
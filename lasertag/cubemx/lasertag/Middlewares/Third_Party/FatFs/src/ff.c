@@ -153,6 +153,12 @@
 #define	ABORT(fs, res)		{ fp->err = (BYTE)(res); LEAVE_FF(fs, res); }
 
 
+/* Directory name hash cache */
+#if _FS_DIRHASH && _USE_LFN
+#error _FS_DIRHASH cannot be used at LFN configuration
+#endif
+
+
 /* Definitions of sector size */
 #if (_MAX_SS < _MIN_SS) || (_MAX_SS != 512 && _MAX_SS != 1024 && _MAX_SS != 2048 && _MAX_SS != 4096) || (_MIN_SS != 512 && _MIN_SS != 1024 && _MIN_SS != 2048 && _MIN_SS != 4096)
 #error Wrong sector size configuration
@@ -575,6 +581,9 @@ static void gen_numname (BYTE* dst, const BYTE* src, const WCHAR* lfn, UINT seq)
 /* String functions                                                      */
 /*-----------------------------------------------------------------------*/
 
+#ifdef _FS_MEMCPY
+#define mem_cpy(dst,src,cnt)	_FS_MEMCPY(dst,src,cnt)	/* Platform copy (ffconf.h) */
+#else
 /* Copy memory to memory */
 static
 void mem_cpy (void* dst, const void* src, UINT cnt) {
@@ -591,7 +600,11 @@ void mem_cpy (void* dst, const void* src, UINT cnt) {
 	while (cnt--)
 		*d++ = *s++;
 }
+#endif
 
+#ifdef _FS_MEMSET
+#define mem_set(dst,val,cnt)	_FS_MEMSET(dst,val,cnt)	/* Platform fill (ffconf.h) */
+#else
 /* Fill memory */
 static
 void mem_set (void* dst, int val, UINT cnt) {
@@ -600,7 +613,11 @@ void mem_set (void* dst, int val, UINT cnt) {
 	while (cnt--)
 		*d++ = (BYTE)val;
 }
+#endif
 
+#ifdef _FS_MEMCMP
+#define mem_cmp(dst,src,cnt)	_FS_MEMCMP(dst,src,cnt)	/* Platform compare (ffconf.h) */
+#else
 /* Compare memory to memory */
 static
 int mem_cmp (const void* dst, const void* src, UINT cnt) {
@@ -610,6 +627,7 @@ int mem_cmp (const void* dst, const void* src, UINT cnt) {
 	while (cnt-- && (r = *d++ - *s++) == 0) ;
 	return r;
 }
+#endif
 
 /* Check if chr is contained in the string */
 static
@@ -769,35 +787,185 @@ void clear_lock (	/* Clear lock entries of the volume */
 /* Move/Flush disk access window in the file system object               */
 /*-----------------------------------------------------------------------*/
 #if !_FS_READONLY
+static
+FRESULT write_sect (	/* Write a sector, FAT sector is reflected to all FAT copies */
+	FATFS* fs,			/* File system object */
+	const BYTE* buf,	/* Sector data */
+	DWORD sect			/* Sector# */
+)
+{
+	UINT nf;
+
+
+	if (disk_write(fs->drv, buf, sect, 1) != RES_OK) return FR_DISK_ERR;
+	if (sect - fs->fatbase < fs->fsize) {		/* Is it in the FAT area? */
+		for (nf = fs->n_fats; nf >= 2; nf--) {	/* Reflect the change to all FAT copies */
+			sect += fs->fsize;
+			disk_write(fs->drv, buf, sect, 1);
+		}
+	}
+	return FR_OK;
+}
+
+
 static
 FRESULT sync_window (
 	FATFS* fs		/* File system object */
 )
 {
-	DWORD wsect;
-	UINT nf;
 	FRESULT res = FR_OK;
 
 
 	if (fs->wflag) {	/* Write back the sector if it is dirty */
-		wsect = fs->winsect;	/* Current sector number */
-		if (disk_write(fs->drv, fs->win.d8, wsect, 1) != RES_OK) {
-			res = FR_DISK_ERR;
-		} else {
-			fs->wflag = 0;
-			if (wsect - fs->fatbase < fs->fsize) {		/* Is it in the FAT area? */
-				for (nf = fs->n_fats; nf >= 2; nf--) {	/* Reflect the change to all FAT copies */
-					wsect += fs->fsize;
-					disk_write(fs->drv, fs->win.d8, wsect, 1);
-				}
-			}
-		}
+		res = write_sect(fs, fs->win.d8, fs->winsect);
+		if (res == FR_OK) fs->wflag = 0;
 	}
 	return res;
 }
 #endif
 
 
+#if _FS_WINCACHE && !_FS_READONLY
+/* Sectors leaving the window are parked in the cache (dirty ones stay dirty)
+/  and moved back on the next access, a sector is either in the window or in
+/  the cache. FAT sectors (first FAT) and directory/data sectors have separate
+/  slots. Paths that access data sectors directly keep the cache coherent with
+/  wc_drop() (sector is overwritten) and wc_merge() (sector is read). */
+
+static
+UINT wc_range (	/* First cache slot of the sector class, *end:Behind the last one (same: not cached) */
+	FATFS* fs,	/* File system object */
+	DWORD sect,	/* Sector# */
+	UINT* end
+)
+{
+	if (sect - fs->fatbase < fs->fsize) {	/* FAT slots */
+		*end = _FS_WINCACHE_FAT;
+		return 0;
+	}
+	if (sect >= ((fs->fs_type == FS_FAT32) ? fs->database : fs->dirbase)) {	/* Directory and data slots */
+		*end = _FS_WINCACHE;
+		return _FS_WINCACHE_FAT;
+	}
+	*end = 0;
+	return 0;
+}
+
+
+static
+void wc_invalidate (
+	FATFS* fs	/* File system object */
+)
+{
+	UINT i;
+
+
+	for (i = 0; i < _FS_WINCACHE; i++) fs->wc_sect[i] = 0xFFFFFFFF;
+}
+
+
+static
+FRESULT wc_park (	/* Move the window sector into the cache, LRU slot of its class is evicted */
+	FATFS* fs	/* File system object */
+)
+{
+	UINT i, v, end;
+	FRESULT res;
+
+
+	i = wc_range(fs, fs->winsect, &end);
+	if (i == end) return sync_window(fs);	/* Not cached, write back */
+
+	for (v = i; i < end; i++) {				/* Empty or least recently used slot */
+		if (fs->wc_sect[i] == 0xFFFFFFFF) { v = i; break; }
+		if ((WORD)(fs->wc_tick - fs->wc_age[i]) > (WORD)(fs->wc_tick - fs->wc_age[v])) v = i;
+	}
+	if (fs->wc_sect[v] != 0xFFFFFFFF && (fs->wc_flag[v] & 1)) {	/* Write back dirty victim */
+		res = write_sect(fs, fs->wc_buf[v].d8, fs->wc_sect[v]);
+		if (res != FR_OK) return res;
+	}
+	mem_cpy(fs->wc_buf[v].d8, fs->win.d8, SS(fs));
+	fs->wc_sect[v] = fs->winsect;
+	fs->wc_flag[v] = fs->wflag;
+	fs->wc_age[v] = ++fs->wc_tick;
+	fs->wflag = 0;
+
+	return FR_OK;
+}
+
+
+static
+int wc_take (	/* 1:Sector moved from the cache into the window, 0:Not cached */
+	FATFS* fs,	/* File system object */
+	DWORD sect	/* Sector# */
+)
+{
+	UINT i, end;
+
+
+	for (i = wc_range(fs, sect, &end); i < end; i++) {
+		if (fs->wc_sect[i] == sect) {
+			mem_cpy(fs->win.d8, fs->wc_buf[i].d8, SS(fs));
+			fs->wflag = fs->wc_flag[i];
+			fs->wc_sect[i] = 0xFFFFFFFF;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+
+static
+void wc_drop (	/* Forget cached sectors, they are going to be overwritten */
+	FATFS* fs,	/* File system object */
+	DWORD sect,	/* First sector# */
+	UINT cnt	/* Number of sectors */
+)
+{
+	UINT i;
+
+
+	for (i = _FS_WINCACHE_FAT; i < _FS_WINCACHE; i++) {
+		if (fs->wc_sect[i] - sect < cnt) fs->wc_sect[i] = 0xFFFFFFFF;
+	}
+}
+
+
+static
+void wc_merge (	/* Replace sectors read directly from the disk with dirty cached ones */
+	FATFS* fs,	/* File system object */
+	BYTE* buf,	/* Data read from the disk */
+	DWORD sect,	/* First sector# */
+	UINT cnt	/* Number of sectors */
+)
+{
+	UINT i;
+
+
+	for (i = _FS_WINCACHE_FAT; i < _FS_WINCACHE; i++) {
+		if ((fs->wc_flag[i] & 1) && fs->wc_sect[i] - sect < cnt)
+			mem_cpy(buf + (fs->wc_sect[i] - sect) * SS(fs), fs->wc_buf[i].d8, SS(fs));
+	}
+}
+
+
+static
+FRESULT wc_flush (	/* Write back dirty cached sectors */
+	FATFS* fs,	/* File system object */
+	UINT i		/* First slot (0:All, _FS_WINCACHE_FAT:Directory and data only) */
+)
+{
+	for (; i < _FS_WINCACHE; i++) {
+		if (fs->wc_sect[i] != 0xFFFFFFFF && (fs->wc_flag[i] & 1)) {
+			if (write_sect(fs, fs->wc_buf[i].d8, fs->wc_sect[i]) != FR_OK) return FR_DISK_ERR;
+			fs->wc_flag[i] = 0;
+		}
+	}
+	return FR_OK;
+}
+#endif
+
+
 static
 FRESULT move_window (
 	FATFS* fs,		/* File system object */
@@ -809,7 +977,15 @@ FRESULT move_window (
 
 	if (sector != fs->winsect) {	/* Window offset changed? */
 #if !_FS_READONLY
+#if _FS_WINCACHE
+		res = wc_park(fs);			/* Park or write-back current sector */
+		if (res == FR_OK && wc_take(fs, sector)) {
+			fs->winsect = sector;	/* Cache hit, no disk access */
+			return FR_OK;
+		}
+#else
 		res = sync_window(fs);		/* Write-back changes */
+#endif
 #endif
 		if (res == FR_OK) {			/* Fill sector window with new data */
 			if (disk_read(fs->drv, fs->win.d8, sector, 1) != RES_OK) {
@@ -838,6 +1014,9 @@ FRESULT sync_fs (	/* FR_OK: successful, FR_DISK_ERR: failed */
 
 
 	res = sync_window(fs);
+#if _FS_WINCACHE
+	if (res == FR_OK) res = wc_flush(fs, 0);
+#endif
 	if (res == FR_OK) {
 		/* Update FSINFO sector if needed */
 		if (fs->fs_type == FS_FAT32 && fs->fsi_flag == 1) {
@@ -860,6 +1039,28 @@ FRESULT sync_fs (	/* FR_OK: successful, FR_DISK_ERR: failed */
 
 	return res;
 }
+
+
+#if _FS_LAZYSYNC
+static
+FRESULT sync_data (	/* FR_OK: successful, FR_DISK_ERR: failed */
+	FATFS* fs		/* File system object */
+)
+{
+	FRESULT res = FR_OK;
+
+
+	if (fs->winsect - fs->fatbase >= fs->fsize)	/* FAT sector in the window waits for the commit (or its eviction) */
+		res = sync_window(fs);
+#if _FS_WINCACHE
+	if (res == FR_OK) res = wc_flush(fs, _FS_WINCACHE_FAT);
+#endif
+	if (res == FR_OK && disk_ioctl(fs->drv, CTRL_SYNC, 0) != RES_OK)
+		res = FR_DISK_ERR;
+
+	return res;
+}
+#endif
 #endif
 
 
@@ -1140,6 +1341,40 @@ DWORD clmt_clust (	/* <2:Error, >=2:Cluster number */
 	}
 	return cl + *tbl;	/* Return the cluster number */
 }
+
+
+static
+FRESULT create_clmt (	/* FR_OK, FR_NOT_ENOUGH_CORE:Table is too small, FR_INT_ERR/FR_DISK_ERR:Broken chain */
+	FIL* fp			/* Pointer to the file object, fp->cltbl[0] is the table size */
+)
+{
+	DWORD cl, pcl, ncl, tcl, tlen, ulen, *tbl;
+
+
+	tbl = fp->cltbl;
+	tlen = *tbl++; ulen = 2;	/* Given table size and required table size */
+	cl = fp->sclust;			/* Top of the chain */
+	if (cl) {
+		do {
+			/* Get a fragment */
+			tcl = cl; ncl = 0; ulen += 2;	/* Top, length and used items */
+			do {
+				pcl = cl; ncl++;
+				cl = get_fat(fp->fs, cl);
+				if (cl <= 1) return FR_INT_ERR;
+				if (cl == 0xFFFFFFFF) return FR_DISK_ERR;
+			} while (cl == pcl + 1);
+			if (ulen <= tlen) {		/* Store the length and top of the fragment */
+				*tbl++ = ncl; *tbl++ = tcl;
+			}
+		} while (cl < fp->fs->n_fatent);	/* Repeat until end of chain */
+	}
+	*fp->cltbl = ulen;	/* Number of items used */
+	if (ulen > tlen) return FR_NOT_ENOUGH_CORE;	/* Given table size is smaller than required */
+	*tbl = 0;			/* Terminate table */
+
+	return FR_OK;
+}
 #endif	/* _USE_FASTSEEK */
 
 
@@ -1237,6 +1472,9 @@ FRESULT dir_next (	/* FR_OK:Succeeded, FR_NO_FILE:End of table, FR_DENIED:Could
 					if (sync_window(dp->fs)) return FR_DISK_ERR;/* Flush disk access window */
 					mem_set(dp->fs->win.d8, 0, SS(dp->fs));		/* Clear window buffer */
 					dp->fs->winsect = clust2sect(dp->fs, clst);	/* Cluster start sector */
+#if _FS_WINCACHE
+					wc_drop(dp->fs, dp->fs->winsect, dp->fs->csize);
+#endif
 					for (c = 0; c < dp->fs->csize; c++) {		/* Fill the new cluster with 0 */
 						dp->fs->wflag = 1;
 						if (sync_window(dp->fs)) return FR_DISK_ERR;
@@ -1520,6 +1758,73 @@ BYTE sum_sfn (
 
 
 
+/*-----------------------------------------------------------------------*/
+/* Directory handling - Name hash cache                                  */
+/*-----------------------------------------------------------------------*/
+#if _FS_DIRHASH
+static
+WORD dh_hash (		/* Returns hash of the directory and the name */
+	DIR* dp			/* Directory object with the name */
+)
+{
+	DWORD h = dp->sclust;
+	UINT i;
+
+
+	for (i = 0; i < 11; i++)
+		h = h * 31 + dp->fn[i];
+
+	return (WORD)(h ^ h >> 16);
+}
+
+
+static
+void dh_put (
+	DIR* dp,		/* Directory object pointing the entry of its name */
+	WORD h			/* Hash of the name */
+)
+{
+	FATFS *fs = dp->fs;
+	UINT i, n = _FS_DIRHASH;
+
+
+	for (i = 0; i < _FS_DIRHASH; i++) {
+		if (fs->dh_idx[i] == 0xFFFF) {			/* Remember a free slot */
+			if (n == _FS_DIRHASH) n = i;
+		} else if (fs->dh_hash[i] == h && fs->dh_clust[i] == dp->sclust) {
+			n = i; break;						/* Same name, replace it */
+		}
+	}
+	if (n == _FS_DIRHASH) {						/* Full, replace in turn */
+		n = fs->dh_next;
+		fs->dh_next = (BYTE)((n + 1) % _FS_DIRHASH);
+	}
+	fs->dh_hash[n] = h;
+	fs->dh_idx[n] = dp->index;
+	fs->dh_clust[n] = dp->sclust;
+}
+
+
+#if !_FS_READONLY && !_FS_MINIMIZE
+static
+void dh_drop (
+	DIR* dp			/* Directory object pointing the entry being removed */
+)
+{
+	UINT i;
+
+
+	for (i = 0; i < _FS_DIRHASH; i++) {	/* The name in dp may not be the one removed (f_rename) */
+		if (dp->fs->dh_idx[i] == dp->index && dp->fs->dh_clust[i] == dp->sclust)
+			dp->fs->dh_idx[i] = 0xFFFF;
+	}
+}
+#endif
+#endif
+
+
+
+
 /*-----------------------------------------------------------------------*/
 /* Directory handling - Find an object in the directory                  */
 /*-----------------------------------------------------------------------*/
@@ -1534,6 +1839,23 @@ FRESULT dir_find (
 #if _USE_LFN
 	BYTE a, ord, sum;
 #endif
+#if _FS_DIRHASH
+	WORD h;
+	UINT i;
+
+
+	h = dh_hash(dp);
+	for (i = 0; i < _FS_DIRHASH; i++) {		/* Try the cached entries of the name */
+		if (dp->fs->dh_idx[i] == 0xFFFF || dp->fs->dh_hash[i] != h || dp->fs->dh_clust[i] != dp->sclust)
+			continue;
+		if (dir_sdi(dp, dp->fs->dh_idx[i]) != FR_OK) continue;
+		res = move_window(dp->fs, dp->sect);
+		if (res != FR_OK) return res;
+		dir = dp->dir;
+		if (!(dir[DIR_Attr] & AM_VOL) && !mem_cmp(dir, dp->fn, 11))	/* Is it still the name? */
+			return FR_OK;
+	}
+#endif
 
 	res = dir_sdi(dp, 0);			/* Rewind directory object */
 	if (res != FR_OK) return res;
@@ -1575,6 +1897,10 @@ FRESULT dir_find (
 		res = dir_next(dp, 0);		/* Next entry */
 	} while (res == FR_OK);
 
+#if _FS_DIRHASH
+	if (res == FR_OK) dh_put(dp, h);	/* Remember the found entry */
+#endif
+
 	return res;
 }
 
@@ -1708,6 +2034,9 @@ FRESULT dir_register (	/* FR_OK:Successful, FR_DENIED:No free entry or too many
 			dp->dir[DIR_NTres] = dp->fn[NSFLAG] & (NS_BODY | NS_EXT);	/* Put NT flag */
 #endif
 			dp->fs->wflag = 1;
+#if _FS_DIRHASH
+			dh_put(dp, dh_hash(dp));	/* The new entry is looked up next */
+#endif
 		}
 	}
 
@@ -1730,7 +2059,12 @@ FRESULT dir_remove (	/* FR_OK: Successful, FR_DISK_ERR: A disk error */
 	FRESULT res;
 #if _USE_LFN	/* LFN configuration */
 	UINT i;
+#endif
 
+#if _FS_DIRHASH
+	dh_drop(dp);
+#endif
+#if _USE_LFN
 	i = dp->index;	/* SFN index */
 	res = dir_sdi(dp, (dp->lfn_idx == 0xFFFF) ? i : dp->lfn_idx);	/* Goto the SFN or top of the LFN entries */
 	if (res == FR_OK) {
@@ -2251,6 +2585,9 @@ BYTE check_fs (	/* 0:FAT boor sector, 1:Valid boor sector but not FAT, 2:Not a b
 )
 {
 	fs->wflag = 0; fs->winsect = 0xFFFFFFFF;	/* Invaidate window */
+#if _FS_WINCACHE && !_FS_READONLY
+	wc_invalidate(fs);							/* Cached sectors belong to the old volume */
+#endif
 	if (move_window(fs, sect) != FR_OK)			/* Load boot record */
 		return 3;
 
@@ -2424,6 +2761,10 @@ FRESULT find_volume (	/* FR_OK(0): successful, !=0: any error occurred */
 #endif
 	fs->fs_type = fmt;	/* FAT sub-type */
 	fs->id = ++Fsid;	/* File system mount ID */
+#if _FS_DIRHASH
+	for (i = 0; i < _FS_DIRHASH; i++) fs->dh_idx[i] = 0xFFFF;	/* Clear directory name cache */
+	fs->dh_next = 0;
+#endif
 #if _FS_RPATH
 	fs->cdir = 0;		/* Set current directory to root */
 #endif
@@ -2635,6 +2976,10 @@ FRESULT f_open (
 			fp->err = 0;						/* Clear error flag */
 			fp->sclust = ld_clust(dj.fs, dir);	/* File start cluster */
 			fp->fsize = LD_DWORD(dir + DIR_FileSize);	/* File size */
+#if _FS_LAZYSYNC && !_FS_READONLY
+			fp->cm_size = (mode & FA__WRITTEN) ? 0xFFFFFFFF : fp->fsize;	/* Overwritten file commits at first sync */
+			fp->cm_tick = _FS_LAZYSYNC_TICK();
+#endif
 			fp->fptr = 0;						/* File pointer */
 			fp->dsect = 0;
 #if _USE_FASTSEEK
@@ -2642,6 +2987,14 @@ FRESULT f_open (
 #endif
 			fp->fs = dj.fs;	 					/* Validate file object */
 			fp->id = fp->fs->id;
+#if _USE_FASTSEEK && _FS_CLMT_AUTO
+			if (!(mode & FA_WRITE) && fp->sclust) {	/* Read-only access: build the link map now */
+				fp->clmt[0] = _FS_CLMT_AUTO;
+				fp->cltbl = fp->clmt;
+				if (create_clmt(fp) != FR_OK)		/* Too fragmented, use normal seek */
+					fp->cltbl = 0;
+			}
+#endif
 		}
 	}
 
@@ -2684,6 +3037,11 @@ FRESULT f_read (
 		if ((fp->fptr % SS(fp->fs)) == 0) {		/* On the sector boundary? */
 			csect = (BYTE)(fp->fptr / SS(fp->fs) & (fp->fs->csize - 1));	/* Sector offset in the cluster */
 			if (!csect) {						/* On the cluster boundary? */
+#if _FS_REENTRANT && _FS_YIELD
+				if (*br && !ff_yield_grant(fp->fs->sobj)) {	/* Let waiting tasks in between clusters */
+					res = FR_TIMEOUT; break;	/* Volume is not locked any more */
+				}
+#endif
 				if (fp->fptr == 0) {			/* On the top of the file? */
 					clst = fp->sclust;			/* Follow from the origin */
 				} else {						/* Middle or end of the file */
@@ -2711,6 +3069,9 @@ FRESULT f_read (
 #if _FS_TINY
 				if (fp->fs->wflag && fp->fs->winsect - sect < cc)
 					mem_cpy(rbuff + ((fp->fs->winsect - sect) * SS(fp->fs)), fp->fs->win.d8, SS(fp->fs));
+#if _FS_WINCACHE
+				wc_merge(fp->fs, rbuff, sect, cc);
+#endif
 #else
 				if ((fp->flag & FA__DIRTY) && fp->dsect - sect < cc)
 					mem_cpy(rbuff + ((fp->dsect - sect) * SS(fp->fs)), fp->buf.d8, SS(fp->fs));
@@ -2745,7 +3106,7 @@ FRESULT f_read (
 #endif
 	}
 
-	LEAVE_FF(fp->fs, FR_OK);
+	LEAVE_FF(fp->fs, res);
 }
 
 
@@ -2785,6 +3146,11 @@ FRESULT f_write (
 		if ((fp->fptr % SS(fp->fs)) == 0) {	/* On the sector boundary? */
 			csect = (BYTE)(fp->fptr / SS(fp->fs) & (fp->fs->csize - 1));	/* Sector offset in the cluster */
 			if (!csect) {					/* On the cluster boundary? */
+#if _FS_REENTRANT && _FS_YIELD
+				if (*bw && !ff_yield_grant(fp->fs->sobj)) {	/* Let waiting tasks in between clusters */
+					res = FR_TIMEOUT; break;	/* Volume is not locked any more */
+				}
+#endif
 				if (fp->fptr == 0) {		/* On the top of the file? */
 					clst = fp->sclust;		/* Follow from the origin */
 					if (clst == 0)			/* When no cluster is allocated, */
@@ -2822,6 +3188,9 @@ FRESULT f_write (
 					cc = fp->fs->csize - csect;
 				if (disk_write(fp->fs->drv, wbuff, sect, cc) != RES_OK)
 					ABORT(fp->fs, FR_DISK_ERR);
+#if _FS_WINCACHE
+				wc_drop(fp->fs, sect, cc);
+#endif
 #if _FS_MINIMIZE <= 2
 #if _FS_TINY
 				if (fp->fs->winsect - sect < cc) {	/* Refill sector cache if it gets invalidated by the direct write */
@@ -2842,6 +3211,9 @@ FRESULT f_write (
 			if (fp->fptr >= fp->fsize) {	/* Avoid silly cache filling at growing edge */
 				if (sync_window(fp->fs)) ABORT(fp->fs, FR_DISK_ERR);
 				fp->fs->winsect = sect;
+#if _FS_WINCACHE
+				wc_drop(fp->fs, sect, 1);
+#endif
 			}
 #else
 			if (fp->dsect != sect) {		/* Fill sector cache with file data */
@@ -2868,7 +3240,7 @@ FRESULT f_write (
 	if (fp->fptr > fp->fsize) fp->fsize = fp->fptr;	/* Update file size if needed */
 	fp->flag |= FA__WRITTEN;						/* Set file change flag */
 
-	LEAVE_FF(fp->fs, FR_OK);
+	LEAVE_FF(fp->fs, res);
 }
 
 
@@ -2878,8 +3250,10 @@ FRESULT f_write (
 /* Synchronize the File                                                  */
 /*-----------------------------------------------------------------------*/
 
-FRESULT f_sync (
-	FIL* fp		/* Pointer to the file object */
+static
+FRESULT sync_file (
+	FIL* fp,	/* Pointer to the file object */
+	int lazy	/* 1:Commit of a grown file may be deferred (_FS_LAZYSYNC) */
 )
 {
 	FRESULT res;
@@ -2897,6 +3271,13 @@ FRESULT f_sync (
 					LEAVE_FF(fp->fs, FR_DISK_ERR);
 				fp->flag &= ~FA__DIRTY;
 			}
+#endif
+#if _FS_LAZYSYNC
+			if (lazy && fp->fsize >= fp->cm_size && fp->fsize - fp->cm_size < _FS_LAZYSYNC_BYTES
+				&& (DWORD)(_FS_LAZYSYNC_TICK() - fp->cm_tick) < _FS_LAZYSYNC_TICKS) {
+				res = sync_data(fp->fs);	/* Data only, the entry and the FAT stay at the last commit */
+				LEAVE_FF(fp->fs, res);
+			}
 #endif
 			/* Update the directory entry */
 			res = move_window(fp->fs, fp->dir_sect);
@@ -2911,6 +3292,10 @@ FRESULT f_sync (
 				fp->flag &= ~FA__WRITTEN;
 				fp->fs->wflag = 1;
 				res = sync_fs(fp->fs);
+#if _FS_LAZYSYNC
+				fp->cm_size = fp->fsize;
+				fp->cm_tick = _FS_LAZYSYNC_TICK();
+#endif
 			}
 		}
 	}
@@ -2918,6 +3303,14 @@ FRESULT f_sync (
 	LEAVE_FF(fp->fs, res);
 }
 
+
+FRESULT f_sync (
+	FIL* fp		/* Pointer to the file object */
+)
+{
+	return sync_file(fp, 1);
+}
+
 #endif /* !_FS_READONLY */
 
 
@@ -2935,7 +3328,7 @@ FRESULT f_close (
 
 
 #if !_FS_READONLY
-	res = f_sync(fp);					/* Flush cached data */
+	res = sync_file(fp, 0);				/* Flush cached data and commit */
 	if (res == FR_OK)
 #endif
 	{
@@ -3107,7 +3500,7 @@ FRESULT f_lseek (
 	FRESULT res;
 	DWORD clst, bcs, nsect, ifptr;
 #if _USE_FASTSEEK
-	DWORD cl, pcl, ncl, tcl, dsc, tlen, ulen, *tbl;
+	DWORD dsc;
 #endif
 
 
@@ -3119,29 +3512,8 @@ FRESULT f_lseek (
 #if _USE_FASTSEEK
 	if (fp->cltbl) {	/* Fast seek */
 		if (ofs == CREATE_LINKMAP) {	/* Create CLMT */
-			tbl = fp->cltbl;
-			tlen = *tbl++; ulen = 2;	/* Given table size and required table size */
-			cl = fp->sclust;			/* Top of the chain */
-			if (cl) {
-				do {
-					/* Get a fragment */
-					tcl = cl; ncl = 0; ulen += 2;	/* Top, length and used items */
-					do {
-						pcl = cl; ncl++;
-						cl = get_fat(fp->fs, cl);
-						if (cl <= 1) ABORT(fp->fs, FR_INT_ERR);
-						if (cl == 0xFFFFFFFF) ABORT(fp->fs, FR_DISK_ERR);
-					} while (cl == pcl + 1);
-					if (ulen <= tlen) {		/* Store the length and top of the fragment */
-						*tbl++ = ncl; *tbl++ = tcl;
-					}
-				} while (cl < fp->fs->n_fatent);	/* Repeat until end of chain */
-			}
-			*fp->cltbl = ulen;	/* Number of items used */
-			if (ulen <= tlen)
-				*tbl = 0;		/* Terminate table */
-			else
-				res = FR_NOT_ENOUGH_CORE;	/* Given table size is smaller than required */
+			res = create_clmt(fp);
+			if (res == FR_INT_ERR || res == FR_DISK_ERR) ABORT(fp->fs, res);
 
 		} else {						/* Fast seek */
 			if (ofs > fp->fsize)		/* Clip offset at the file size */
@@ -3562,6 +3934,9 @@ FRESULT f_truncate (
 		if (fp->fsize > fp->fptr) {
 			fp->fsize = fp->fptr;	/* Set file size to current R/W point */
 			fp->flag |= FA__WRITTEN;
+#if _FS_LAZYSYNC
+			fp->cm_size = 0xFFFFFFFF;	/* Removed clusters are committed at next sync */
+#endif
 			if (fp->fptr == 0) {	/* When set file size to zero, remove entire cluster chain */
 				res = remove_chain(fp->fs, fp->sclust);
 				fp->sclust = 0;
@@ -3593,6 +3968,78 @@ FRESULT f_truncate (
 
 
 
+#if _USE_EXPAND && !_FS_READONLY
+/*-----------------------------------------------------------------------*/
+/* Allocate a Contiguous Blocks to the File                              */
+/*-----------------------------------------------------------------------*/
+
+FRESULT f_expand (
+	FIL* fp,		/* Pointer to the file object */
+	DWORD fsz,		/* File size to be expanded to */
+	BYTE opt		/* Operation mode 0:Find and prepare or 1:Find and allocate */
+)
+{
+	FRESULT res;
+	FATFS *fs;
+	DWORD n, clst, stcl, scl, ncl, tcl, cs;
+
+
+	res = validate(fp);		/* Check validity of the object */
+	if (res != FR_OK) LEAVE_FF(fp->fs, res);
+	if (fp->err) LEAVE_FF(fp->fs, (FRESULT)fp->err);
+	if (fsz == 0 || fp->fsize != 0 || !(fp->flag & FA_WRITE))	/* Only an empty file open for write */
+		LEAVE_FF(fp->fs, FR_DENIED);
+	fs = fp->fs;
+	n = (DWORD)fs->csize * SS(fs);	/* Cluster size */
+	tcl = fsz / n + ((fsz & (n - 1)) ? 1 : 0);	/* Number of clusters required */
+	if (tcl > fs->n_fatent - 2) LEAVE_FF(fs, FR_DENIED);
+
+	/* Find a contiguous cluster block, one pass from the allocation hint */
+	stcl = fs->last_clust;
+	if (stcl < 2 || stcl >= fs->n_fatent) stcl = 2;
+	scl = clst = stcl; ncl = 0;
+	for (;;) {
+		cs = get_fat(fs, clst);
+		if (cs == 1) { res = FR_INT_ERR; break; }
+		if (cs == 0xFFFFFFFF) { res = FR_DISK_ERR; break; }
+		if (++clst >= fs->n_fatent) clst = 2;
+		if (cs == 0) {
+			if (++ncl == tcl) break;	/* Found */
+		} else {
+			scl = clst; ncl = 0;
+		}
+		if (clst == 2) { scl = 2; ncl = 0; }	/* A block does not wrap around */
+		if (clst == stcl) { res = FR_DENIED; break; }	/* No contiguous block */
+	}
+
+	if (res == FR_OK) {
+		if (opt) {		/* Create the cluster chain */
+			for (clst = scl, n = tcl; n; clst++, n--) {
+				res = put_fat(fs, clst, (n == 1) ? 0x0FFFFFFF : clst + 1);
+				if (res != FR_OK) break;
+			}
+			if (res == FR_OK) {
+				fs->last_clust = scl + tcl - 1;
+				if (fs->free_clust != 0xFFFFFFFF) {	/* Update FSINFO */
+					fs->free_clust -= tcl;
+					fs->fsi_flag |= 1;
+				}
+				fp->sclust = scl;		/* Update object allocation information */
+				fp->fsize = fsz;
+				fp->flag |= FA__WRITTEN;
+			}
+		} else {		/* Set the allocation hint, the file grows into the block */
+			fs->last_clust = scl - 1;
+		}
+	}
+
+	LEAVE_FF(fs, res);
+}
+#endif /* _USE_EXPAND && !_FS_READONLY */
+
+
+
+
 /*-----------------------------------------------------------------------*/
 /* Delete a File or Directory                                            */
 /*-----------------------------------------------------------------------*/
@@ -3707,6 +4154,9 @@ FRESULT f_mkdir (
 				if (dj.fs->fs_type == FS_FAT32 && pcl == dj.fs->dirbase)
 					pcl = 0;
 				st_clust(dir + SZ_DIRE, pcl);
+#if _FS_WINCACHE
+				wc_drop(dj.fs, dsc, dj.fs->csize);
+#endif
 				for (n = dj.fs->csize; n; n--) {	/* Write dot entries and clear following sectors */
 					dj.fs->winsect = dsc++;
 					dj.fs->wflag = 1;
@@ -4102,8 +4552,16 @@ FRESULT f_forward (
 		csect = (BYTE)(fp->fptr / SS(fp->fs) & (fp->fs->csize - 1));	/* Sector offset in the cluster */
 		if ((fp->fptr % SS(fp->fs)) == 0) {			/* On the sector boundary? */
 			if (!csect) {							/* On the cluster boundary? */
-				clst = (fp->fptr == 0) ?			/* On the top of the file? */
-					fp->sclust : get_fat(fp->fs, fp->clust);
+				if (fp->fptr == 0) {				/* On the top of the file? */
+					clst = fp->sclust;
+				} else {
+#if _USE_FASTSEEK
+					if (fp->cltbl)
+						clst = clmt_clust(fp, fp->fptr);	/* Get cluster# from the CLMT */
+					else
+#endif
+						clst = get_fat(fp->fs, fp->clust);
+				}
 				if (clst <= 1) ABORT(fp->fs, FR_INT_ERR);
 				if (clst == 0xFFFFFFFF) ABORT(fp->fs, FR_DISK_ERR);
 				fp->clust = clst;					/* Update current cluster */
@@ -4149,6 +4607,7 @@ FRESULT f_mkfs (
 	UINT i;
 	DWORD b_vol, b_fat, b_dir, b_data;	/* LBA */
 	DWORD n_vol, n_rsv, n_fat, n_dir;	/* Size */
+	DWORD n_eb;							/* Erase block size in sectors */
 	FATFS *fs;
 	DSTATUS stat;
 #if _USE_TRIM
@@ -4190,6 +4649,9 @@ FRESULT f_mkfs (
 		n_vol -= b_vol;				/* Volume size */
 	}
 
+	/* Get erase block size (for flash memory media) */
+	if (disk_ioctl(pdrv, GET_BLOCK_SIZE, &n_eb) != RES_OK || !n_eb || n_eb > 32768 || (n_eb & (n_eb - 1))) n_eb = 1;
+
 	if (au & (au - 1)) au = 0;
 	if (!au) {						/* AU auto selection */
 		vs = n_vol / (2000 / (SS(fs) / 512));
@@ -4217,14 +4679,17 @@ FRESULT f_mkfs (
 		n_rsv = 1;
 		n_dir = (DWORD)N_ROOTDIR * SZ_DIRE / SS(fs);
 	}
+
+	/* Start FAT at an erase block boundary (blocks up to 128 sectors) */
+	n = (n_eb < 128) ? n_eb : 128;
+	n_rsv = ((b_vol + n_rsv + n - 1) & ~(n - 1)) - b_vol;	/* VBR does not share a block with the FAT */
 	b_fat = b_vol + n_rsv;				/* FAT area start sector */
 	b_dir = b_fat + n_fat * N_FATS;		/* Directory area start sector */
 	b_data = b_dir + n_dir;				/* Data area start sector */
 	if (n_vol < b_data + au - b_vol) return FR_MKFS_ABORTED;	/* Too small volume */
 
 	/* Align data start sector to erase block boundary (for flash memory media) */
-	if (disk_ioctl(pdrv, GET_BLOCK_SIZE, &n) != RES_OK || !n || n > 32768) n = 1;
-	n = (b_data + n - 1) & ~(n - 1);	/* Next nearest erase block from current data start */
+	n = (b_data + n_eb - 1) & ~(n_eb - 1);	/* Next nearest erase block from current data start */
 	n = (n - b_data) / N_FATS;
 	if (fmt == FS_FAT32) {		/* FAT32: Move FAT offset */
 		n_rsv += n;
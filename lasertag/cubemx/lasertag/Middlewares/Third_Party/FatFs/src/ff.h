@@ -73,6 +73,26 @@ typedef char TCHAR;
 
 
 
+/* Window cache slots */
+
+#ifndef _FS_WINCACHE_FAT
+#define _FS_WINCACHE_FAT	0
+#endif
+#ifndef _FS_WINCACHE_DIR
+#define _FS_WINCACHE_DIR	0
+#endif
+#define _FS_WINCACHE	(_FS_WINCACHE_FAT + _FS_WINCACHE_DIR)
+
+#ifndef _FS_DIRHASH
+#define _FS_DIRHASH	0
+#endif
+
+#ifndef _FS_LAZYSYNC
+#define _FS_LAZYSYNC	0
+#endif
+
+
+
 /* File system object structure (FATFS) */
 
 typedef struct {
@@ -98,6 +118,22 @@ typedef struct {
 	DWORD	last_clust;		/* Last allocated cluster */
 	DWORD	free_clust;		/* Number of free clusters */
 #endif
+#if _FS_WINCACHE && !_FS_READONLY
+	BYTE	wc_flag[_FS_WINCACHE];	/* Cached sector flags (b0:dirty) */
+	WORD	wc_age[_FS_WINCACHE];	/* Last use of the slot (LRU) */
+	WORD	wc_tick;				/* Use counter */
+	DWORD	wc_sect[_FS_WINCACHE];	/* Cached sector# (0xFFFFFFFF:Empty) */
+  union{
+	UINT	d32[_MAX_SS/4];
+	BYTE	d8[_MAX_SS];
+  }wc_buf[_FS_WINCACHE];			/* Sectors parked from win[], FAT slots first */
+#endif
+#if _FS_DIRHASH
+	WORD	dh_hash[_FS_DIRHASH];	/* Hash of directory and name of the cached entry */
+	WORD	dh_idx[_FS_DIRHASH];	/* Directory index of the entry (0xFFFF:Empty) */
+	DWORD	dh_clust[_FS_DIRHASH];	/* Directory start cluster (0:Root) */
+	BYTE	dh_next;				/* Next slot to replace when all are used */
+#endif
 #if _FS_RPATH
 	DWORD	cdir;			/* Current directory start cluster (0:root) */
 #endif
@@ -135,8 +171,15 @@ typedef struct {
 	DWORD	dir_sect;		/* Sector number containing the directory entry */
 	BYTE*	dir_ptr;		/* Pointer to the directory entry in the win[] */
 #endif
+#if _FS_LAZYSYNC && !_FS_READONLY
+	DWORD	cm_size;		/* File size at the last commit of the directory entry */
+	DWORD	cm_tick;		/* Time of the last commit */
+#endif
 #if _USE_FASTSEEK
 	DWORD*	cltbl;			/* Pointer to the cluster link map table (Nulled on file open) */
+#if _FS_CLMT_AUTO
+	DWORD	clmt[_FS_CLMT_AUTO];	/* Cluster link map built at read-only open */
+#endif
 #endif
 #if _FS_LOCK
 	UINT	lockid;			/* File lock ID origin from 1 (index of file semaphore table Files[]) */
@@ -230,6 +273,7 @@ FRESULT f_write (FIL* fp, const void* buff, UINT btw, UINT* bw);	/* Write data t
 FRESULT f_forward (FIL* fp, UINT(*func)(const BYTE*,UINT), UINT btf, UINT* bf);	/* Forward data to the stream */
 FRESULT f_lseek (FIL* fp, DWORD ofs);								/* Move file pointer of a file object */
 FRESULT f_truncate (FIL* fp);										/* Truncate file */
+FRESULT f_expand (FIL* fp, DWORD fsz, BYTE opt);					/* Allocate a contiguous block to the file */
 FRESULT f_sync (FIL* fp);											/* Flush cached data of a writing file */
 FRESULT f_opendir (DIR* dp, const TCHAR* path);						/* Open a directory */
 FRESULT f_closedir (DIR* dp);										/* Close an open directory */
@@ -294,6 +338,9 @@ int ff_cre_syncobj (BYTE vol, _SYNC_t* sobj);	/* Create a sync object */
 int ff_req_grant (_SYNC_t sobj);				/* Lock sync object */
 void ff_rel_grant (_SYNC_t sobj);				/* Unlock sync object */
 int ff_del_syncobj (_SYNC_t sobj);				/* Delete a sync object */
+#if _FS_YIELD
+int ff_yield_grant (_SYNC_t sobj);				/* Unlock, let waiting tasks run, lock again */
+#endif
 #endif
 
 
@@ -5,8 +5,28 @@
 
 #include <stdlib.h>		/* ANSI memory controls */
 #include "../ff.h"
+#include "common.h"		/* NOTIFY_Wait */
 
 #if _FS_REENTRANT
+#if _FS_YIELD
+/* Task notification bit of the yielding task, see NOTIFY_Wait */
+#define SYNC_YIELD_NOTIFY	0x20000000
+
+/* Volume hand-off at ff_yield_grant */
+typedef struct {
+	UBaseType_t Waiting;		/* Tasks in ff_req_grant */
+	TaskHandle_t Yielder;		/* Task waiting for one of them to get the volume */
+} SYNC_HandoffTypeDef;
+
+static SYNC_HandoffTypeDef SyncHandoff[_VOLUMES];
+
+#define SYNC_HANDOFF(sobj)	(&SyncHandoff[(StaticSemaphore_t*)(sobj) - SyncObjBuffer])
+#endif
+
+/* Mutex per volume (priority inheritance), FreeRTOS is built without heap */
+static StaticSemaphore_t SyncObjBuffer[_VOLUMES];
+
+
 /*-----------------------------------------------------------------------
  Create a Synchronization Object
 ------------------------------------------------------------------------
@@ -20,13 +40,9 @@ int ff_cre_syncobj (	/* TRUE:Function succeeded, FALSE:Could not create due to a
 	_SYNC_t *sobj		/* Pointer to return the created sync object */
 )
 {
-  int ret;
-  
-  osSemaphoreDef(SEM);
-  *sobj = osSemaphoreCreate(osSemaphore(SEM), 1);		
-  ret = (*sobj != NULL);
+  *sobj = xSemaphoreCreateMutexStatic(&SyncObjBuffer[vol]);
   
-  return ret;
+  return (*sobj != NULL);
 }
 
 
@@ -43,7 +59,7 @@ int ff_del_syncobj (	/* TRUE:Function succeeded, FALSE:Could not delete due to a
 	_SYNC_t sobj		/* Sync object tied to the logical drive to be deleted */
 )
 {
-  osSemaphoreDelete (sobj);
+  vSemaphoreDelete(sobj);
   return 1;
 }
 
@@ -54,20 +70,43 @@ int ff_del_syncobj (	/* TRUE:Function succeeded, FALSE:Could not delete due to a
 /*------------------------------------------------------------------------*/
 /* This function is called on entering file functions to lock the volume.
 /  When a zero is returned, the file function fails with FR_TIMEOUT.
+/  Before the scheduler starts there is only one thread, no locking.
+/  With _FS_YIELD the task counts itself as waiting and, done waiting,
+/  wakes up a task that passed the volume on in ff_yield_grant.
 */
 
 int ff_req_grant (	/* TRUE:Got a grant to access the volume, FALSE:Could not get a grant */
 	_SYNC_t sobj	/* Sync object to wait */
 )
 {
-  int ret = 0;
+#if _FS_YIELD
+  SYNC_HandoffTypeDef *pHandoff = SYNC_HANDOFF(sobj);
+  TaskHandle_t Yielder;
+  int res;
+#endif
+
+  if (xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED)
+    return 1;
   
-  if(osSemaphoreWait(sobj, _FS_TIMEOUT) == osOK)
-  {
-    ret = 1;
-  }
+#if _FS_YIELD
+  taskENTER_CRITICAL();
+  pHandoff->Waiting++;
+  taskEXIT_CRITICAL();
   
-  return ret;
+  res = (xSemaphoreTake(sobj, _FS_TIMEOUT) == pdTRUE);
+  
+  taskENTER_CRITICAL();
+  pHandoff->Waiting--;
+  Yielder = pHandoff->Yielder;
+  pHandoff->Yielder = NULL;
+  taskEXIT_CRITICAL();
+  
+  if (Yielder != NULL)
+    xTaskNotify(Yielder, SYNC_YIELD_NOTIFY, eSetBits);
+  return res;
+#else
+  return (xSemaphoreTake(sobj, _FS_TIMEOUT) == pdTRUE);
+#endif
 }
 
 
@@ -82,9 +121,46 @@ void ff_rel_grant (
 	_SYNC_t sobj	/* Sync object to be signaled */
 )
 {
-  osSemaphoreRelease(sobj);
+  if (xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED)
+    xSemaphoreGive(sobj);
 }
 
+
+
+#if _FS_YIELD
+/*------------------------------------------------------------------------*/
+/* Pass the Volume to Waiting Tasks                                       */
+/*------------------------------------------------------------------------*/
+/* This function is called between clusters of long f_read/f_write.
+/  Nobody waiting, the volume stays locked. Otherwise it is given and the
+/  task sleeps until a waiting task got it, whatever its priority, then
+/  queues for it again behind that one. A plain give and take would take
+/  it straight back from a waiting task of lower priority. When a zero is
+/  returned, the volume is not locked and the function ends with FR_TIMEOUT.
+*/
+
+int ff_yield_grant (	/* TRUE:Got the grant back, FALSE:Could not get a grant */
+	_SYNC_t sobj	/* Sync object of the locked volume */
+)
+{
+  SYNC_HandoffTypeDef *pHandoff = SYNC_HANDOFF(sobj);
+  
+  if (xTaskGetSchedulerState() == taskSCHEDULER_NOT_STARTED || pHandoff->Waiting == 0)
+    return 1;
+  
+  pHandoff->Yielder = xTaskGetCurrentTaskHandle();
+  xSemaphoreGive(sobj);
+  if (NOTIFY_Wait(SYNC_YIELD_NOTIFY, _FS_TIMEOUT) == 0)
+  {
+    taskENTER_CRITICAL();
+    pHandoff->Yielder = NULL;
+    taskEXIT_CRITICAL();
+  }
+  
+  return (xSemaphoreTake(sobj, _FS_TIMEOUT) == pdTRUE);
+}
+#endif
+
 #endif
 
 
@@ -186,12 +186,23 @@ osThreadId osThreadCreate (const osThreadDef_t *thread_def, void *argument)
 {
   TaskHandle_t handle;
   
+#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+  if ((thread_def->buffer != NULL) && (thread_def->controlblock != NULL)) {
+    return xTaskCreateStatic((TaskFunction_t)thread_def->pthread,(const portCHAR *)thread_def->name,
+              thread_def->stacksize, argument, makeFreeRtosPriority(thread_def->tpriority),
+              thread_def->buffer, thread_def->controlblock);
+  }
+#endif
   
+#if( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
   if (xTaskCreate((TaskFunction_t)thread_def->pthread,(const portCHAR *)thread_def->name,
               thread_def->stacksize, argument, makeFreeRtosPriority(thread_def->tpriority),
               &handle) != pdPASS)  {
     return NULL;
   }
+#else
+  handle = NULL;
+#endif
   
   return handle;
 }
@@ -547,7 +558,16 @@ osEvent osSignalWait (int32_t signals, uint32_t millisec)
 osMutexId osMutexCreate (const osMutexDef_t *mutex_def)
 {
 #if ( configUSE_MUTEXES == 1)
+#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+  if (mutex_def->controlblock != NULL) {
+    return xSemaphoreCreateMutexStatic(mutex_def->controlblock);
+  }
+#endif
+#if( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
   return xSemaphoreCreateMutex(); 
+#else
+  return NULL;
+#endif
 #else
 	return NULL;
 #endif
@@ -651,6 +671,24 @@ osSemaphoreId osSemaphoreCreate (const osSemaphoreDef_t *semaphore_def, int32_t
   (void) semaphore_def;
   osSemaphoreId sema;
   
+#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+  if (semaphore_def->controlblock != NULL) {
+    if (count == 1) {
+      sema = xSemaphoreCreateBinaryStatic(semaphore_def->controlblock);
+      if (sema != NULL) {
+        (void) xSemaphoreGive(sema);
+      }
+      return sema;
+    }
+#if (configUSE_COUNTING_SEMAPHORES == 1 )	
+    return xSemaphoreCreateCountingStatic(count, 0, semaphore_def->controlblock);
+#else
+    return NULL;
+#endif
+  }
+#endif
+  
+#if( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
   if (count == 1) {
     vSemaphoreCreateBinary(sema);
     return sema;
@@ -661,6 +699,10 @@ osSemaphoreId osSemaphoreCreate (const osSemaphoreDef_t *semaphore_def, int32_t
 #else
   return NULL;
 #endif
+#else
+  (void) sema;
+  return NULL;
+#endif
 }
 
 /**
@@ -754,19 +796,25 @@ osStatus osSemaphoreDelete (osSemaphoreId semaphore_id)
 
 #if (defined (osFeature_Pool)  &&  (osFeature_Pool != 0)) 
 
-//TODO
-//This is a primitive and inefficient wrapper around the existing FreeRTOS memory management.
-//A better implementation will have to modify heap_x.c!
-
-
-typedef struct os_pool_cb {
-  void *pool;
-  uint8_t *markers;
-  uint32_t pool_sz;
-  uint32_t item_sz;
-  uint32_t currentIndex;
-} os_pool_cb_t;
+/* Free blocks are linked through their first word. Alloc and free take and
+   put the list head with interrupts masked by PRIMASK (Cortex-M0 has no
+   exclusive access instructions), a few instructions in any context. */
 
+static void poolInit (os_pool_cb_t *thePool, void *storage, uint32_t pool_sz, uint32_t item_sz)
+{
+  uint32_t i;
+  
+  thePool->pool = storage;
+  thePool->pool_sz = pool_sz;
+  thePool->item_sz = item_sz;
+  thePool->free = NULL;
+  
+  /* link from the end, blocks are handed out in address order */
+  for (i = pool_sz; i > 0; i--) {
+    *(void **)(thePool->pool + (i - 1) * item_sz) = thePool->free;
+    thePool->free = thePool->pool + (i - 1) * item_sz;
+  }
+}
 
 /**
 * @brief Create and Initialize a memory pool
@@ -776,33 +824,27 @@ typedef struct os_pool_cb {
 */
 osPoolId osPoolCreate (const osPoolDef_t *pool_def)
 {
+  uint32_t itemSize = 4 * ((pool_def->item_sz + 3) / 4);
+#if( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
   osPoolId thePool;
-  int itemSize = 4 * ((pool_def->item_sz + 3) / 4);
-  uint32_t i;
+  void *storage;
+#endif
   
+#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+  if (pool_def->controlblock != NULL) {
+    poolInit(pool_def->controlblock, pool_def->pool, pool_def->pool_sz, itemSize);
+    return pool_def->controlblock;
+  }
+#endif
+  
+#if( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
   /* First have to allocate memory for the pool control block. */
   thePool = pvPortMalloc(sizeof(os_pool_cb_t));
   if (thePool) {
-    thePool->pool_sz = pool_def->pool_sz;
-    thePool->item_sz = itemSize;
-    thePool->currentIndex = 0;
-    
-    /* Memory for markers */
-    thePool->markers = pvPortMalloc(pool_def->pool_sz);
-    if (thePool->markers) {
-      /* Now allocate the pool itself. */
-      thePool->pool = pvPortMalloc(pool_def->pool_sz * itemSize);
-      
-      if (thePool->pool) {
-        for (i = 0; i < pool_def->pool_sz; i++) {
-          thePool->markers[i] = 0;
-        }
-      }
-      else {
-        vPortFree(thePool->markers);
-        vPortFree(thePool);
-        thePool = NULL;
-      }
+    /* Now allocate the pool itself. */
+    storage = pvPortMalloc(pool_def->pool_sz * itemSize);
+    if (storage) {
+      poolInit(thePool, storage, pool_def->pool_sz, itemSize);
     }
     else {
       vPortFree(thePool);
@@ -811,6 +853,11 @@ osPoolId osPoolCreate (const osPoolDef_t *pool_def)
   }
   
   return thePool;
+#else
+  /* without a heap only osPoolStaticDef pools */
+  (void) itemSize;
+  return NULL;
+#endif
 }
 
 /**
@@ -821,38 +868,20 @@ osPoolId osPoolCreate (const osPoolDef_t *pool_def)
 */
 void *osPoolAlloc (osPoolId pool_id)
 {
-  int dummy = 0;
-  void *p = NULL;
-  uint32_t i;
-  uint32_t index;
-  
-  if (inHandlerMode()) {
-    dummy = portSET_INTERRUPT_MASK_FROM_ISR();
-  }
-  else {
-    vPortEnterCritical();
-  }
+  uint32_t mask;
+  void *p;
   
-  for (i = 0; i < pool_id->pool_sz; i++) {
-    index = pool_id->currentIndex + i;
-    if (index >= pool_id->pool_sz) {
-      index = 0;
-    }
-    
-    if (pool_id->markers[index] == 0) {
-      pool_id->markers[index] = 1;
-      p = (void *)((uint32_t)(pool_id->pool) + (index * pool_id->item_sz));
-      pool_id->currentIndex = index;
-      break;
-    }
+  if (pool_id == NULL) {
+    return NULL;
   }
   
-  if (inHandlerMode()) {
-    portCLEAR_INTERRUPT_MASK_FROM_ISR(dummy);
-  }
-  else {
-    vPortExitCritical();
+  /* PRIMASK save/set works in tasks and handlers alike */
+  mask = portSET_INTERRUPT_MASK_FROM_ISR();
+  p = pool_id->free;
+  if (p != NULL) {
+    pool_id->free = *(void **)p;
   }
+  portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
   
   return p;
 }
@@ -869,7 +898,7 @@ void *osPoolCAlloc (osPoolId pool_id)
   
   if (p != NULL)
   {
-    memset(p, 0, sizeof(pool_id->pool_sz));
+    memset(p, 0, pool_id->item_sz);
   }
   
   return p;
@@ -881,9 +910,13 @@ void *osPoolCAlloc (osPoolId pool_id)
 * @param  block         address of the allocated memory block that is returned to the memory pool.
 * @retval  status code that indicates the execution status of the function.
 * @note   MUST REMAIN UNCHANGED: \b osPoolFree shall be consistent in every CMSIS-RTOS.
+* @note   block must be allocated and not freed since. Freeing the block freed
+*         last again (the list head) returns osErrorParameter, an older double
+*         free is not detected and links the block twice.
 */
 osStatus osPoolFree (osPoolId pool_id, void *block)
 {
+  uint32_t mask;
   uint32_t index;
   
   if (pool_id == NULL) {
@@ -894,11 +927,11 @@ osStatus osPoolFree (osPoolId pool_id, void *block)
     return osErrorParameter;
   }
   
-  if (block < pool_id->pool) {
+  if ((uint8_t *)block < pool_id->pool) {
     return osErrorParameter;
   }
   
-  index = (uint32_t)block - (uint32_t)(pool_id->pool);
+  index = (uint8_t *)block - pool_id->pool;
   if (index % pool_id->item_sz) {
     return osErrorParameter;
   }
@@ -907,7 +940,14 @@ osStatus osPoolFree (osPoolId pool_id, void *block)
     return osErrorParameter;
   }
   
-  pool_id->markers[index] = 0;
+  mask = portSET_INTERRUPT_MASK_FROM_ISR();
+  if (block == pool_id->free) {
+    portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
+    return osErrorParameter;
+  }
+  *(void **)block = pool_id->free;
+  pool_id->free = block;
+  portCLEAR_INTERRUPT_MASK_FROM_ISR(mask);
   
   return osOK;
 }
@@ -930,7 +970,17 @@ osMessageQId osMessageCreate (const osMessageQDef_t *queue_def, osThreadId threa
 {
   (void) thread_id;
   
+#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+  if (queue_def->controlblock != NULL) {
+    return xQueueCreateStatic(queue_def->queue_sz, queue_def->item_sz, queue_def->buffer, queue_def->controlblock);
+  }
+#endif
+  
+#if( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
   return xQueueCreate(queue_def->queue_sz, queue_def->item_sz);
+#else
+  return NULL;
+#endif
 }
 
 /**
@@ -1029,12 +1079,6 @@ osEvent osMessageGet (osMessageQId queue_id, uint32_t millisec)
 #if (defined (osFeature_MailQ)  &&  (osFeature_MailQ != 0))  /* Use Mail Queues */
 
 
-typedef struct os_mailQ_cb {
-  const osMailQDef_t *queue_def;
-  QueueHandle_t handle;
-  osPoolId pool;
-} os_mailQ_cb_t;
-
 /**
 * @brief Create and Initialize mail queue
 * @param  queue_def     reference to the mail queue definition obtain with \ref osMailQ
@@ -1044,11 +1088,32 @@ typedef struct os_mailQ_cb {
 */
 osMailQId osMailCreate (const osMailQDef_t *queue_def, osThreadId thread_id)
 {
+  osPoolDef_t pool_def;
+  
   (void) thread_id;
   
-  osPoolDef_t pool_def = {queue_def->queue_sz, queue_def->item_sz};
+  pool_def.pool_sz = queue_def->queue_sz;
+  pool_def.item_sz = queue_def->item_sz;
+  pool_def.pool = NULL;
   
+#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+  pool_def.controlblock = NULL;
+  if (queue_def->controlblock != NULL) {
+    /* queue, pool and control block were defined by osMailQStaticDef */
+    pool_def.pool = queue_def->pool;
+    pool_def.controlblock = &queue_def->controlblock->pool_cb;
+    
+    queue_def->controlblock->queue_def = queue_def;
+    queue_def->controlblock->handle = xQueueCreateStatic(queue_def->queue_sz, sizeof(void *),
+                                                         queue_def->buffer, &queue_def->controlblock->queue_cb);
+    queue_def->controlblock->pool = osPoolCreate(&pool_def);
+    *(queue_def->cb) = queue_def->controlblock;
+    
+    return *(queue_def->cb);
+  }
+#endif
   
+#if( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
   /* Create a mail queue control block */
   *(queue_def->cb) = pvPortMalloc(sizeof(struct os_mailQ_cb));
   if (*(queue_def->cb) == NULL) {
@@ -1072,6 +1137,10 @@ osMailQId osMailCreate (const osMailQDef_t *queue_def, osThreadId thread_id)
   }
   
   return *(queue_def->cb);
+#else
+  /* without a heap only osMailQStaticDef queues */
+  return NULL;
+#endif
 }
 
 /**
@@ -1105,13 +1174,10 @@ void *osMailAlloc (osMailQId queue_id, uint32_t millisec)
 */
 void *osMailCAlloc (osMailQId queue_id, uint32_t millisec)
 {
-  uint32_t i;
   void *p = osMailAlloc(queue_id, millisec);
   
   if (p) {
-    for (i = 0; i < sizeof(queue_id->queue_def->item_sz); i++) {
-      ((uint8_t *)p)[i] = 0;
-    }
+    memset(p, 0, queue_id->queue_def->item_sz);
   }
   
   return p;
@@ -1448,7 +1514,16 @@ osMutexId osRecursiveMutexCreate (const osMutexDef_t *mutex_def)
 {
   (void) mutex_def;
 #if (configUSE_RECURSIVE_MUTEXES == 1)
+#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+  if (mutex_def->controlblock != NULL) {
+    return xSemaphoreCreateRecursiveMutexStatic(mutex_def->controlblock);
+  }
+#endif
+#if( configSUPPORT_DYNAMIC_ALLOCATION == 1 )
   return xSemaphoreCreateRecursiveMutex();
+#else
+  return NULL;
+#endif
 #else
   return NULL;
 #endif	
@@ -306,6 +306,16 @@ typedef QueueHandle_t osMessageQId;
 typedef struct os_mailQ_cb *osMailQId;
 
 
+#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+/// Control blocks of statically allocated objects, see osThreadStaticDef, osMutexStaticDef,
+/// osSemaphoreStaticDef and osMessageQStaticDef (osPoolStaticDef and osMailQStaticDef
+/// declare their own).
+typedef StaticTask_t               osStaticThreadDef_t;
+typedef StaticSemaphore_t          osStaticMutexDef_t;
+typedef StaticSemaphore_t          osStaticSemaphoreDef_t;
+typedef StaticQueue_t              osStaticMessageQDef_t;
+#endif
+
 /// Thread Definition structure contains startup information of a thread.
 /// \note CAN BE CHANGED: \b os_thread_def is implementation specific in every CMSIS-RTOS.
 typedef struct os_thread_def  {
@@ -314,6 +324,10 @@ typedef struct os_thread_def  {
   osPriority             tpriority;    ///< initial thread priority
   uint32_t               instances;    ///< maximum number of instances of that thread function
   uint32_t               stacksize;    ///< stack size requirements in bytes; 0 is default stack size
+#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+  uint32_t               *buffer;      ///< stack buffer for static allocation; NULL for dynamic allocation
+  osStaticThreadDef_t    *controlblock;     ///< control block to hold thread's data for static allocation; NULL for dynamic allocation
+#endif
 } osThreadDef_t;
 
 /// Timer Definition structure contains timer parameters.
@@ -326,12 +340,18 @@ typedef struct os_timer_def  {
 /// \note CAN BE CHANGED: \b os_mutex_def is implementation specific in every CMSIS-RTOS.
 typedef struct os_mutex_def  {
   uint32_t                   dummy;    ///< dummy value.
+#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+  osStaticMutexDef_t         *controlblock;      ///< control block for static allocation; NULL for dynamic allocation
+#endif
 } osMutexDef_t;
 
 /// Semaphore Definition structure contains setup information for a semaphore.
 /// \note CAN BE CHANGED: \b os_semaphore_def is implementation specific in every CMSIS-RTOS.
 typedef struct os_semaphore_def  {
   uint32_t                   dummy;    ///< dummy value.
+#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+  osStaticSemaphoreDef_t     *controlblock;      ///< control block for static allocation; NULL for dynamic allocation
+#endif
 } osSemaphoreDef_t;
 
 /// Definition structure for memory block allocation.
@@ -340,6 +360,9 @@ typedef struct os_pool_def  {
   uint32_t                 pool_sz;    ///< number of items (elements) in the pool
   uint32_t                 item_sz;    ///< size of an item
   void                       *pool;    ///< pointer to memory for pool
+#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+  struct os_pool_cb  *controlblock;    ///< control block for static allocation; NULL for dynamic allocation
+#endif
 } osPoolDef_t;
 
 /// Definition structure for message queue.
@@ -348,6 +371,10 @@ typedef struct os_messageQ_def  {
   uint32_t                queue_sz;    ///< number of elements in the queue
   uint32_t                 item_sz;    ///< size of an item
   //void                       *pool;    ///< memory array for messages
+#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+  uint8_t                  *buffer;    ///< buffer for static allocation; NULL for dynamic allocation
+  osStaticMessageQDef_t    *controlblock;     ///< control block to hold queue's data for static allocation; NULL for dynamic allocation
+#endif
 } osMessageQDef_t;
 
 /// Definition structure for mail queue.
@@ -356,8 +383,35 @@ typedef struct os_mailQ_def  {
   uint32_t                queue_sz;    ///< number of elements in the queue
   uint32_t                 item_sz;    ///< size of an item
   struct os_mailQ_cb **cb;
+#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+  void                       *pool;    ///< memory for mail blocks for static allocation
+  uint8_t                  *buffer;    ///< buffer of the mail pointer queue for static allocation
+  struct os_mailQ_cb *controlblock;    ///< control block for static allocation; NULL for dynamic allocation
+#endif
 } osMailQDef_t;
 
+/// Memory pool control block. A free block holds the address of the next free block,
+/// alloc and free take and put the list head - constant time, see osPoolAlloc.
+/// \note CAN BE CHANGED: \b os_pool_cb is implementation specific in every CMSIS-RTOS.
+typedef struct os_pool_cb {
+  void                       *free;    ///< first free block; NULL when all blocks are allocated
+  uint8_t                    *pool;    ///< memory for blocks
+  uint32_t                 pool_sz;    ///< number of blocks
+  uint32_t                 item_sz;    ///< block size, rounded up to whole words
+} os_pool_cb_t;
+
+/// Mail queue control block.
+/// \note CAN BE CHANGED: \b os_mailQ_cb is implementation specific in every CMSIS-RTOS.
+typedef struct os_mailQ_cb {
+  const osMailQDef_t    *queue_def;
+  QueueHandle_t             handle;
+  osPoolId                    pool;
+#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+  os_pool_cb_t             pool_cb;    ///< pool of a static mail queue
+  StaticQueue_t           queue_cb;    ///< queue of a static mail queue
+#endif
+} os_mailQ_cb_t;
+
 /// Event structure contains detailed information about an event.
 /// \note MUST REMAIN UNCHANGED: \b os_event shall be consistent in every CMSIS-RTOS.
 ///       However the struct may be extended at the end.
@@ -422,11 +476,29 @@ uint32_t osKernelSysTick (void);
 #if defined (osObjectsExternal)  // object is external
 #define osThreadDef(name, thread, priority, instances, stacksz)  \
 extern const osThreadDef_t os_thread_def_##name
+#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+#define osThreadStaticDef(name, thread, priority, instances, stacksz, buffer, control)  \
+extern const osThreadDef_t os_thread_def_##name
+#endif
 #else                            // define the object
+#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+#define osThreadDef(name, thread, priority, instances, stacksz)  \
+const osThreadDef_t os_thread_def_##name = \
+{ #name, (thread), (priority), (instances), (stacksz), NULL, NULL }
+
+/// Static variant of \ref osThreadDef, stack and control block are provided by the caller.
+/// \param         stacksz      stack size in words, size of buffer.
+/// \param         buffer       uint32_t stack array.
+/// \param         control      osStaticThreadDef_t control block.
+#define osThreadStaticDef(name, thread, priority, instances, stacksz, buffer, control)  \
+const osThreadDef_t os_thread_def_##name = \
+{ #name, (thread), (priority), (instances), (stacksz), (buffer), (control) }
+#else
 #define osThreadDef(name, thread, priority, instances, stacksz)  \
 const osThreadDef_t os_thread_def_##name = \
 { #name, (thread), (priority), (instances), (stacksz)  }
 #endif
+#endif
 
 /// Access a Thread definition.
 /// \param         name          name of the thread definition object.
@@ -573,10 +645,23 @@ osEvent osSignalWait (int32_t signals, uint32_t millisec);
 #if defined (osObjectsExternal)  // object is external
 #define osMutexDef(name)  \
 extern const osMutexDef_t os_mutex_def_##name
+#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+#define osMutexStaticDef(name, control)  \
+extern const osMutexDef_t os_mutex_def_##name
+#endif
 #else                            // define the object
+#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+#define osMutexDef(name)  \
+const osMutexDef_t os_mutex_def_##name = { 0, NULL }
+
+/// Static variant of \ref osMutexDef, control block is provided by the caller.
+#define osMutexStaticDef(name, control)  \
+const osMutexDef_t os_mutex_def_##name = { 0, (control) }
+#else
 #define osMutexDef(name)  \
 const osMutexDef_t os_mutex_def_##name = { 0 }
 #endif
+#endif
 
 /// Access a Mutex definition.
 /// \param         name          name of the mutex object.
@@ -622,10 +707,23 @@ osStatus osMutexDelete (osMutexId mutex_id);
 #if defined (osObjectsExternal)  // object is external
 #define osSemaphoreDef(name)  \
 extern const osSemaphoreDef_t os_semaphore_def_##name
+#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+#define osSemaphoreStaticDef(name, control)  \
+extern const osSemaphoreDef_t os_semaphore_def_##name
+#endif
 #else                            // define the object
+#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+#define osSemaphoreDef(name)  \
+const osSemaphoreDef_t os_semaphore_def_##name = { 0, NULL }
+
+/// Static variant of \ref osSemaphoreDef, control block is provided by the caller.
+#define osSemaphoreStaticDef(name, control)  \
+const osSemaphoreDef_t os_semaphore_def_##name = { 0, (control) }
+#else
 #define osSemaphoreDef(name)  \
 const osSemaphoreDef_t os_semaphore_def_##name = { 0 }
 #endif
+#endif
 
 /// Access a Semaphore definition.
 /// \param         name          name of the semaphore object.
@@ -676,11 +774,28 @@ osStatus osSemaphoreDelete (osSemaphoreId semaphore_id);
 #if defined (osObjectsExternal)  // object is external
 #define osPoolDef(name, no, type)   \
 extern const osPoolDef_t os_pool_def_##name
+#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+#define osPoolStaticDef(name, no, type)   \
+extern const osPoolDef_t os_pool_def_##name
+#endif
 #else                            // define the object
+#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+#define osPoolDef(name, no, type)   \
+const osPoolDef_t os_pool_def_##name = \
+{ (no), sizeof(type), NULL, NULL }
+
+/// Static variant of \ref osPoolDef, defines the block memory and the control block.
+#define osPoolStaticDef(name, no, type)   \
+static uint32_t os_pool_buffer_##name[(no) * ((sizeof(type) + 3) / 4)]; \
+static os_pool_cb_t os_pool_control_##name; \
+const osPoolDef_t os_pool_def_##name = \
+{ (no), sizeof(type), os_pool_buffer_##name, &os_pool_control_##name }
+#else
 #define osPoolDef(name, no, type)   \
 const osPoolDef_t os_pool_def_##name = \
 { (no), sizeof(type), NULL }
 #endif
+#endif
 
 /// \brief Access a Memory Pool definition.
 /// \param         name          name of the memory pool
@@ -730,11 +845,28 @@ osStatus osPoolFree (osPoolId pool_id, void *block);
 #if defined (osObjectsExternal)  // object is external
 #define osMessageQDef(name, queue_sz, type)   \
 extern const osMessageQDef_t os_messageQ_def_##name
+#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+#define osMessageQStaticDef(name, queue_sz, type, buffer, control)   \
+extern const osMessageQDef_t os_messageQ_def_##name
+#endif
 #else                            // define the object
+#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+#define osMessageQDef(name, queue_sz, type)   \
+const osMessageQDef_t os_messageQ_def_##name = \
+{ (queue_sz), sizeof (type), NULL, NULL }
+
+/// Static variant of \ref osMessageQDef, storage and control block are provided by the caller.
+/// \param         buffer       uint8_t array of queue_sz * sizeof(type) bytes.
+/// \param         control      osStaticMessageQDef_t control block.
+#define osMessageQStaticDef(name, queue_sz, type, buffer, control)   \
+const osMessageQDef_t os_messageQ_def_##name = \
+{ (queue_sz), sizeof (type), (buffer), (control) }
+#else
 #define osMessageQDef(name, queue_sz, type)   \
 const osMessageQDef_t os_messageQ_def_##name = \
 { (queue_sz), sizeof (type)  }
 #endif
+#endif
 
 /// \brief Access a Message Queue Definition.
 /// \param         name          name of the queue
@@ -780,14 +912,37 @@ osEvent osMessageGet (osMessageQId queue_id, uint32_t millisec);
 ///       macro body is implementation specific in every CMSIS-RTOS.
 #if defined (osObjectsExternal)  // object is external
 #define osMailQDef(name, queue_sz, type) \
-extern struct os_mailQ_cb *os_mailQ_cb_##name \
+extern struct os_mailQ_cb *os_mailQ_cb_##name; \
+extern osMailQDef_t os_mailQ_def_##name
+#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+#define osMailQStaticDef(name, queue_sz, type) \
+extern struct os_mailQ_cb *os_mailQ_cb_##name; \
 extern osMailQDef_t os_mailQ_def_##name
+#endif
 #else                            // define the object
+#if( configSUPPORT_STATIC_ALLOCATION == 1 )
+#define osMailQDef(name, queue_sz, type) \
+struct os_mailQ_cb *os_mailQ_cb_##name; \
+const osMailQDef_t os_mailQ_def_##name =  \
+{ (queue_sz), sizeof (type), (&os_mailQ_cb_##name), NULL, NULL, NULL }
+
+/// Static variant of \ref osMailQDef, defines the mail blocks, the pointer queue and
+/// the control block.
+#define osMailQStaticDef(name, queue_sz, type) \
+static uint32_t os_mailQ_pool_##name[(queue_sz) * ((sizeof (type) + 3) / 4)]; \
+static void *os_mailQ_buffer_##name[queue_sz]; \
+static os_mailQ_cb_t os_mailQ_control_##name; \
+struct os_mailQ_cb *os_mailQ_cb_##name; \
+const osMailQDef_t os_mailQ_def_##name =  \
+{ (queue_sz), sizeof (type), (&os_mailQ_cb_##name), \
+  os_mailQ_pool_##name, (uint8_t *)os_mailQ_buffer_##name, &os_mailQ_control_##name }
+#else
 #define osMailQDef(name, queue_sz, type) \
 struct os_mailQ_cb *os_mailQ_cb_##name; \
 const osMailQDef_t os_mailQ_def_##name =  \
 { (queue_sz), sizeof (type), (&os_mailQ_cb_##name) }
 #endif
+#endif
 
 /// \brief Access a Mail Queue Definition.
 /// \param         name          name of the queue
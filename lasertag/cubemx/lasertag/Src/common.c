@@ -10,6 +10,8 @@
   */
 	
 #include "stm32f0xx_hal.h"
+#include "FreeRTOS.h"
+#include "task.h"
 #include "common.h"
 
 
@@ -23,8 +25,55 @@ void Error_Handler(void)
   
 	while (1)
   {
-		HAL_GPIO_TogglePin(LD4_GPIO_Port, LD4_Pin); //blue
+		PIN_TOGGLE(LD4); //blue
 	  HAL_Delay(100);
   }
 	
 }
+
+
+/**	CRC-16/CCITT (poly 0x1021), bitwise - no table in 64kB flash
+
+		Crc = CRC16_Calc(CRC16_INIT, pData, Size);
+		Crc = CRC16_Calc(Crc, pMore, MoreSize);		// continue over next block
+*/
+uint16_t CRC16_Calc(uint16_t Crc, const uint8_t *pData, uint32_t Size)
+{
+	uint8_t i;
+	
+	while (Size--)
+	{
+		Crc ^= (uint16_t)(*pData++) << 8;
+		for (i = 0; i < 8; i++)
+		{
+			if (Crc & 0x8000)
+				Crc = (Crc << 1) ^ 0x1021;
+			else
+				Crc <<= 1;
+		}
+	}
+	
+	return Crc;
+}
+
+
+/**	Task notification value is a set of event bits shared by ISRs and
+		the storage task. Waiting for one bit must not lose the others:
+		they are re-notified so the next wait sees them immediately.
+		Timeout restarts on a foreign bit.
+*/
+uint32_t NOTIFY_Wait(uint32_t Bits, uint32_t Timeout)
+{
+	uint32_t Value;
+	
+	do
+	{
+		if (xTaskNotifyWait(0, Bits, &Value, Timeout) == pdFALSE)
+			return 0;
+	} while ((Value & Bits) == 0);
+	
+	if (Value & ~Bits)
+		xTaskNotify(xTaskGetCurrentTaskHandle(), Value & ~Bits, eSetBits);
+	
+	return Value & Bits;
+}
@@ -0,0 +1,215 @@
+/**
+  ******************************************************************************
+  * File Name          : flash_cache.c
+  * Description        : RAM line cache with read-ahead over the serial flash
+  ******************************************************************************
+  * author: Tomas Krejci <info@tomaskrejci.com>
+  *
+  *
+  ******************************************************************************
+  */
+#include <string.h>
+#include "main.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "flash_cache.h"
+
+#define CACHE_INVALID				0xFFFFFFFF
+#define CACHE_LINE(Address)	((Address) & ~(uint32_t)(FLASH_CACHE_LINE_SIZE - 1))
+
+typedef struct
+{
+	uint32_t Address;				/*!< line aligned flash address, CACHE_INVALID = empty */
+	uint32_t Used;					/*!< CacheClock at last use, LRU */
+	uint8_t  Prefetched;		/*!< filled by read-ahead, not used yet */
+} FLASH_CACHE_LineTypeDef;
+
+static FLASH_CACHE_LineTypeDef CacheLine[FLASH_CACHE_LINES];
+static uint8_t CacheData[FLASH_CACHE_LINES][FLASH_CACHE_LINE_SIZE];
+static uint32_t CacheClock;
+// end of last read, sequential stream detection
+static uint32_t CacheNext = CACHE_INVALID;
+// line to read ahead, CACHE_INVALID = none
+static volatile uint32_t CachePrefetch = CACHE_INVALID;
+
+FLASH_CACHE_StatsTypeDef FLASH_CACHE_Stats;
+
+
+static int8_t FLASH_CACHE_Find(uint32_t Line)
+{
+	int8_t i;
+	
+	for (i = 0; i < FLASH_CACHE_LINES; i++)
+		if (CacheLine[i].Address == Line)
+			return i;
+	
+	return -1;
+}
+
+/**		Copy from cached lines, scheduler locked by caller
+			retval: TRUE whole block in cache
+*/
+static uint8_t FLASH_CACHE_Copy(uint32_t Address, uint8_t *pData, uint32_t Size)
+{
+	uint32_t Offset, Part;
+	int8_t i;
+	
+	// all lines present first, no partial copy on miss
+	for (Offset = CACHE_LINE(Address); Offset < Address + Size; Offset += FLASH_CACHE_LINE_SIZE)
+		if (FLASH_CACHE_Find(Offset) < 0)
+			return FALSE;
+	
+	while (Size != 0)
+	{
+		i = FLASH_CACHE_Find(CACHE_LINE(Address));
+		Offset = Address - CacheLine[i].Address;
+		Part = FLASH_CACHE_LINE_SIZE - Offset;
+		if (Part > Size)
+			Part = Size;
+		
+		memcpy(pData, &CacheData[i][Offset], Part);
+		CacheLine[i].Used = ++CacheClock;
+		if (CacheLine[i].Prefetched)
+		{
+			CacheLine[i].Prefetched = FALSE;
+			FLASH_CACHE_Stats.PrefetchHit++;
+		}
+		
+		Address += Part;
+		pData += Part;
+		Size -= Part;
+	}
+	
+	return TRUE;
+}
+
+/**		Sequential read -> mark line after the block for read-ahead
+*/
+static void FLASH_CACHE_Stream(uint32_t Address, uint32_t Size)
+{
+	uint32_t Line = CACHE_LINE(Address + Size - 1) + FLASH_CACHE_LINE_SIZE;
+	
+	if (Address == CacheNext && FLASH_CACHE_Find(Line) < 0)
+		CachePrefetch = Line;
+	CacheNext = Address + Size;
+}
+
+/**		Try to serve read from RAM, any task
+			retval: TRUE done, FALSE go to storage task
+*/
+uint8_t FLASH_CACHE_Lookup(uint32_t Address, uint8_t *pData, uint32_t Size)
+{
+	uint8_t Hit;
+	
+	if (Size == 0 || Size > FLASH_CACHE_LINE_SIZE)
+		return FALSE;
+	
+	vTaskSuspendAll();
+	Hit = FLASH_CACHE_Copy(Address, pData, Size);
+	if (Hit)
+	{
+		FLASH_CACHE_Stats.Hit++;
+		FLASH_CACHE_Stream(Address, Size);
+	}
+	xTaskResumeAll();
+	
+	return Hit;
+}
+
+/**		Load line into least recently used slot, storage task
+*/
+static uint8_t FLASH_CACHE_Fill(uint32_t Line, uint8_t Prefetched)
+{
+	uint8_t Result;
+	int8_t i, Victim = 0;
+	
+	for (i = 1; i < FLASH_CACHE_LINES; i++)
+		if (CacheLine[i].Used < CacheLine[Victim].Used)
+			Victim = i;
+	
+	// invalid while filled, lookups skip it
+	vTaskSuspendAll();
+	CacheLine[Victim].Address = CACHE_INVALID;
+	xTaskResumeAll();
+	
+	Result = BSP_SERIAL_FLASH_ReadData(Line, CacheData[Victim], FLASH_CACHE_LINE_SIZE);
+	if (Result != FLASH_OK)
+		return Result;
+	
+	vTaskSuspendAll();
+	CacheLine[Victim].Address = Line;
+	CacheLine[Victim].Used = ++CacheClock;
+	CacheLine[Victim].Prefetched = Prefetched;
+	xTaskResumeAll();
+	
+	return FLASH_OK;
+}
+
+/**		Read through cache, storage task
+			Blocks bigger than a line go to flash directly.
+*/
+uint8_t FLASH_CACHE_Read(uint32_t Address, uint8_t *pData, uint32_t Size)
+{
+	uint32_t Line;
+	uint8_t Hit;
+	
+	if (Size == 0)
+		return FLASH_OK;
+	if (Size > FLASH_CACHE_LINE_SIZE)
+		return BSP_SERIAL_FLASH_ReadData(Address, pData, Size);
+	
+	for (Line = CACHE_LINE(Address); Line < Address + Size; Line += FLASH_CACHE_LINE_SIZE)
+	{
+		if (FLASH_CACHE_Find(Line) < 0 && FLASH_CACHE_Fill(Line, FALSE) != FLASH_OK)
+			return FLASH_ERROR;
+	}
+	
+	vTaskSuspendAll();
+	Hit = FLASH_CACHE_Copy(Address, pData, Size);
+	FLASH_CACHE_Stats.Miss++;
+	FLASH_CACHE_Stream(Address, Size);
+	xTaskResumeAll();
+	
+	return Hit ? FLASH_OK : FLASH_ERROR;
+}
+
+/**		TRUE read-ahead line waiting
+*/
+uint8_t FLASH_CACHE_Pending(void)
+{
+	return CachePrefetch != CACHE_INVALID;
+}
+
+/**		Fill read-ahead line, storage task when idle
+*/
+void FLASH_CACHE_Prefetch(void)
+{
+	uint32_t Line = CachePrefetch;
+	
+	CachePrefetch = CACHE_INVALID;
+	if (Line == CACHE_INVALID || FLASH_CACHE_Find(Line) >= 0)
+		return;
+	
+	if (FLASH_CACHE_Fill(Line, TRUE) == FLASH_OK)
+		FLASH_CACHE_Stats.Prefetch++;
+}
+
+/**		Drop all lines, flash content changed
+*/
+void FLASH_CACHE_Invalidate(void)
+{
+	uint8_t i;
+	
+	vTaskSuspendAll();
+	for (i = 0; i < FLASH_CACHE_LINES; i++)
+	{
+		CacheLine[i].Address = CACHE_INVALID;
+		CacheLine[i].Used = 0;
+		CacheLine[i].Prefetched = FALSE;
+	}
+	CacheNext = CACHE_INVALID;
+	CachePrefetch = CACHE_INVALID;
+	xTaskResumeAll();
+}
+
+/*****************************END OF FILE************************************/
@@ -37,27 +37,103 @@
 #include "cmsis_os.h"
 
 /* USER CODE BEGIN Includes */     
+#include "common.h"
+#include "lasertag_ir.h"
+#include "lasertag_game.h"
+#include "lasertag_audio.h"
+#include "lasertag_storage.h"
+#include "lasertag_led.h"
 
 /* USER CODE END Includes */
 
 /* Variables -----------------------------------------------------------------*/
-osThreadId defaultTaskHandle;
 
 /* USER CODE BEGIN Variables */
+/**		task set, static stacks [words]
+
+			task			priority				stack		wakes on
+			game			High						68			game queue (hit, trigger), deadlines
+			audio			AboveNormal			108			audio queue, TIM15 half buffer notification
+			storage		AboveNormal			204			storage queue (flash jobs, pc link packets
+																				queued by USART RX DMA complete)
+			led				Low							58			activity notification, blink timing
+
+			IR RX decodes in the EXTI interrupt, IR TX runs from TIM16 interrupts,
+			the pc link packets run as storage jobs. An IR RX task would add a
+			queue hop and a switch to every hit, the pc link commands need the
+			storage stack (FatFs, FTL merge), a task of their own would double
+			it. Neither fits the RAM budget (lasertag_config.h).
+			Hit path EXTI -> game never waits for flash or pc link, worst case
+			hit response is measured in LASERTAG_GAME_Stats, estimated by
+			pc/test "make hit" (~16 us alone, ~25 us behind a shot, without
+			exception entry and PendSV), a LASERTAG_TRACE build with
+			LASERTAG_TRACE_HOLD_HIT keeps the worst one for pc/trace2json.
+			LASERTAG_TRACE builds run without the led task, its RAM holds the
+			trace ring.
+			Stack = worst case call path of pc/test "make ram" + 16 words
+			(game 208 B, audio 356 B, storage 744 B on f_open -> FTL merge,
+			led 168 B, idle 144 B, all with context and overflow check
+			pattern). Check the high water marks of the LASERTAG_DIAG report
+			after a full load run, keep at least 16 words free.
+			defaultTask of lasertag.ioc is not created, delete it in CubeMX
+			before generating code.
+*/
+osThreadId gameTaskHandle;
+uint32_t gameTaskBuffer[ 68 ];
+osStaticThreadDef_t gameTaskControlBlock;
+osThreadId audioTaskHandle;
+uint32_t audioTaskBuffer[ 108 ];
+osStaticThreadDef_t audioTaskControlBlock;
+osThreadId storageTaskHandle;
+uint32_t storageTaskBuffer[ 204 ];
+osStaticThreadDef_t storageTaskControlBlock;
+osThreadId ledTaskHandle;
+#if !LASERTAG_TRACE
+uint32_t ledTaskBuffer[ 58 ];
+osStaticThreadDef_t ledTaskControlBlock;
+#endif
 
 /* USER CODE END Variables */
 
 /* Function prototypes -------------------------------------------------------*/
-void StartDefaultTask(void const * argument);
 
 void MX_FREERTOS_Init(void); /* (MISRA C 2004 rule 8.1) */
 
 /* USER CODE BEGIN FunctionPrototypes */
+/* Hook prototypes */
+void vApplicationStackOverflowHook(xTaskHandle xTask, signed char *pcTaskName);
+
+/* GetIdleTaskMemory prototype (linked to static allocation support) */
+void vApplicationGetIdleTaskMemory( StaticTask_t **ppxIdleTaskTCBBuffer, StackType_t **ppxIdleTaskStackBuffer, uint32_t *pulIdleTaskStackSize );
 
 /* USER CODE END FunctionPrototypes */
 
 /* Hook prototypes */
 
+/* USER CODE BEGIN 4 */
+void vApplicationStackOverflowHook(xTaskHandle xTask, signed char *pcTaskName)
+{
+   /* Run time stack overflow checking is performed if
+   configCHECK_FOR_STACK_OVERFLOW is defined to 1 or 2. This hook function is
+   called if a stack overflow is detected. */
+  (void) xTask;
+  (void) pcTaskName;
+  Error_Handler();
+}
+/* USER CODE END 4 */
+
+/* USER CODE BEGIN GET_IDLE_TASK_MEMORY */
+static StaticTask_t xIdleTaskTCBBuffer;
+static StackType_t xIdleStack[LASERTAG_IDLE_STACK_SIZE];
+  
+void vApplicationGetIdleTaskMemory( StaticTask_t **ppxIdleTaskTCBBuffer, StackType_t **ppxIdleTaskStackBuffer, uint32_t *pulIdleTaskStackSize )
+{
+  *ppxIdleTaskTCBBuffer = &xIdleTaskTCBBuffer;
+  *ppxIdleTaskStackBuffer = &xIdleStack[0];
+  *pulIdleTaskStackSize = LASERTAG_IDLE_STACK_SIZE;
+}
+/* USER CODE END GET_IDLE_TASK_MEMORY */
+
 /* Init FreeRTOS */
 
 void MX_FREERTOS_Init(void) {
@@ -78,32 +154,33 @@ void MX_FREERTOS_Init(void) {
   /* USER CODE END RTOS_TIMERS */
 
   /* Create the thread(s) */
-  /* definition and creation of defaultTask */
-  osThreadDef(defaultTask, StartDefaultTask, osPriorityNormal, 0, 128);
-  defaultTaskHandle = osThreadCreate(osThread(defaultTask), NULL);
 
   /* USER CODE BEGIN RTOS_THREADS */
   /* add threads, ... */
+  osThreadStaticDef(gameTask, LASERTAG_GAME_Task, osPriorityHigh, 0, 68, gameTaskBuffer, &gameTaskControlBlock);
+  gameTaskHandle = osThreadCreate(osThread(gameTask), NULL);
+
+  osThreadStaticDef(audioTask, LASERTAG_AUDIO_Task, osPriorityAboveNormal, 0, 108, audioTaskBuffer, &audioTaskControlBlock);
+  audioTaskHandle = osThreadCreate(osThread(audioTask), NULL);
+
+  osThreadStaticDef(storageTask, LASERTAG_STORAGE_Task, osPriorityAboveNormal, 0, 204, storageTaskBuffer, &storageTaskControlBlock);
+  storageTaskHandle = osThreadCreate(osThread(storageTask), NULL);
+
+#if !LASERTAG_TRACE
+  osThreadStaticDef(ledTask, LASERTAG_LED_Task, osPriorityLow, 0, 58, ledTaskBuffer, &ledTaskControlBlock);
+  ledTaskHandle = osThreadCreate(osThread(ledTask), NULL);
+#endif
   /* USER CODE END RTOS_THREADS */
 
   /* USER CODE BEGIN RTOS_QUEUES */
   /* add queues, ... */
+  LASERTAG_STORAGE_Init();
+  LASERTAG_IR_Init();
+  LASERTAG_GAME_Init();
+  LASERTAG_AUDIO_Init();
   /* USER CODE END RTOS_QUEUES */
 }
 
-/* StartDefaultTask function */
-void StartDefaultTask(void const * argument)
-{
-
-  /* USER CODE BEGIN StartDefaultTask */
-  /* Infinite loop */
-  for(;;)
-  {
-    osDelay(1);
-  }
-  /* USER CODE END StartDefaultTask */
-}
-
 /* USER CODE BEGIN Application */
      
 /* USER CODE END Application */
@@ -0,0 +1,609 @@
+/**
+  ******************************************************************************
+  * File Name          : ftl.c
+  * Description        : flash translation layer, 512B sectors for FatFs
+  ******************************************************************************
+  * author: Tomas Krejci <info@tomaskrejci.com>
+  *
+  *
+  ******************************************************************************
+  */
+#include <string.h>
+#include "main.h"
+#include "ftl.h"
+
+#define FTL_MAGIC					0x4C54464D //"MFTL"
+#define FTL_NONE					0xFFFF
+#define FTL_NO_ADDRESS		0xFFFFFFFF
+#define FTL_SLOT_SIZE			8
+#define FTL_HEAD_OFFSET		(FTL_MAP_PER_BLOCK * FTL_MAP_ENTRY_SIZE)
+#define FTL_HEAD_SIZE			12
+#define FTL_COPY_SIZE			64		//multiple of FTL_MAP_ENTRY_SIZE
+#define FTL_LOOKUP_CNT		8
+
+// all logical blocks must have a map entry
+typedef char FTL_SizeCheck[(FTL_LOGICAL_BLOCKS <= FTL_MAP_PARTS * FTL_MAP_PER_BLOCK) ? 1 : -1];
+
+typedef struct
+{
+	uint16_t Lb;
+	uint16_t Pb;
+} FTL_LookupTypeDef;
+
+// 1 = data block not mapped (erased or stale)
+static uint8_t FtlFree[(FTL_BLOCKS + 7) / 8];
+// active map block and its sequence per map part
+static uint16_t FtlMap[FTL_MAP_PARTS];
+static uint32_t FtlMapSeq[FTL_MAP_PARTS];
+// newest slot sequence
+static uint32_t FtlSeq;
+// round robin allocation and wear leveling position
+static uint16_t FtlNext;
+static uint16_t FtlCold;
+static uint16_t FtlAllocCnt;
+// recently used map entries
+static FTL_LookupTypeDef FtlLookup[FTL_LOOKUP_CNT];
+static uint8_t FtlLookupNext;
+// open replacement block
+static uint16_t FtlOpenLb = FTL_NONE;
+static uint16_t FtlOpenPb;
+static uint16_t FtlOpenOld;
+static uint8_t FtlOpenWritten;
+// copy / scan buffer
+static uint8_t FtlBuf[FTL_COPY_SIZE];
+
+FTL_StatsTypeDef FTL_Stats;
+
+static uint8_t FTL_Close(void);
+
+
+static uint32_t FTL_Address(uint16_t Pb)
+{
+	return LASERTAG_ADR_LOG + (uint32_t)Pb * FTL_BLOCK_SIZE;
+}
+
+static uint32_t FTL_EntryAddress(uint16_t Lb)
+{
+	return FTL_Address(FtlMap[Lb / FTL_MAP_PER_BLOCK]) + (uint32_t)(Lb % FTL_MAP_PER_BLOCK) * FTL_MAP_ENTRY_SIZE;
+}
+
+static uint8_t FTL_IsFree(uint16_t Pb)
+{
+	return (FtlFree[Pb >> 3] >> (Pb & 7)) & 1;
+}
+
+static void FTL_SetFree(uint16_t Pb, uint8_t Free)
+{
+	if (Free)
+		FtlFree[Pb >> 3] |= 1 << (Pb & 7);
+	else
+		FtlFree[Pb >> 3] &= ~(1 << (Pb & 7));
+}
+
+static uint8_t FTL_Erase(uint16_t Pb)
+{
+	FTL_Stats.Erase++;
+	return BSP_SERIAL_FLASH_EraseSector(FTL_Address(Pb));
+}
+
+/**		TRUE whole area erased (0xFF)
+*/
+static uint8_t FTL_Blank(uint32_t Address, uint32_t Size)
+{
+	uint32_t Part, i;
+
+	while (Size != 0)
+	{
+		Part = (Size < FTL_COPY_SIZE) ? Size : FTL_COPY_SIZE;
+		if (BSP_SERIAL_FLASH_ReadData(Address, FtlBuf, Part) != FLASH_OK)
+			return FALSE;
+		for (i = 0; i < Part; i++)
+			if (FtlBuf[i] != 0xFF)
+				return FALSE;
+
+		Address += Part;
+		Size -= Part;
+	}
+
+	return TRUE;
+}
+
+/**		Decode map entry
+			retval: data block of last valid slot, FTL_NONE = not mapped
+			*pSlot first empty slot (FTL_MAP_SLOTS = full), *pSeq its sequence
+*/
+static uint16_t FTL_Entry(const uint8_t *pEntry, uint8_t *pSlot, uint32_t *pSeq)
+{
+	uint16_t Pb = FTL_NONE, Value, Check;
+	uint8_t i;
+
+	for (i = 0; i < FTL_MAP_SLOTS; i++, pEntry += FTL_SLOT_SIZE)
+	{
+		Value = pEntry[0] | ((uint16_t)pEntry[1] << 8);
+		Check = pEntry[2] | ((uint16_t)pEntry[3] << 8);
+
+		// slots are programmed in order, erased = end
+		if (Value == 0xFFFF && Check == 0xFFFF)
+			break;
+		// torn slot is skipped, it stays used
+		if (Value != (uint16_t)~Check)
+			continue;
+
+		Pb = Value;
+		if (pSeq != NULL)
+			*pSeq = pEntry[4] | ((uint32_t)pEntry[5] << 8) | ((uint32_t)pEntry[6] << 16) | ((uint32_t)pEntry[7] << 24);
+	}
+
+	if (pSlot != NULL)
+		*pSlot = i;
+	return Pb;
+}
+
+static void FTL_Slot(uint8_t *pSlot, uint16_t Pb, uint32_t Seq)
+{
+	pSlot[0] = (uint8_t)(Pb);
+	pSlot[1] = (uint8_t)(Pb >> 8);
+	pSlot[2] = (uint8_t)(~Pb);
+	pSlot[3] = (uint8_t)(~Pb >> 8);
+	pSlot[4] = (uint8_t)(Seq);
+	pSlot[5] = (uint8_t)(Seq >> 8);
+	pSlot[6] = (uint8_t)(Seq >> 16);
+	pSlot[7] = (uint8_t)(Seq >> 24);
+}
+
+/**		Map block header, CRC guards against data that looks like one
+			retval: TRUE valid, *pPart map part, *pSeq sequence
+*/
+static uint8_t FTL_ReadHead(uint16_t Pb, uint8_t *pPart, uint32_t *pSeq)
+{
+	uint8_t Head[FTL_HEAD_SIZE];
+
+	if (BSP_SERIAL_FLASH_ReadData(FTL_Address(Pb) + FTL_HEAD_OFFSET, Head, sizeof(Head)) != FLASH_OK)
+		return FALSE;
+	if ((Head[0] | ((uint32_t)Head[1] << 8) | ((uint32_t)Head[2] << 16) | ((uint32_t)Head[3] << 24)) != FTL_MAGIC)
+		return FALSE;
+	if ((CRC16_Calc(CRC16_INIT, Head, 10) != (Head[10] | ((uint16_t)Head[11] << 8))) ||
+			(Head[8] != (uint8_t)~Head[9]) || (Head[8] >= FTL_MAP_PARTS))
+		return FALSE;
+
+	*pSeq = Head[4] | ((uint32_t)Head[5] << 8) | ((uint32_t)Head[6] << 16) | ((uint32_t)Head[7] << 24);
+	*pPart = Head[8];
+	return TRUE;
+}
+
+static uint8_t FTL_WriteHead(uint16_t Pb, uint8_t Part, uint32_t Seq)
+{
+	uint8_t Head[FTL_HEAD_SIZE];
+	uint16_t Crc;
+
+	Head[0] = (uint8_t)(FTL_MAGIC);
+	Head[1] = (uint8_t)(FTL_MAGIC >> 8);
+	Head[2] = (uint8_t)(FTL_MAGIC >> 16);
+	Head[3] = (uint8_t)(FTL_MAGIC >> 24);
+	Head[4] = (uint8_t)(Seq);
+	Head[5] = (uint8_t)(Seq >> 8);
+	Head[6] = (uint8_t)(Seq >> 16);
+	Head[7] = (uint8_t)(Seq >> 24);
+	Head[8] = Part;
+	Head[9] = (uint8_t)~Part;
+	Crc = CRC16_Calc(CRC16_INIT, Head, 10);
+	Head[10] = (uint8_t)(Crc);
+	Head[11] = (uint8_t)(Crc >> 8);
+
+	return BSP_SERIAL_FLASH_WriteData(FTL_Address(Pb) + FTL_HEAD_OFFSET, Head, sizeof(Head));
+}
+
+static void FTL_LookupSet(uint16_t Lb, uint16_t Pb)
+{
+	uint8_t i;
+
+	for (i = 0; i < FTL_LOOKUP_CNT; i++)
+	{
+		if (FtlLookup[i].Lb == Lb)
+		{
+			FtlLookup[i].Pb = Pb;
+			return;
+		}
+	}
+
+	FtlLookup[FtlLookupNext].Lb = Lb;
+	FtlLookup[FtlLookupNext].Pb = Pb;
+	FtlLookupNext = (FtlLookupNext + 1) % FTL_LOOKUP_CNT;
+}
+
+/**		Logical -> data block, FTL_NONE = never written
+*/
+static uint16_t FTL_Lookup(uint16_t Lb)
+{
+	uint8_t Entry[FTL_MAP_ENTRY_SIZE];
+	uint16_t Pb;
+	uint8_t i;
+
+	for (i = 0; i < FTL_LOOKUP_CNT; i++)
+		if (FtlLookup[i].Lb == Lb)
+			return FtlLookup[i].Pb;
+
+	if (BSP_SERIAL_FLASH_ReadData(FTL_EntryAddress(Lb), Entry, sizeof(Entry)) != FLASH_OK)
+		return FTL_NONE;
+
+	Pb = FTL_Entry(Entry, NULL, NULL);
+	FTL_LookupSet(Lb, Pb);
+
+	return Pb;
+}
+
+static uint16_t FTL_Alloc(void);
+
+/**		Copy newest slot of each entry into a new block from the pool,
+			Lb gets Pb on the way. Map blocks rotate with data blocks.
+*/
+static uint8_t FTL_MapCompact(uint8_t MapPart, uint16_t Lb, uint16_t Pb)
+{
+	uint16_t Old = FtlMap[MapPart], New;
+	uint16_t Offset, Part, i, Entry, Value;
+	uint32_t Seq;
+	uint8_t Blank;
+
+	New = FTL_Alloc();
+	if (New == FTL_NONE)
+		return FTL_ERROR;
+
+	for (Offset = 0; Offset < FTL_HEAD_OFFSET; Offset += Part)
+	{
+		Part = (FTL_HEAD_OFFSET - Offset < FTL_COPY_SIZE) ? FTL_HEAD_OFFSET - Offset : FTL_COPY_SIZE;
+		if (BSP_SERIAL_FLASH_ReadData(FTL_Address(Old) + Offset, FtlBuf, Part) != FLASH_OK)
+			return FTL_ERROR;
+
+		Blank = TRUE;
+		for (i = 0; i < Part; i += FTL_MAP_ENTRY_SIZE)
+		{
+			Entry = MapPart * FTL_MAP_PER_BLOCK + (Offset + i) / FTL_MAP_ENTRY_SIZE;
+			Seq = 0;
+			Value = FTL_Entry(&FtlBuf[i], NULL, &Seq);
+			if (Entry == Lb)
+			{
+				Value = Pb;
+				Seq = ++FtlSeq;
+			}
+
+			memset(&FtlBuf[i], 0xFF, FTL_MAP_ENTRY_SIZE);
+			if (Value != FTL_NONE)
+			{
+				FTL_Slot(&FtlBuf[i], Value, Seq);
+				Blank = FALSE;
+			}
+		}
+
+		if (!Blank && BSP_SERIAL_FLASH_WriteData(FTL_Address(New) + Offset, FtlBuf, Part) != FLASH_OK)
+			return FTL_ERROR;
+	}
+
+	// header last - until now old block stays active
+	if (FTL_WriteHead(New, MapPart, FtlMapSeq[MapPart] + 1) != FLASH_OK)
+		return FTL_ERROR;
+
+	FtlMapSeq[MapPart]++;
+	FtlMap[MapPart] = New;
+	FTL_LookupSet(Lb, Pb);
+
+	// old header must not survive into a data block
+	if (FTL_Erase(Old) == FLASH_OK)
+		FTL_SetFree(Old, TRUE);
+	FTL_Stats.MapCompact++;
+
+	return FTL_OK;
+}
+
+/**		Map logical block to data block, one slot program
+*/
+static uint8_t FTL_MapSet(uint16_t Lb, uint16_t Pb)
+{
+	uint8_t Entry[FTL_MAP_ENTRY_SIZE];
+	uint8_t Slot;
+
+	if (BSP_SERIAL_FLASH_ReadData(FTL_EntryAddress(Lb), Entry, sizeof(Entry)) != FLASH_OK)
+		return FTL_ERROR;
+
+	FTL_Entry(Entry, &Slot, NULL);
+	if (Slot >= FTL_MAP_SLOTS)
+		return FTL_MapCompact(Lb / FTL_MAP_PER_BLOCK, Lb, Pb);
+
+	FTL_Slot(Entry, Pb, ++FtlSeq);
+	if (BSP_SERIAL_FLASH_WriteData(FTL_EntryAddress(Lb) + Slot * FTL_SLOT_SIZE, Entry, FTL_SLOT_SIZE) != FLASH_OK)
+		return FTL_ERROR;
+
+	FTL_LookupSet(Lb, Pb);
+	return FTL_OK;
+}
+
+/**		Next free data block round robin, erased if needed
+*/
+static uint16_t FTL_Alloc(void)
+{
+	uint16_t Pb, i;
+
+	for (i = 0; i < FTL_BLOCKS; i++)
+	{
+		Pb = FtlNext;
+		FtlNext = (FtlNext + 1 < FTL_BLOCKS) ? FtlNext + 1 : 0;
+		if (!FTL_IsFree(Pb))
+			continue;
+
+		if (!FTL_Blank(FTL_Address(Pb), FTL_BLOCK_SIZE) && FTL_Erase(Pb) != FLASH_OK)
+			continue;
+
+		FTL_SetFree(Pb, FALSE);
+		FtlAllocCnt++;
+		return Pb;
+	}
+
+	return FTL_NONE;
+}
+
+/**		Start replacement block for Lb
+*/
+static uint8_t FTL_Open(uint16_t Lb)
+{
+	FtlOpenOld = FTL_Lookup(Lb);
+	FtlOpenPb = FTL_Alloc();
+	if (FtlOpenPb == FTL_NONE)
+		return FTL_ERROR;
+
+	FtlOpenLb = Lb;
+	FtlOpenWritten = 0;
+	return FTL_OK;
+}
+
+/**		Move one more logical block, every block gets back to the pool
+*/
+static uint8_t FTL_WearMove(void)
+{
+	uint16_t Lb = FtlCold;
+
+	FtlCold = (FtlCold + 1 < FTL_LOGICAL_BLOCKS) ? FtlCold + 1 : 0;
+	if (FTL_Lookup(Lb) == FTL_NONE)
+		return FTL_OK;
+
+	FTL_Stats.WearMove++;
+	if (FTL_Open(Lb) != FTL_OK)
+		return FTL_ERROR;
+	return FTL_Close();
+}
+
+/**		Copy sectors not written from the old block, switch map
+*/
+static uint8_t FTL_Close(void)
+{
+	uint32_t Offset, Part, i;
+	uint8_t Sector, Copied;
+
+	if (FtlOpenLb == FTL_NONE)
+		return FTL_OK;
+
+	for (Sector = 0; Sector < FTL_BLOCK_SECTORS && FtlOpenOld != FTL_NONE; Sector++)
+	{
+		if (FtlOpenWritten & (1 << Sector))
+			continue;
+
+		Copied = FALSE;
+		for (Offset = Sector * FTL_SECTOR_SIZE; Offset < (Sector + 1) * FTL_SECTOR_SIZE; Offset += Part)
+		{
+			Part = FTL_COPY_SIZE;
+			if (BSP_SERIAL_FLASH_ReadData(FTL_Address(FtlOpenOld) + Offset, FtlBuf, Part) != FLASH_OK)
+				return FTL_ERROR;
+
+			// erased part stays erased
+			for (i = 0; i < Part && FtlBuf[i] == 0xFF; i++);
+			if (i == Part)
+				continue;
+
+			if (BSP_SERIAL_FLASH_WriteData(FTL_Address(FtlOpenPb) + Offset, FtlBuf, Part) != FLASH_OK)
+				return FTL_ERROR;
+			Copied = TRUE;
+		}
+
+		if (Copied)
+			FTL_Stats.FlashWrite++;
+	}
+
+	if (FTL_MapSet(FtlOpenLb, FtlOpenPb) != FTL_OK)
+		return FTL_ERROR;
+
+	if (FtlOpenOld != FTL_NONE)
+		FTL_SetFree(FtlOpenOld, TRUE);
+	FtlOpenLb = FTL_NONE;
+
+	if (FtlAllocCnt >= FTL_WEAR_INTERVAL)
+	{
+		FtlAllocCnt = 0;
+		return FTL_WearMove();
+	}
+
+	return FTL_OK;
+}
+
+/**		Find newest map block of each part, rebuild free block bitmap
+			from the map
+*/
+uint8_t FTL_Mount(void)
+{
+	uint32_t Seq, MaxSeq = 0;
+	uint16_t Offset, Part, i, Pb, Lb, MaxPb = FTL_NONE;
+	uint8_t MapPart;
+
+	FtlOpenLb = FTL_NONE;
+	for (i = 0; i < FTL_LOOKUP_CNT; i++)
+		FtlLookup[i].Lb = FTL_NONE;
+	for (MapPart = 0; MapPart < FTL_MAP_PARTS; MapPart++)
+		FtlMap[MapPart] = FTL_NONE;
+
+	// both valid = compaction finished, old block not erased -> newer wins
+	for (Pb = 0; Pb < FTL_BLOCKS; Pb++)
+	{
+		if (!FTL_ReadHead(Pb, &MapPart, &Seq))
+			continue;
+		if (FtlMap[MapPart] == FTL_NONE || (int32_t)(Seq - FtlMapSeq[MapPart]) > 0)
+		{
+			FtlMap[MapPart] = Pb;
+			FtlMapSeq[MapPart] = Seq;
+		}
+	}
+
+	memset(FtlFree, 0xFF, sizeof(FtlFree));
+	for (MapPart = 0; MapPart < FTL_MAP_PARTS; MapPart++)
+	{
+		if (FtlMap[MapPart] == FTL_NONE)
+			continue;
+		FTL_SetFree(FtlMap[MapPart], FALSE);
+
+		for (Offset = 0; Offset < FTL_HEAD_OFFSET; Offset += Part)
+		{
+			Part = (FTL_HEAD_OFFSET - Offset < FTL_COPY_SIZE) ? FTL_HEAD_OFFSET - Offset : FTL_COPY_SIZE;
+			if (BSP_SERIAL_FLASH_ReadData(FTL_Address(FtlMap[MapPart]) + Offset, FtlBuf, Part) != FLASH_OK)
+				return FTL_ERROR;
+
+			for (i = 0; i < Part; i += FTL_MAP_ENTRY_SIZE)
+			{
+				Lb = MapPart * FTL_MAP_PER_BLOCK + (Offset + i) / FTL_MAP_ENTRY_SIZE;
+				Pb = FTL_Entry(&FtlBuf[i], NULL, &Seq);
+				if (Lb >= FTL_LOGICAL_BLOCKS || Pb >= FTL_BLOCKS)
+					continue;
+
+				FTL_SetFree(Pb, FALSE);
+				if (MaxPb == FTL_NONE || (int32_t)(Seq - MaxSeq) > 0)
+				{
+					MaxSeq = Seq;
+					MaxPb = Pb;
+				}
+			}
+		}
+	}
+
+	// continue round robin after the newest block
+	FtlSeq = MaxSeq;
+	FtlNext = (MaxPb == FTL_NONE || MaxPb + 1 >= FTL_BLOCKS) ? 0 : MaxPb + 1;
+	FtlCold = (uint16_t)(FtlSeq % FTL_LOGICAL_BLOCKS);
+	FtlAllocCnt = 0;
+
+	// new volume (or part) - empty map block
+	for (MapPart = 0; MapPart < FTL_MAP_PARTS; MapPart++)
+	{
+		if (FtlMap[MapPart] != FTL_NONE)
+			continue;
+
+		FtlMap[MapPart] = FTL_Alloc();
+		FtlMapSeq[MapPart] = 1;
+		if (FtlMap[MapPart] == FTL_NONE || FTL_WriteHead(FtlMap[MapPart], MapPart, 1) != FLASH_OK)
+			return FTL_ERROR;
+	}
+
+	return FTL_OK;
+}
+
+/**		Flash address of sector, FTL_NO_ADDRESS = never written
+*/
+static uint32_t FTL_SectorAddress(uint32_t Sector)
+{
+	uint16_t Lb = Sector / FTL_BLOCK_SECTORS, Pb;
+	uint8_t Index = Sector % FTL_BLOCK_SECTORS;
+
+	if (Lb == FtlOpenLb)
+		Pb = (FtlOpenWritten & (1 << Index)) ? FtlOpenPb : FtlOpenOld;
+	else
+		Pb = FTL_Lookup(Lb);
+
+	if (Pb == FTL_NONE)
+		return FTL_NO_ADDRESS;
+	return FTL_Address(Pb) + Index * FTL_SECTOR_SIZE;
+}
+
+/**		Read sectors, never written sector reads as 0xFF
+			Contiguous sectors are read in one transfer.
+*/
+uint8_t FTL_Read(uint32_t Sector, uint8_t *pData, uint32_t Count)
+{
+	uint32_t Address, Run;
+
+	if (Sector >= FTL_SECTORS || Count > FTL_SECTORS - Sector)
+		return FTL_ERROR;
+	FTL_Stats.HostRead += Count;
+
+	for (; Count != 0; Count -= Run, Sector += Run, pData += Run * FTL_SECTOR_SIZE)
+	{
+		Address = FTL_SectorAddress(Sector);
+		Run = 1;
+
+		if (Address == FTL_NO_ADDRESS)
+		{
+			memset(pData, 0xFF, FTL_SECTOR_SIZE);
+			continue;
+		}
+
+		// physically contiguous sectors - one flash read (DMA)
+		while (Run < Count && FTL_SectorAddress(Sector + Run) == Address + Run * FTL_SECTOR_SIZE)
+			Run++;
+
+		FTL_Stats.FlashRead++;
+		if (BSP_SERIAL_FLASH_ReadData(Address, pData, Run * FTL_SECTOR_SIZE) != FLASH_OK)
+			return FTL_ERROR;
+	}
+
+	return FTL_OK;
+}
+
+/**		Write sectors: in place into erased space, else into open replacement block
+*/
+uint8_t FTL_Write(uint32_t Sector, const uint8_t *pData, uint32_t Count)
+{
+	uint16_t Lb, Pb;
+	uint8_t Index;
+
+	for (; Count != 0; Count--, Sector++, pData += FTL_SECTOR_SIZE)
+	{
+		if (Sector >= FTL_SECTORS)
+			return FTL_ERROR;
+
+		Lb = Sector / FTL_BLOCK_SECTORS;
+		Index = Sector % FTL_BLOCK_SECTORS;
+		FTL_Stats.HostWrite++;
+
+		// rewrite in open block or other block -> close it
+		if (FtlOpenLb != FTL_NONE && (FtlOpenLb != Lb || (FtlOpenWritten & (1 << Index))))
+		{
+			if (FTL_Close() != FTL_OK)
+				return FTL_ERROR;
+		}
+
+		if (FtlOpenLb == FTL_NONE)
+		{
+			Pb = FTL_Lookup(Lb);
+			if (Pb != FTL_NONE && FTL_Blank(FTL_Address(Pb) + Index * FTL_SECTOR_SIZE, FTL_SECTOR_SIZE))
+			{
+				if (BSP_SERIAL_FLASH_WriteData(FTL_Address(Pb) + Index * FTL_SECTOR_SIZE, (uint8_t *)pData, FTL_SECTOR_SIZE) != FLASH_OK)
+					return FTL_ERROR;
+				FTL_Stats.InPlace++;
+				FTL_Stats.FlashWrite++;
+				continue;
+			}
+
+			if (FTL_Open(Lb) != FTL_OK)
+				return FTL_ERROR;
+		}
+
+		if (BSP_SERIAL_FLASH_WriteData(FTL_Address(FtlOpenPb) + Index * FTL_SECTOR_SIZE, (uint8_t *)pData, FTL_SECTOR_SIZE) != FLASH_OK)
+			return FTL_ERROR;
+		FtlOpenWritten |= 1 << Index;
+		FTL_Stats.FlashWrite++;
+	}
+
+	return FTL_OK;
+}
+
+/**		Close open block - everything written is reachable after power loss
+*/
+uint8_t FTL_Sync(void)
+{
+	return FTL_Close();
+}
+
+/*****************************END OF FILE************************************/
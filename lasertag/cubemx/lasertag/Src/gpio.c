@@ -35,7 +35,8 @@
 /* Includes ------------------------------------------------------------------*/
 #include "gpio.h"
 /* USER CODE BEGIN 0 */
-
+#include "lasertag_ir.h"
+#include "lasertag_game.h"
 /* USER CODE END 0 */
 
 /*----------------------------------------------------------------------------*/
@@ -101,6 +102,47 @@ void MX_GPIO_Init(void)
 }
 
 /* USER CODE BEGIN 2 */
+/**
+  * @brief  Pins not in lasertag.ioc, called after MX_GPIO_Init
+  *         B1 trigger and IR receiver on EXTI0_1, DAC audio output
+  * @retval None
+  */
+void LASERTAG_GPIO_Init(void)
+{
+	GPIO_InitTypeDef GPIO_InitStruct;
+	
+	// B1 trigger, interrupt instead of event
+	GPIO_InitStruct.Pin = B1_Pin;
+	GPIO_InitStruct.Mode = GPIO_MODE_IT_RISING;
+	GPIO_InitStruct.Pull = GPIO_NOPULL;
+	HAL_GPIO_Init(B1_GPIO_Port, &GPIO_InitStruct);
+	
+	GPIO_InitStruct.Pin = IR_RX_Pin;
+	GPIO_InitStruct.Mode = GPIO_MODE_IT_RISING_FALLING;
+	GPIO_InitStruct.Pull = GPIO_PULLUP;
+	HAL_GPIO_Init(IR_RX_GPIO_Port, &GPIO_InitStruct);
+	
+	GPIO_InitStruct.Pin = AUDIO_OUT_Pin;
+	GPIO_InitStruct.Mode = GPIO_MODE_ANALOG;
+	GPIO_InitStruct.Pull = GPIO_NOPULL;
+	HAL_GPIO_Init(AUDIO_OUT_GPIO_Port, &GPIO_InitStruct);
+	
+	HAL_NVIC_SetPriority(EXTI0_1_IRQn, 3, 0);
+	HAL_NVIC_EnableIRQ(EXTI0_1_IRQn);
+}
+
+/**
+  * @brief  EXTI line detection callback
+  * @param  GPIO_Pin: pin of the EXTI line
+  * @retval None
+  */
+void HAL_GPIO_EXTI_Callback(uint16_t GPIO_Pin)
+{
+	if (GPIO_Pin == IR_RX_Pin)
+		LASERTAG_IR_EdgeCallback();
+	else if (GPIO_Pin == B1_Pin)
+		LASERTAG_GAME_TriggerCallback();
+}
 
 /* USER CODE END 2 */
 
@@ -0,0 +1,270 @@
+/**
+  ******************************************************************************
+  * File Name          : lasertag_audio.c
+  * Description        : sound playback from serial flash to DAC
+  ******************************************************************************
+  * author: Tomas Krejci <info@tomaskrejci.com>
+  *
+  *
+  ******************************************************************************
+  */
+#include "main.h"
+#include "cmsis_os.h"
+#include "lasertag_audio.h"
+#include "lasertag_setup.h"
+#include "lasertag_storage.h"
+#include "lasertag_power.h"
+#include "lasertag_diag.h"
+
+#define AUDIO_ENTRY_SIZE		8
+#define AUDIO_SILENCE				0x80
+// code bytes per storage read, 2 samples per byte
+#define AUDIO_BLOCK					64
+
+static const int16_t AudioStepTable[89] =
+{
+	7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+	50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230,
+	253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963,
+	1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327,
+	3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487,
+	12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+static const int8_t AudioIndexTable[8] = { -1, -1, -1, -1, 2, 4, 6, 8 };
+
+static QueueHandle_t AudioQueue;
+static StaticQueue_t AudioQueueBuffer;
+static uint8_t AudioQueueStorage[LASERTAG_AUDIO_QUEUE_LEN * sizeof(uint8_t)];
+
+// double buffer, ISR plays one half while the task fills the other
+static uint8_t AudioSample[2 * LASERTAG_AUDIO_HALF];
+static volatile uint16_t AudioIndex;
+
+static LASERTAG_AUDIO_DecoderTypeDef AudioDecoder;
+static uint32_t AudioAddress;
+static uint32_t AudioRemain;
+
+
+void LASERTAG_AUDIO_Init(void)
+{
+	AudioQueue = xQueueCreateStatic(LASERTAG_AUDIO_QUEUE_LEN, sizeof(uint8_t), AudioQueueStorage, &AudioQueueBuffer);
+	LASERTAG_DIAG_Queue(AudioQueue, LASERTAG_DIAG_QUEUE_AUDIO);
+}
+
+/**		Request sound of game event (LASERTAG_SOUND_x), replaces playing sound
+*/
+uint8_t LASERTAG_AUDIO_Play(uint8_t Event)
+{
+	return xQueueSend(AudioQueue, &Event, 0) == pdPASS;
+}
+
+/**		TIM15 update, 8kHz
+*/
+void LASERTAG_AUDIO_SampleCallback(void)
+{
+	BaseType_t Woken = pdFALSE;
+	
+	DAC->DHR8R1 = AudioSample[AudioIndex];
+	
+	if (++AudioIndex == 2 * LASERTAG_AUDIO_HALF)
+		AudioIndex = 0;
+	
+	if ((AudioIndex & (LASERTAG_AUDIO_HALF - 1)) == 0)
+	{
+		xTaskNotifyFromISR(audioTaskHandle, LASERTAG_AUDIO_NOTIFY_HALF, eSetBits, &Woken);
+		portYIELD_FROM_ISR(Woken);
+	}
+}
+
+static uint8_t LASERTAG_AUDIO_Nibble(LASERTAG_AUDIO_DecoderTypeDef *pDecoder, uint8_t Nibble)
+{
+	int32_t Step = AudioStepTable[pDecoder->StepIndex];
+	int32_t Diff = Step >> 3;
+	
+	if (Nibble & 4)
+		Diff += Step;
+	if (Nibble & 2)
+		Diff += Step >> 1;
+	if (Nibble & 1)
+		Diff += Step >> 2;
+	
+	if (Nibble & 8)
+		pDecoder->Predictor -= Diff;
+	else
+		pDecoder->Predictor += Diff;
+	
+	if (pDecoder->Predictor > 32767)
+		pDecoder->Predictor = 32767;
+	else if (pDecoder->Predictor < -32768)
+		pDecoder->Predictor = -32768;
+	
+	pDecoder->StepIndex += AudioIndexTable[Nibble & 7];
+	if (pDecoder->StepIndex < 0)
+		pDecoder->StepIndex = 0;
+	else if (pDecoder->StepIndex > 88)
+		pDecoder->StepIndex = 88;
+	
+	// 16 bit -> 8 bit unsigned with volume
+	return (uint8_t)(((pDecoder->Predictor * LASERTAG_Setup.Volume) >> 16) + AUDIO_SILENCE);
+}
+
+void LASERTAG_AUDIO_DecodeReset(LASERTAG_AUDIO_DecoderTypeDef *pDecoder)
+{
+	pDecoder->Predictor = 0;
+	pDecoder->StepIndex = 0;
+}
+
+/**		Decode Size code bytes into 2 * Size samples, low nibble first
+*/
+void LASERTAG_AUDIO_Decode(LASERTAG_AUDIO_DecoderTypeDef *pDecoder, const uint8_t *pCode, uint32_t Size, uint8_t *pOut)
+{
+	while (Size--)
+	{
+		*pOut++ = LASERTAG_AUDIO_Nibble(pDecoder, *pCode & 0x0F);
+		*pOut++ = LASERTAG_AUDIO_Nibble(pDecoder, *pCode++ >> 4);
+	}
+}
+
+/**		Decode next half buffer, rest filled with silence. Code is read in
+			AUDIO_BLOCK pieces, the task stack holds one piece only.
+			retval: FALSE sound finished
+*/
+static uint8_t LASERTAG_AUDIO_Fill(uint8_t *pOut)
+{
+	uint8_t Code[AUDIO_BLOCK];
+	uint32_t Size, Done, i;
+	uint8_t Res = FALSE;
+	
+	for (Done = 0; Done < LASERTAG_AUDIO_HALF / 2; Done += sizeof(Code))
+	{
+		Size = (AudioRemain < sizeof(Code)) ? AudioRemain : sizeof(Code);
+		
+		if (Size != 0 && LASERTAG_STORAGE_Read(AudioAddress, Code, Size) != FLASH_OK)
+			Size = 0;
+		
+		AudioAddress += Size;
+		AudioRemain = (Size != 0) ? AudioRemain - Size : 0;
+		
+		LASERTAG_AUDIO_Decode(&AudioDecoder, Code, Size, pOut);
+		pOut += 2 * Size;
+		
+		for (i = Size; i < sizeof(Code); i++)
+		{
+			*pOut++ = AUDIO_SILENCE;
+			*pOut++ = AUDIO_SILENCE;
+		}
+		
+		if (Size != 0)
+			Res = TRUE;
+	}
+	
+	return Res;
+}
+
+/**		Find sound of game event in directory
+			retval: TRUE AudioAddress/AudioRemain set
+*/
+static uint8_t LASERTAG_AUDIO_Open(uint8_t Event)
+{
+	uint8_t Entry[AUDIO_ENTRY_SIZE];
+	uint32_t Offset, Size;
+	uint8_t Slot;
+	
+	if (Event >= LASERTAG_SOUND_CNT)
+		return FALSE;
+	Slot = LASERTAG_Setup.SoundMap[Event];
+	if (Slot >= LASERTAG_AUDIO_SLOTS)
+		return FALSE;
+	
+	if (LASERTAG_STORAGE_Read(LASERTAG_ADR_AUDIO + Slot * AUDIO_ENTRY_SIZE, Entry, AUDIO_ENTRY_SIZE) != FLASH_OK)
+		return FALSE;
+	
+	Offset = Entry[0] | ((uint32_t)Entry[1] << 8) | ((uint32_t)Entry[2] << 16) | ((uint32_t)Entry[3] << 24);
+	Size = Entry[4] | ((uint32_t)Entry[5] << 8) | ((uint32_t)Entry[6] << 16) | ((uint32_t)Entry[7] << 24);
+	
+	if ((Size == 0) || (Offset >= LASERTAG_ADR_AUDIO_SIZE) || (Size > LASERTAG_ADR_AUDIO_SIZE - Offset))
+		return FALSE;
+	
+	AudioAddress = LASERTAG_ADR_AUDIO + Offset;
+	AudioRemain = Size;
+	LASERTAG_AUDIO_DecodeReset(&AudioDecoder);
+	
+	return TRUE;
+}
+
+static void LASERTAG_AUDIO_Start(void)
+{
+	LASERTAG_POWER_Hold(LASERTAG_POWER_HOLD_AUDIO);
+	
+	__HAL_RCC_DAC1_CLK_ENABLE();
+	DAC->CR = DAC_CR_EN1;
+	DAC->DHR8R1 = AUDIO_SILENCE;
+	
+	AudioIndex = 0;
+	TIM15->CNT = 0;
+	TIM15->SR = 0;
+	TIM15->DIER = TIM_DIER_UIE;
+	TIM15->CR1 = TIM_CR1_CEN;
+}
+
+static void LASERTAG_AUDIO_Stop(void)
+{
+	TIM15->CR1 = 0;
+	TIM15->DIER = 0;
+	
+	DAC->CR = 0;
+	__HAL_RCC_DAC1_CLK_DISABLE();
+	
+	// drop half notification of the stopped sound
+	xTaskNotifyWait(0, LASERTAG_AUDIO_NOTIFY_HALF, NULL, 0);
+	
+	LASERTAG_POWER_Release(LASERTAG_POWER_HOLD_AUDIO);
+}
+
+/**		Audio task - one sound at a time, new event replaces playing sound
+			within one half buffer (32ms)
+*/
+void LASERTAG_AUDIO_Task(void const *argument)
+{
+	uint8_t Event;
+	uint8_t Playing = FALSE;
+	// halves still holding sound after last block
+	uint8_t Tail = 0;
+	
+	for (;;)
+	{
+		if (xQueueReceive(AudioQueue, &Event, Playing ? 0 : portMAX_DELAY) == pdPASS)
+		{
+			if (Playing)
+			{
+				LASERTAG_AUDIO_Stop();
+				Playing = FALSE;
+			}
+			
+			if (!LASERTAG_AUDIO_Open(Event))
+				continue;
+			
+			LASERTAG_AUDIO_Fill(&AudioSample[0]);
+			LASERTAG_AUDIO_Fill(&AudioSample[LASERTAG_AUDIO_HALF]);
+			Tail = 2;
+			LASERTAG_AUDIO_Start();
+			Playing = TRUE;
+			continue;
+		}
+		
+		NOTIFY_Wait(LASERTAG_AUDIO_NOTIFY_HALF, portMAX_DELAY);
+		
+		if (AudioRemain == 0 && --Tail == 0)
+		{
+			LASERTAG_AUDIO_Stop();
+			Playing = FALSE;
+			continue;
+		}
+		
+		// ISR just wrapped into the other half
+		LASERTAG_AUDIO_Fill(&AudioSample[(AudioIndex < LASERTAG_AUDIO_HALF) ? LASERTAG_AUDIO_HALF : 0]);
+	}
+}
+
+/*****************************END OF FILE************************************/
@@ -0,0 +1,344 @@
+/**
+  ******************************************************************************
+  * File Name          : lasertag_bench.c
+  * Description        : cycle benchmarks of hot paths, run over pc link
+  ******************************************************************************
+  * author: Tomas Krejci <info@tomaskrejci.com>
+  *
+  *
+  ******************************************************************************
+  */
+#include <string.h>
+#include "main.h"
+#include "cmsis_os.h"
+#include "lasertag_bench.h"
+#include "lasertag_ir.h"
+#include "lasertag_audio.h"
+#include "mem_fast.h"
+#include "ff.h"
+
+#if LASERTAG_BENCH
+
+#define BENCH_BUF_SIZE		128
+// FatFs benches, files on the log volume
+#define BENCH_FILE_READ		"BENCH.BIN"
+#define BENCH_FILE_LOG		"BENCH.LOG"
+#define BENCH_FILE_SIZE		0x4000
+#define BENCH_POOL_SIZE		16
+
+typedef struct
+{
+	const char *Name;
+	void (*Function)(void);
+} LASERTAG_BENCH_TypeDef;
+
+// shared scratch, benchmarks run one at a time in storage task
+static uint8_t BenchBuf[BENCH_BUF_SIZE];
+static uint8_t BenchOut[2 * BENCH_BUF_SIZE];
+static volatile uint32_t BenchSink;
+// FatFs benches share one file object, the bench owning it keeps it open
+static FIL BenchFile;
+static void (*BenchFileOwner)(void);
+static uint8_t BenchFileReady;
+// fixed block pool, all blocks but one stay allocated, a block holds the
+// free list link
+osPoolStaticDef(BenchPool, BENCH_POOL_SIZE, void *);
+static osPoolId BenchPoolId;
+
+
+static void LASERTAG_BENCH_Empty(void)
+{
+}
+
+// read 128B from audio region
+static void LASERTAG_BENCH_FlashRead(void)
+{
+	BSP_SERIAL_FLASH_ReadData(LASERTAG_ADR_AUDIO, BenchBuf, BENCH_BUF_SIZE);
+}
+
+// single byte transfers, command/address/status path, CS stays high
+static void LASERTAG_BENCH_SpiByte(void)
+{
+	uint8_t i;
+	
+	SPI_BUS_Acquire(&FLASH_SPI_Device);
+	for (i = 0; i < 16; i++)
+		BenchSink = FLASH_SPI_IO_ReadByte();
+	SPI_BUS_Release();
+}
+
+// decode one shot packet, 15 marks
+static void LASERTAG_BENCH_IrDecode(void)
+{
+	LASERTAG_IR_DecoderTypeDef Decoder;
+	uint16_t Packet = LASERTAG_IR_PACKET(0x55, 2, 9);
+	uint8_t i;
+	
+	LASERTAG_IR_DecodeReset(&Decoder);
+	LASERTAG_IR_Decode(&Decoder, LASERTAG_IR_HEADER_US);
+	for (i = LASERTAG_IR_BITS; i > 0; i--)
+		LASERTAG_IR_Decode(&Decoder, (Packet & (1 << (i - 1))) ? LASERTAG_IR_ONE_US : LASERTAG_IR_ZERO_US);
+	
+	BenchSink = Decoder.Packet;
+}
+
+// decode 128B ADPCM -> 256 samples (32ms of sound)
+static void LASERTAG_BENCH_AudioDecode(void)
+{
+	LASERTAG_AUDIO_DecoderTypeDef Decoder;
+	
+	LASERTAG_AUDIO_DecodeReset(&Decoder);
+	LASERTAG_AUDIO_Decode(&Decoder, BenchBuf, BENCH_BUF_SIZE, BenchOut);
+}
+
+// crc of 128B
+static void LASERTAG_BENCH_Crc(void)
+{
+	BenchSink = CRC16_Calc(CRC16_INIT, BenchBuf, BENCH_BUF_SIZE);
+}
+
+// copy 128B, library reference
+static void LASERTAG_BENCH_Memcpy(void)
+{
+	memcpy(BenchOut, BenchBuf, BENCH_BUF_SIZE);
+}
+
+// copy 128B, word blocks
+static void LASERTAG_BENCH_MemCopy(void)
+{
+	MEM_FAST_Copy(BenchOut, BenchBuf, BENCH_BUF_SIZE);
+}
+
+// copy 128B, source off by one byte -> shifted words
+static void LASERTAG_BENCH_MemCopyOdd(void)
+{
+	MEM_FAST_Copy(BenchOut, BenchBuf + 1, BENCH_BUF_SIZE - 1);
+}
+
+static void LASERTAG_BENCH_FileRelease(void)
+{
+	if (BenchFileOwner != NULL)
+		f_close(&BenchFile);
+	BenchFileOwner = NULL;
+}
+
+/**		Create read bench file once, BENCH_FILE_SIZE of pattern
+			retval: FALSE log volume not usable (not formatted)
+*/
+static uint8_t LASERTAG_BENCH_FileCreate(void)
+{
+	UINT Written;
+	uint32_t i;
+	
+	if (BenchFileReady)
+		return TRUE;
+	
+	LASERTAG_BENCH_FileRelease();
+	if (f_open(&BenchFile, BENCH_FILE_READ, FA_READ) == FR_OK)
+	{
+		i = f_size(&BenchFile);
+		f_close(&BenchFile);
+		if (i == BENCH_FILE_SIZE)
+			return BenchFileReady = TRUE;
+	}
+	
+	if (f_open(&BenchFile, BENCH_FILE_READ, FA_WRITE | FA_CREATE_ALWAYS) != FR_OK)
+		return FALSE;
+	for (i = 0; i < BENCH_FILE_SIZE; i += BENCH_BUF_SIZE)
+	{
+		memset(BenchBuf, (uint8_t)(i / BENCH_BUF_SIZE), BENCH_BUF_SIZE);
+		if (f_write(&BenchFile, BenchBuf, BENCH_BUF_SIZE, &Written) != FR_OK || Written != BENCH_BUF_SIZE)
+			break;
+	}
+	f_close(&BenchFile);
+	
+	return BenchFileReady = (i == BENCH_FILE_SIZE);
+}
+
+/**		Take the file object for Owner, first call opens the file (shows in max)
+			retval: FALSE no file
+*/
+static uint8_t LASERTAG_BENCH_FileOpen(void (*Owner)(void), const char *pPath, BYTE Mode)
+{
+	if (BenchFileOwner == Owner)
+		return TRUE;
+	
+	LASERTAG_BENCH_FileRelease();
+	if (f_open(&BenchFile, pPath, Mode) != FR_OK)
+		return FALSE;
+	
+	BenchFileOwner = Owner;
+	return TRUE;
+}
+
+// open + close of a file in the root directory (lookup, link map)
+static void LASERTAG_BENCH_FsOpen(void)
+{
+	if (LASERTAG_BENCH_FileCreate() && f_open(&BenchFile, BENCH_FILE_READ, FA_READ) == FR_OK)
+		f_close(&BenchFile);
+}
+
+// sequential read 128B, wraps at end of file
+static void LASERTAG_BENCH_FsRead(void)
+{
+	UINT Read;
+	
+	if (!LASERTAG_BENCH_FileCreate() ||
+			!LASERTAG_BENCH_FileOpen(LASERTAG_BENCH_FsRead, BENCH_FILE_READ, FA_READ))
+		return;
+	if (f_eof(&BenchFile))
+		f_lseek(&BenchFile, 0);
+	f_read(&BenchFile, BenchOut, BENCH_BUF_SIZE, &Read);
+}
+
+// log append 64B + f_sync, file restarts at BENCH_FILE_SIZE
+static void LASERTAG_BENCH_FsAppend(void)
+{
+	UINT Written;
+	
+	if (BenchFileOwner != LASERTAG_BENCH_FsAppend)
+	{
+		if (!LASERTAG_BENCH_FileOpen(LASERTAG_BENCH_FsAppend, BENCH_FILE_LOG, FA_WRITE | FA_OPEN_ALWAYS))
+			return;
+		f_lseek(&BenchFile, f_size(&BenchFile));
+	}
+	if (f_size(&BenchFile) >= BENCH_FILE_SIZE)
+	{
+		f_lseek(&BenchFile, 0);
+		f_truncate(&BenchFile);
+	}
+	f_write(&BenchFile, BenchBuf, BENCH_BUF_SIZE / 2, &Written);
+	f_sync(&BenchFile);
+}
+
+// alloc + free of the last free block, interrupts are masked inside each call
+static void LASERTAG_BENCH_PoolAlloc(void)
+{
+	uint8_t i;
+	
+	if (BenchPoolId == NULL)
+	{
+		BenchPoolId = osPoolCreate(osPool(BenchPool));
+		for (i = 0; i < BENCH_POOL_SIZE - 1; i++)
+			osPoolAlloc(BenchPoolId);
+	}
+	osPoolFree(BenchPoolId, osPoolAlloc(BenchPoolId));
+}
+
+static const LASERTAG_BENCH_TypeDef Bench[] =
+{
+	{ "flash read 128",		LASERTAG_BENCH_FlashRead },
+	{ "spi byte x16",			LASERTAG_BENCH_SpiByte },
+	{ "ir decode",				LASERTAG_BENCH_IrDecode },
+	{ "audio decode 128",	LASERTAG_BENCH_AudioDecode },
+	{ "crc16 128",				LASERTAG_BENCH_Crc },
+	{ "memcpy 128",				LASERTAG_BENCH_Memcpy },
+	{ "mem copy 128",			LASERTAG_BENCH_MemCopy },
+	{ "mem copy 128 odd",	LASERTAG_BENCH_MemCopyOdd },
+	{ "fs open",					LASERTAG_BENCH_FsOpen },
+	{ "fs read 128",			LASERTAG_BENCH_FsRead },
+	{ "fs append 64",			LASERTAG_BENCH_FsAppend },
+	{ "pool alloc free",	LASERTAG_BENCH_PoolAlloc },
+};
+
+#define BENCH_CNT		(sizeof(Bench) / sizeof(Bench[0]))
+
+
+uint8_t LASERTAG_BENCH_Count(void)
+{
+	return BENCH_CNT;
+}
+
+static void LASERTAG_BENCH_Time(void (*Function)(void), uint16_t Iterations, LASERTAG_BENCH_ResultTypeDef *pResult)
+{
+	uint32_t Start, Cycles, Sum = 0;
+	uint16_t i;
+	
+	pResult->Min = 0xFFFFFFFF;
+	pResult->Max = 0;
+	
+	for (i = 0; i < Iterations; i++)
+	{
+		Start = CYCLE_COUNTER();
+		Function();
+		Cycles = CYCLE_COUNTER() - Start;
+		
+		Sum += Cycles;
+		if (Cycles < pResult->Min)
+			pResult->Min = Cycles;
+		if (Cycles > pResult->Max)
+			pResult->Max = Cycles;
+	}
+	
+	pResult->Avg = Sum / Iterations;
+}
+
+/**		Iterations really run for a requested count, 1..LASERTAG_BENCH_ITER_MAX
+*/
+static uint16_t LASERTAG_BENCH_Iterations(uint16_t Iterations)
+{
+	if (Iterations == 0)
+		return 1;
+	if (Iterations > LASERTAG_BENCH_ITER_MAX)
+		return LASERTAG_BENCH_ITER_MAX;
+	return Iterations;
+}
+
+/**		Run benchmark, results without call overhead
+			retval: FALSE unknown index
+*/
+uint8_t LASERTAG_BENCH_Run(uint8_t Index, uint16_t Iterations, LASERTAG_BENCH_ResultTypeDef *pResult)
+{
+	LASERTAG_BENCH_ResultTypeDef Overhead;
+	
+	if (Index >= BENCH_CNT)
+		return FALSE;
+	Iterations = LASERTAG_BENCH_Iterations(Iterations);
+	
+	LASERTAG_BENCH_Time(LASERTAG_BENCH_Empty, 16, &Overhead);
+	LASERTAG_BENCH_Time(Bench[Index].Function, Iterations, pResult);
+	
+	pResult->Min = (pResult->Min > Overhead.Min) ? pResult->Min - Overhead.Min : 0;
+	pResult->Avg = (pResult->Avg > Overhead.Min) ? pResult->Avg - Overhead.Min : 0;
+	pResult->Max = (pResult->Max > Overhead.Min) ? pResult->Max - Overhead.Min : 0;
+	
+	return TRUE;
+}
+
+static uint8_t *LASERTAG_BENCH_Put32(uint8_t *p, uint32_t Value)
+{
+	*p++ = (uint8_t)(Value);
+	*p++ = (uint8_t)(Value >> 8);
+	*p++ = (uint8_t)(Value >> 16);
+	*p++ = (uint8_t)(Value >> 24);
+	return p;
+}
+
+/**		Run benchmark and serialize result, layout in lasertag_bench.h
+			retval: size in bytes, 0 = unknown index
+*/
+uint16_t LASERTAG_BENCH_Read(uint8_t Index, uint16_t Iterations, uint8_t *pData)
+{
+	LASERTAG_BENCH_ResultTypeDef Result;
+	uint8_t *p = pData;
+	
+	if (!LASERTAG_BENCH_Run(Index, Iterations, &Result))
+		return 0;
+	Iterations = LASERTAG_BENCH_Iterations(Iterations);
+	
+	*p++ = BENCH_CNT;
+	*p++ = Index;
+	*p++ = (uint8_t)(Iterations);
+	*p++ = (uint8_t)(Iterations >> 8);
+	p = LASERTAG_BENCH_Put32(p, Result.Min);
+	p = LASERTAG_BENCH_Put32(p, Result.Avg);
+	p = LASERTAG_BENCH_Put32(p, Result.Max);
+	strncpy((char *)p, Bench[Index].Name, LASERTAG_BENCH_NAME_LEN);
+	p += LASERTAG_BENCH_NAME_LEN;
+	
+	return (uint16_t)(p - pData);
+}
+
+#endif /* LASERTAG_BENCH */
+
+/*****************************END OF FILE************************************/
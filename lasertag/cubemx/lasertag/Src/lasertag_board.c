@@ -8,7 +8,18 @@
   *
   ******************************************************************************
   */
+#include <string.h>
 #include "main.h"	
+#include "cmsis_os.h"
+#include "setup_store.h"
+#include "lasertag_setup.h"
+#include "lasertag_storage.h"
+#include "lasertag_power.h"
+#include "lasertag_diag.h"
+#include "lasertag_trace.h"
+#include "lasertag_bench.h"
+#include "lasertag_led.h"
+#include "ff.h"
 
 // packet... head or data
 uint8_t PacketHead = TRUE;
@@ -16,16 +27,28 @@ uint8_t PacketHead = TRUE;
 // data page counter
 uint8_t DataPageCnt;
 
-/* Buffer used for transmission */
-uint8_t TxBuffer[LASERTAG_DATA_PAGE_SIZE];
-/* Buffer used for reception */
-uint8_t RxBuffer[LASERTAG_DATA_PAGE_SIZE];
+/* Buffer used for reception, the answer is sent back from it - pc sends
+   the next packet only after the answer (and log stream) is in */
+uint8_t PageBuffer[LASERTAG_DATA_PAGE_SIZE];
+
+// task waiting in LASERTAG_BOARD_LogForward for TX DMA complete
+static TaskHandle_t volatile BoardTxTask;
+
+// log download, bytes still to stream behind the answer page
+static FIL BoardLogFile;
+static uint32_t BoardLogRemain;
+
+// storage job of the link, command or log sector - link is half duplex,
+// the job is never queued twice
+static uint8_t LASERTAG_BOARD_CommandJob(void *pArg);
+static uint8_t LASERTAG_BOARD_LogJob(void *pArg);
+static LASERTAG_STORAGE_JobTypeDef BoardJob = LASERTAG_STORAGE_JOB(LASERTAG_BOARD_CommandJob);
 
 void LASERTAG_BOARD_Init(void)
 {
 	HAL_UART_MspInit(&huart1);
 	
-	if (HAL_UART_Receive_DMA(&huart1, (uint8_t *)RxBuffer, LASERTAG_DATA_PAGE_SIZE) == HAL_ERROR)
+	if (HAL_UART_Receive_DMA(&huart1, (uint8_t *)PageBuffer, LASERTAG_DATA_PAGE_SIZE) == HAL_ERROR)
   {
     /* Transfer error in reception process */
     Error_Handler();
@@ -38,9 +61,25 @@ void LASERTAG_BOARD_TxHalfCpltCallback(void)
 	
 }
 
+/**		Answer page or log sector sent - wake the log stream
+*/
 void LASERTAG_BOARD_TxCpltCallback(void)
 {
-
+	BaseType_t Woken = pdFALSE;
+	
+	LASERTAG_POWER_Release(LASERTAG_POWER_HOLD_LINK);
+	if (BoardTxTask != NULL)
+	{
+		xTaskNotifyFromISR(BoardTxTask, LASERTAG_BOARD_NOTIFY_TX, eSetBits, &Woken);
+		BoardTxTask = NULL;
+	}
+	else if (BoardLogRemain != 0)
+	{
+		// log download - file data follows the answer page
+		BoardJob.Function = LASERTAG_BOARD_LogJob;
+		LASERTAG_STORAGE_QueueFromISR(&BoardJob, &Woken);
+	}
+	portYIELD_FROM_ISR(Woken);
 }
 
 
@@ -50,9 +89,255 @@ void LASERTAG_BOARD_RxHalfCpltCallback(void)
 	
 }
 
+/**		Whole packet received - command runs as storage task job, not in ISR
+*/
 void LASERTAG_BOARD_RxCpltCallback(void)
 {
+	BaseType_t Woken = pdFALSE;
+	
+	LASERTAG_LED_ActivityFromISR(LASERTAG_LED_LINK, &Woken);
+	BoardJob.Function = LASERTAG_BOARD_CommandJob;
+	LASERTAG_STORAGE_QueueFromISR(&BoardJob, &Woken);
+	portYIELD_FROM_ISR(Woken);
+}
+
+// storage task job, setup store and flash commands, answer leaves by TX DMA
+static uint8_t LASERTAG_BOARD_CommandJob(void *pArg)
+{
+	LASERTAG_BOARD_Command(PageBuffer);
+	
+	// TX DMA needs clocks until LASERTAG_BOARD_TxCpltCallback
+	LASERTAG_POWER_Hold(LASERTAG_POWER_HOLD_LINK);
+	if (HAL_UART_Transmit_DMA(&huart1, (uint8_t *)PageBuffer, LASERTAG_DATA_PAGE_SIZE) == HAL_ERROR)
+	{
+		/* Transfer error in transmission process */
+		Error_Handler();
+	}
+	
+	return FLASH_OK;
+}
+
+/**		f_forward stream - TX DMA straight from the FatFs sector window,
+			returns after the transfer, FatFs may reuse the window then
+*/
+static UINT LASERTAG_BOARD_LogForward(const BYTE *pData, UINT Size)
+{
+	// sense call, link is ready
+	if (Size == 0)
+		return 1;
+	
+	BoardTxTask = xTaskGetCurrentTaskHandle();
+	LASERTAG_POWER_Hold(LASERTAG_POWER_HOLD_LINK);
+	if (HAL_UART_Transmit_DMA(&huart1, (uint8_t *)pData, Size) != HAL_OK)
+	{
+		BoardTxTask = NULL;
+		LASERTAG_POWER_Release(LASERTAG_POWER_HOLD_LINK);
+		return 0;
+	}
+	NOTIFY_Wait(LASERTAG_BOARD_NOTIFY_TX, portMAX_DELAY);
+	
+	return Size;
+}
+
+/**		Storage task job, next sector of the log download, queues itself
+			again so other storage jobs run in between
+*/
+static uint8_t LASERTAG_BOARD_LogJob(void *pArg)
+{
+	UINT Size;
+	UINT Sent;
+	
+	do
+	{
+		Size = _MAX_SS - (UINT)(BoardLogFile.fptr % _MAX_SS);
+		if (Size > BoardLogRemain)
+			Size = BoardLogRemain;
+		
+		// on error the stream ends short, pc times out
+		if (f_forward(&BoardLogFile, LASERTAG_BOARD_LogForward, Size, &Sent) != FR_OK || Sent != Size)
+			BoardLogRemain = 0;
+		else
+			BoardLogRemain -= Sent;
+		
+		if (BoardLogRemain == 0)
+		{
+			f_close(&BoardLogFile);
+			break;
+		}
+	}
+	// queue full - keep streaming from here
+	while (!LASERTAG_STORAGE_Queue(&BoardJob));
+	
+	return FLASH_OK;
+}
+
+// answer data area, arguments of the request must be read before
+static void LASERTAG_BOARD_Clear(uint8_t *pPage)
+{
+	memset(&pPage[3], 0, LASERTAG_DATA_PAGE_SIZE - 3);
+}
 
+/**		Execute one command packet, answer replaces it in the same page
+			and has the same head
+			<command>	<target>	<status>	<data>...
+*/
+void LASERTAG_BOARD_Command(uint8_t *pPage)
+{
+	uint8_t Status = LASERTAG_STATUS_ERROR;
+	uint8_t Key;
+	uint8_t Size;
+	uint16_t Size16;
+	uint32_t Offset;
+	
+	switch (pPage[1])
+	{
+		case LASERTAG_TAR_SETUP:
+			/**	<CMD_SET>				<TAR_SETUP>	<x>	<key>	<size>	<value>...
+					<CMD_READ_DATA>	<TAR_SETUP>	<x>	<key>
+					<CMD_WRITE_DATA>	<TAR_SETUP>	<x>	<offset>	<size>	<data>...
+					
+					key LASERTAG_SETUP_KEY = game configuration image (lasertag_setup.h),
+					write data patches the live RAM copy at offset and stores it,
+					set of that key is refused - the RAM copy would not follow
+			*/
+			if (pPage[0] == LASERTAG_CMD_WRITE_DATA)
+			{
+				if (LASERTAG_SETUP_Patch(pPage[3], &pPage[5], pPage[4]) == SETUP_STORE_OK)
+					Status = LASERTAG_STATUS_OK;
+				LASERTAG_BOARD_Clear(pPage);
+			}
+			else if (pPage[0] == LASERTAG_CMD_SET)
+			{
+				if (pPage[3] != LASERTAG_SETUP_KEY &&
+						SETUP_STORE_Write(pPage[3], &pPage[5], pPage[4]) == SETUP_STORE_OK)
+					Status = LASERTAG_STATUS_OK;
+				LASERTAG_BOARD_Clear(pPage);
+			}
+			else if (pPage[0] == LASERTAG_CMD_READ_DATA)
+			{
+				Key = pPage[3];
+				LASERTAG_BOARD_Clear(pPage);
+				Size = SETUP_STORE_VALUE_MAX;
+				if (SETUP_STORE_Read(Key, &pPage[5], &Size) == SETUP_STORE_OK)
+				{
+					Status = LASERTAG_STATUS_OK;
+					pPage[3] = Key;
+					pPage[4] = Size;
+				}
+			}
+			else
+				LASERTAG_BOARD_Clear(pPage);
+			break;
+			
+		case LASERTAG_TAR_LOG:
+			/**	<CMD_READ_DATA>	<TAR_LOG>	<x>	<offset 4B>	<size 2B>	<path>...0
+					-> <file size 4B> <size 2B>
+					
+					size bytes of the log volume file from offset follow the answer
+					page as raw stream, sent by TX DMA from the FatFs sector window
+			*/
+			if (pPage[0] == LASERTAG_CMD_READ_DATA && memchr(&pPage[9], 0, LASERTAG_DATA_PAGE_SIZE - 9) != NULL &&
+					f_open(&BoardLogFile, (const TCHAR *)&pPage[9], FA_READ) == FR_OK)
+			{
+				Offset = pPage[3] | ((uint32_t)pPage[4] << 8) | ((uint32_t)pPage[5] << 16) | ((uint32_t)pPage[6] << 24);
+				Size16 = pPage[7] | ((uint16_t)pPage[8] << 8);
+				LASERTAG_BOARD_Clear(pPage);
+				if (Offset > f_size(&BoardLogFile))
+					Offset = f_size(&BoardLogFile);
+				if (Size16 > f_size(&BoardLogFile) - Offset)
+					Size16 = f_size(&BoardLogFile) - Offset;
+				
+				if (f_lseek(&BoardLogFile, Offset) == FR_OK)
+				{
+					pPage[3] = (uint8_t)(f_size(&BoardLogFile));
+					pPage[4] = (uint8_t)(f_size(&BoardLogFile) >> 8);
+					pPage[5] = (uint8_t)(f_size(&BoardLogFile) >> 16);
+					pPage[6] = (uint8_t)(f_size(&BoardLogFile) >> 24);
+					pPage[7] = (uint8_t)(Size16);
+					pPage[8] = (uint8_t)(Size16 >> 8);
+					Status = LASERTAG_STATUS_OK;
+					BoardLogRemain = Size16;
+				}
+				
+				if (BoardLogRemain == 0)
+					f_close(&BoardLogFile);
+			}
+			else
+				LASERTAG_BOARD_Clear(pPage);
+			break;
+			
+#if LASERTAG_DIAG
+		case LASERTAG_TAR_DIAG:
+			/**	<CMD_READ_DATA>	<TAR_DIAG>	<x>		-> <size 2B> <report> (lasertag_diag.h)
+					<CMD_SET>				<TAR_DIAG>	<x>		-> clear maxima
+					
+					read closes the CPU load window opened by the previous read
+			*/
+			LASERTAG_BOARD_Clear(pPage);
+			if (pPage[0] == LASERTAG_CMD_READ_DATA)
+			{
+				LASERTAG_DIAG_Sample();
+				Size16 = LASERTAG_DIAG_Read(&pPage[5]);
+				pPage[3] = (uint8_t)(Size16);
+				pPage[4] = (uint8_t)(Size16 >> 8);
+				Status = LASERTAG_STATUS_OK;
+			}
+			else if (pPage[0] == LASERTAG_CMD_SET)
+			{
+				LASERTAG_DIAG_Reset();
+				Status = LASERTAG_STATUS_OK;
+			}
+			break;
+#endif
+			
+#if LASERTAG_TRACE
+		case LASERTAG_TAR_TRACE:
+			/**	<CMD_SET>				<TAR_TRACE>	<x>	<mask 4B>		class mask, 0 = freeze
+					<CMD_READ_DATA>	<TAR_TRACE>	<x>	<page>			-> <page> <page data> (lasertag_trace.c)
+			*/
+			Key = pPage[3];
+			if (pPage[0] == LASERTAG_CMD_SET)
+			{
+				LASERTAG_TraceMask = pPage[3] | ((uint32_t)pPage[4] << 8) | ((uint32_t)pPage[5] << 16) | ((uint32_t)pPage[6] << 24);
+				Status = LASERTAG_STATUS_OK;
+			}
+			LASERTAG_BOARD_Clear(pPage);
+			if (pPage[0] == LASERTAG_CMD_READ_DATA)
+			{
+				pPage[3] = Key;
+				LASERTAG_TRACE_Read(Key, &pPage[4]);
+				Status = LASERTAG_STATUS_OK;
+			}
+			break;
+#endif
+			
+#if LASERTAG_BENCH
+		case LASERTAG_TAR_BENCH:
+			/**	<CMD_READ_DATA>	<TAR_BENCH>	<x>	<index>	<iterations 2B>	-> <size 2B> <result> (lasertag_bench.h)
+					runs in storage task, flash is free for the flash read bench
+			*/
+			Key = pPage[3];
+			Size16 = pPage[4] | ((uint16_t)pPage[5] << 8);
+			LASERTAG_BOARD_Clear(pPage);
+			if (pPage[0] == LASERTAG_CMD_READ_DATA)
+			{
+				Size16 = LASERTAG_BENCH_Read(Key, Size16, &pPage[5]);
+				if (Size16 != 0)
+				{
+					pPage[3] = (uint8_t)(Size16);
+					pPage[4] = (uint8_t)(Size16 >> 8);
+					Status = LASERTAG_STATUS_OK;
+				}
+			}
+			break;
+#endif
+			
+		default:
+			LASERTAG_BOARD_Clear(pPage);
+			break;
+	}
+	
+	pPage[2] = Status;
 }
 
 
@@ -0,0 +1,218 @@
+/**
+  ******************************************************************************
+  * File Name          : lasertag_diag.c
+  * Description        : run time diagnostics - CPU, stacks, queues, latency
+  ******************************************************************************
+  * author: Tomas Krejci <info@tomaskrejci.com>
+  *
+  *
+  ******************************************************************************
+  */
+#include <string.h>
+#include "main.h"
+#include "cmsis_os.h"
+#include "lasertag_diag.h"
+#include "lasertag_game.h"
+#include "lasertag_power.h"
+#include "flash_cache.h"
+#include "ftl.h"
+
+#if LASERTAG_DIAG
+
+typedef struct
+{
+	char     Name[LASERTAG_DIAG_NAME_LEN];
+	uint16_t Cpu;							/*!< [0.1%] in last window */
+	uint16_t StackFree;				/*!< [words] high water mark */
+	uint8_t  Priority;
+	uint8_t  State;						/*!< eTaskState */
+} LASERTAG_DIAG_TaskTypeDef;
+
+// uxTaskGetSystemState buffer, too big for task stack
+static TaskStatus_t DiagStatus[LASERTAG_DIAG_TASKS];
+// run time at window start, index xTaskNumber - 1
+static uint32_t DiagRunTime[LASERTAG_DIAG_TASKS];
+static uint32_t DiagTotalTime;
+static TickType_t DiagWindowStart;
+// last complete window
+static LASERTAG_DIAG_TaskTypeDef DiagTask[LASERTAG_DIAG_TASKS];
+static uint8_t DiagTaskCnt;
+
+static volatile uint8_t DiagQueueMax[LASERTAG_DIAG_QUEUES];
+static uint8_t DiagQueueLen[LASERTAG_DIAG_QUEUES];
+
+// vector table, entry 0 = initial main stack pointer (startup_stm32f051x8.s)
+extern const uint32_t __Vectors[];
+
+
+/**		Fill unused part of main stack, first thing in main (before HAL_Init)
+*/
+void LASERTAG_DIAG_StackFill(void)
+{
+	uint32_t *p = (uint32_t *)(__Vectors[0] - LASERTAG_DIAG_MAIN_STACK_SIZE);
+	// keep clear of own frame
+	uint32_t *pEnd = (uint32_t *)__get_MSP() - 16;
+	
+	while (p < pEnd)
+		*p++ = LASERTAG_DIAG_STACK_FILL;
+}
+
+/**		Main stack high water mark [words]
+*/
+static uint16_t LASERTAG_DIAG_StackFree(void)
+{
+	const uint32_t *pBase = (const uint32_t *)(__Vectors[0] - LASERTAG_DIAG_MAIN_STACK_SIZE);
+	const uint32_t *p = pBase;
+	
+	while (*p == LASERTAG_DIAG_STACK_FILL)
+		p++;
+	return (uint16_t)(p - pBase);
+}
+
+
+/**		Close CPU window, called by pc link before each report read
+*/
+void LASERTAG_DIAG_Sample(void)
+{
+	LASERTAG_DIAG_TaskTypeDef *pTask;
+	uint32_t Total, Window, Delta;
+	TickType_t Now = xTaskGetTickCount();
+	UBaseType_t Cnt, i, n;
+	
+	Cnt = uxTaskGetSystemState(DiagStatus, LASERTAG_DIAG_TASKS, &Total);
+	Window = Total - DiagTotalTime;
+	DiagTotalTime = Total;
+	DiagTaskCnt = 0;
+	
+	// wall time is never shorter than TIM2 time, counter wrap is possible
+	if (Now - DiagWindowStart >= LASERTAG_DIAG_WINDOW_MAX_MS / portTICK_PERIOD_MS)
+		Window = 0;
+	DiagWindowStart = Now;
+	
+	for (i = 0; i < Cnt; i++)
+	{
+		n = DiagStatus[i].xTaskNumber - 1;
+		if (n >= LASERTAG_DIAG_TASKS)
+			continue;
+		
+		Delta = DiagStatus[i].ulRunTimeCounter - DiagRunTime[n];
+		DiagRunTime[n] = DiagStatus[i].ulRunTimeCounter;
+		
+		pTask = &DiagTask[DiagTaskCnt++];
+		strncpy(pTask->Name, DiagStatus[i].pcTaskName, LASERTAG_DIAG_NAME_LEN);
+		pTask->Cpu = (Window != 0) ? (uint16_t)((uint64_t)Delta * 1000 / Window) : LASERTAG_DIAG_CPU_UNKNOWN;
+		pTask->StackFree = DiagStatus[i].usStackHighWaterMark;
+		pTask->Priority = (uint8_t)DiagStatus[i].uxCurrentPriority;
+		pTask->State = (uint8_t)DiagStatus[i].eCurrentState;
+	}
+}
+
+/**		Track queue depth maximum
+*/
+void LASERTAG_DIAG_Queue(QueueHandle_t xQueue, uint8_t Number)
+{
+	if (Number == 0 || Number >= LASERTAG_DIAG_QUEUES)
+		return;
+	
+	vQueueSetQueueNumber(xQueue, Number);
+	DiagQueueLen[Number] = (uint8_t)(uxQueueMessagesWaiting(xQueue) + uxQueueSpacesAvailable(xQueue));
+}
+
+/**		traceQUEUE_SEND hook, kernel critical section or ISR
+*/
+void LASERTAG_DIAG_QueueDepth(uint32_t Number, uint32_t Depth)
+{
+	if (Number != 0 && Number < LASERTAG_DIAG_QUEUES && Depth > DiagQueueMax[Number])
+		DiagQueueMax[Number] = (uint8_t)Depth;
+}
+
+static uint8_t *LASERTAG_DIAG_Put16(uint8_t *p, uint16_t Value)
+{
+	*p++ = (uint8_t)(Value);
+	*p++ = (uint8_t)(Value >> 8);
+	return p;
+}
+
+static uint8_t *LASERTAG_DIAG_Put32(uint8_t *p, uint32_t Value)
+{
+	p = LASERTAG_DIAG_Put16(p, (uint16_t)Value);
+	return LASERTAG_DIAG_Put16(p, (uint16_t)(Value >> 16));
+}
+
+/**		Serialize report, layout in lasertag_diag.h
+			retval: size in bytes
+*/
+uint16_t LASERTAG_DIAG_Read(uint8_t *pData)
+{
+	uint8_t *p = pData;
+	uint8_t i;
+	
+	*p++ = DiagTaskCnt;
+	for (i = 0; i < DiagTaskCnt; i++)
+	{
+		memcpy(p, DiagTask[i].Name, LASERTAG_DIAG_NAME_LEN);
+		p += LASERTAG_DIAG_NAME_LEN;
+		p = LASERTAG_DIAG_Put16(p, DiagTask[i].Cpu);
+		p = LASERTAG_DIAG_Put16(p, DiagTask[i].StackFree);
+		*p++ = DiagTask[i].Priority;
+		*p++ = DiagTask[i].State;
+	}
+	
+	*p++ = LASERTAG_DIAG_QUEUES - 1;
+	for (i = 1; i < LASERTAG_DIAG_QUEUES; i++)
+	{
+		*p++ = i;
+		*p++ = DiagQueueMax[i];
+		*p++ = DiagQueueLen[i];
+	}
+	
+	p = LASERTAG_DIAG_Put32(p, LASERTAG_GAME_Stats.HitLast / CYCLES_PER_US);
+	p = LASERTAG_DIAG_Put32(p, LASERTAG_GAME_Stats.HitMax / CYCLES_PER_US);
+	p = LASERTAG_DIAG_Put32(p, LASERTAG_GAME_Stats.HitCnt);
+	
+	*p++ = LASERTAG_POWER_PHASE_CNT;
+	for (i = 0; i < LASERTAG_POWER_PHASE_CNT; i++)
+	{
+		// Current first - it closes the running phase
+		uint32_t Current = LASERTAG_POWER_Current(i);
+		p = LASERTAG_DIAG_Put32(p, LASERTAG_POWER_Stats[i].Time);
+		p = LASERTAG_DIAG_Put32(p, LASERTAG_POWER_Stats[i].Sleep);
+		p = LASERTAG_DIAG_Put32(p, LASERTAG_POWER_Stats[i].Stop);
+		p = LASERTAG_DIAG_Put32(p, Current);
+	}
+	
+	p = LASERTAG_DIAG_Put32(p, FLASH_CACHE_Stats.Hit);
+	p = LASERTAG_DIAG_Put32(p, FLASH_CACHE_Stats.Miss);
+	p = LASERTAG_DIAG_Put32(p, FLASH_CACHE_Stats.Prefetch);
+	p = LASERTAG_DIAG_Put32(p, FLASH_CACHE_Stats.PrefetchHit);
+	
+	p = LASERTAG_DIAG_Put32(p, FTL_Stats.HostWrite);
+	p = LASERTAG_DIAG_Put32(p, FTL_Stats.FlashWrite);
+	p = LASERTAG_DIAG_Put32(p, FTL_Stats.InPlace);
+	p = LASERTAG_DIAG_Put32(p, FTL_Stats.Erase);
+	p = LASERTAG_DIAG_Put32(p, FTL_Stats.MapCompact);
+	p = LASERTAG_DIAG_Put32(p, FTL_Stats.WearMove);
+	p = LASERTAG_DIAG_Put32(p, FTL_Stats.HostRead);
+	p = LASERTAG_DIAG_Put32(p, FTL_Stats.FlashRead);
+	
+	p = LASERTAG_DIAG_Put16(p, LASERTAG_DIAG_StackFree());
+	
+	return (uint16_t)(p - pData);
+}
+
+/**		Clear maxima (queue depth, hit latency)
+*/
+void LASERTAG_DIAG_Reset(void)
+{
+	uint8_t i;
+	
+	taskENTER_CRITICAL();
+	for (i = 0; i < LASERTAG_DIAG_QUEUES; i++)
+		DiagQueueMax[i] = 0;
+	LASERTAG_GAME_Stats.HitMax = 0;
+	taskEXIT_CRITICAL();
+}
+
+#endif /* LASERTAG_DIAG */
+
+/*****************************END OF FILE************************************/
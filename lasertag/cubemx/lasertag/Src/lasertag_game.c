@@ -0,0 +1,265 @@
+/**
+  ******************************************************************************
+  * File Name          : lasertag_game.c
+  * Description        : game logic task - shots, hits, respawn, game time
+  ******************************************************************************
+  * author: Tomas Krejci <info@tomaskrejci.com>
+  *
+  *
+  ******************************************************************************
+  */
+#include "main.h"
+#include "cmsis_os.h"
+#include "lasertag_game.h"
+#include "lasertag_setup.h"
+#include "lasertag_ir.h"
+#include "lasertag_audio.h"
+#include "lasertag_power.h"
+#include "lasertag_diag.h"
+#include "lasertag_trace.h"
+
+#define GAME_MS(ms)			((TickType_t)((ms) / portTICK_PERIOD_MS))
+
+typedef struct
+{
+	uint8_t  Health;
+	uint8_t  Deaths;
+	uint8_t  Alive;
+	uint8_t  Over;						/*!< game time elapsed or no lives left */
+	uint16_t Ammo;
+	TickType_t ShotAt;				/*!< next shot allowed */
+	TickType_t RespawnAt;			/*!< valid when !Alive */
+	TickType_t ReloadAt;			/*!< valid when Reload */
+	TickType_t EndAt;					/*!< valid when GameTime != 0 */
+	uint8_t  Reload;
+} LASERTAG_GAME_StateTypeDef;
+
+LASERTAG_GAME_StatsTypeDef LASERTAG_GAME_Stats;
+
+static QueueHandle_t GameQueue;
+static StaticQueue_t GameQueueBuffer;
+static uint8_t GameQueueStorage[LASERTAG_GAME_QUEUE_LEN * sizeof(LASERTAG_GAME_EventTypeDef)];
+
+static LASERTAG_GAME_StateTypeDef Game;
+
+
+void LASERTAG_GAME_Init(void)
+{
+	GameQueue = xQueueCreateStatic(LASERTAG_GAME_QUEUE_LEN, sizeof(LASERTAG_GAME_EventTypeDef),
+																 GameQueueStorage, &GameQueueBuffer);
+	LASERTAG_DIAG_Queue(GameQueue, LASERTAG_DIAG_QUEUE_GAME);
+}
+
+uint8_t LASERTAG_GAME_Post(const LASERTAG_GAME_EventTypeDef *pEvent)
+{
+	return xQueueSend(GameQueue, pEvent, 0) == pdPASS;
+}
+
+/**		Same from ISR, caller yields on *pWoken
+*/
+uint8_t LASERTAG_GAME_PostFromISR(const LASERTAG_GAME_EventTypeDef *pEvent, BaseType_t *pWoken)
+{
+	if (GameQueue == NULL)
+		return FALSE;
+	
+	return xQueueSendFromISR(GameQueue, pEvent, pWoken) == pdPASS;
+}
+
+/**		B1 rising edge
+*/
+void LASERTAG_GAME_TriggerCallback(void)
+{
+	LASERTAG_GAME_EventTypeDef Event;
+	BaseType_t Woken = pdFALSE;
+	
+	if (GameQueue == NULL)
+		return;
+	
+	Event.Type = LASERTAG_GAME_EVENT_TRIGGER;
+	Event.Reserved = 0;
+	Event.Data = 0;
+	Event.Time = CYCLE_COUNTER();
+	
+	xQueueSendFromISR(GameQueue, &Event, &Woken);
+	portYIELD_FROM_ISR(Woken);
+}
+
+// deadline passed, tick overflow safe
+static uint8_t LASERTAG_GAME_Passed(TickType_t Now, TickType_t At)
+{
+	return (int32_t)(Now - At) >= 0;
+}
+
+static void LASERTAG_GAME_Respawn(void)
+{
+	Game.Alive = TRUE;
+	Game.Health = LASERTAG_Setup.Health;
+	Game.Ammo = LASERTAG_Setup.Ammo;
+	Game.Reload = FALSE;
+	LASERTAG_POWER_Phase(LASERTAG_POWER_PHASE_ALIVE);
+}
+
+static void LASERTAG_GAME_Start(TickType_t Now)
+{
+	Game.Deaths = 0;
+	Game.Over = FALSE;
+	Game.ShotAt = Now;
+	Game.EndAt = Now + GAME_MS((uint32_t)LASERTAG_Setup.GameTime * 1000);
+	LASERTAG_GAME_Respawn();
+	LASERTAG_AUDIO_Play(LASERTAG_SOUND_START);
+}
+
+static void LASERTAG_GAME_Trigger(TickType_t Now)
+{
+	if (!Game.Alive || Game.Over || Game.Reload || !LASERTAG_GAME_Passed(Now, Game.ShotAt))
+		return;
+	
+	Game.ShotAt = Now + GAME_MS(LASERTAG_GAME_SHOT_MS);
+	
+	if (Game.Ammo == 0)
+	{
+		Game.Reload = TRUE;
+		Game.ReloadAt = Now + GAME_MS(LASERTAG_GAME_RELOAD_MS);
+		LASERTAG_AUDIO_Play(LASERTAG_SOUND_EMPTY);
+		return;
+	}
+	
+	Game.Ammo--;
+	LASERTAG_TRACE_Put(LASERTAG_TRACE_APP, LASERTAG_TRACE_SHOT,
+										 LASERTAG_IR_PACKET(LASERTAG_Setup.Player, LASERTAG_Setup.Team, LASERTAG_Setup.Damage));
+	LASERTAG_IR_Send(LASERTAG_IR_PACKET(LASERTAG_Setup.Player, LASERTAG_Setup.Team, LASERTAG_Setup.Damage));
+	LASERTAG_AUDIO_Play(LASERTAG_SOUND_SHOT);
+}
+
+static void LASERTAG_GAME_Hit(TickType_t Now, uint16_t Packet)
+{
+	uint8_t Damage;
+	
+	if (!Game.Alive || Game.Over)
+		return;
+	if (LASERTAG_IR_PLAYER(Packet) == LASERTAG_Setup.Player)
+		return;
+	if (LASERTAG_IR_TEAM(Packet) == LASERTAG_Setup.Team && !LASERTAG_Setup.FriendlyFire)
+		return;
+	
+	Damage = LASERTAG_Setup.DamageTable[LASERTAG_IR_DAMAGE(Packet)];
+	if (Damage < Game.Health)
+	{
+		Game.Health -= Damage;
+		LASERTAG_AUDIO_Play(LASERTAG_SOUND_HIT);
+		return;
+	}
+	
+	Game.Health = 0;
+	Game.Alive = FALSE;
+	Game.Deaths++;
+	LASERTAG_AUDIO_Play(LASERTAG_SOUND_DEAD);
+	
+	if (LASERTAG_Setup.Lives != 0 && Game.Deaths >= LASERTAG_Setup.Lives)
+	{
+		Game.Over = TRUE;
+		LASERTAG_POWER_Phase(LASERTAG_POWER_PHASE_IDLE);
+	}
+	else
+	{
+		LASERTAG_POWER_Phase(LASERTAG_POWER_PHASE_DEAD);
+		Game.RespawnAt = Now + GAME_MS((uint32_t)LASERTAG_Setup.RespawnTime * 100);
+	}
+}
+
+/**		Deadlines - respawn, reload, game end
+			retval: ticks to nearest deadline
+*/
+static TickType_t LASERTAG_GAME_Timers(TickType_t Now)
+{
+	TickType_t Wait = portMAX_DELAY;
+	
+	if (Game.Over)
+		return Wait;
+	
+	if (LASERTAG_Setup.GameTime != 0)
+	{
+		if (LASERTAG_GAME_Passed(Now, Game.EndAt))
+		{
+			Game.Over = TRUE;
+			LASERTAG_POWER_Phase(LASERTAG_POWER_PHASE_IDLE);
+			LASERTAG_AUDIO_Play(LASERTAG_SOUND_END);
+			return Wait;
+		}
+		Wait = Game.EndAt - Now;
+	}
+	
+	if (!Game.Alive)
+	{
+		if (LASERTAG_GAME_Passed(Now, Game.RespawnAt))
+		{
+			LASERTAG_GAME_Respawn();
+			LASERTAG_AUDIO_Play(LASERTAG_SOUND_RESPAWN);
+		}
+		else if (Game.RespawnAt - Now < Wait)
+			Wait = Game.RespawnAt - Now;
+	}
+	
+	if (Game.Reload)
+	{
+		if (LASERTAG_GAME_Passed(Now, Game.ReloadAt))
+		{
+			Game.Reload = FALSE;
+			Game.Ammo = LASERTAG_Setup.Ammo;
+			LASERTAG_AUDIO_Play(LASERTAG_SOUND_RELOAD);
+		}
+		else if (Game.ReloadAt - Now < Wait)
+			Wait = Game.ReloadAt - Now;
+	}
+	
+	return Wait;
+}
+
+/**		Game task - highest priority, IR RX decodes in the EXTI interrupt,
+			hit response is measured from IR packet time stamp to here
+			(LASERTAG_GAME_Stats, pc/test "make hit" on the host)
+*/
+void LASERTAG_GAME_Task(void const *argument)
+{
+	LASERTAG_GAME_EventTypeDef Event;
+	TickType_t Wait;
+	uint32_t Latency;
+	
+	LASERTAG_GAME_Start(xTaskGetTickCount());
+	
+	for (;;)
+	{
+		Wait = LASERTAG_GAME_Timers(xTaskGetTickCount());
+		
+		if (xQueueReceive(GameQueue, &Event, Wait) != pdPASS)
+			continue;
+		
+		switch (Event.Type)
+		{
+			case LASERTAG_GAME_EVENT_HIT:
+				LASERTAG_TRACE_Put(LASERTAG_TRACE_APP, LASERTAG_TRACE_HIT, Event.Data);
+				LASERTAG_GAME_Hit(xTaskGetTickCount(), Event.Data);
+				
+				Latency = CYCLE_COUNTER() - Event.Time;
+				LASERTAG_TRACE_Put(LASERTAG_TRACE_APP, LASERTAG_TRACE_HIT_DONE,
+													 (Latency > 0x00FFFFFF) ? 0x00FFFFFF : Latency);
+				LASERTAG_GAME_Stats.HitLast = Latency;
+				if (Latency > LASERTAG_GAME_Stats.HitMax)
+				{
+					LASERTAG_GAME_Stats.HitMax = Latency;
+					LASERTAG_TRACE_Hold(LASERTAG_TRACE_HOLD_HIT);
+				}
+				LASERTAG_GAME_Stats.HitCnt++;
+				break;
+				
+			case LASERTAG_GAME_EVENT_TRIGGER:
+				LASERTAG_GAME_Trigger(xTaskGetTickCount());
+				break;
+				
+			default:
+				break;
+		}
+	}
+}
+
+/*****************************END OF FILE************************************/
@@ -0,0 +1,253 @@
+/**
+  ******************************************************************************
+  * File Name          : lasertag_ir.c
+  * Description        : IR shot packet receive (EXTI) and transmit (IRTIM)
+  ******************************************************************************
+  * author: Tomas Krejci <info@tomaskrejci.com>
+  *
+  *
+  ******************************************************************************
+  */
+#include "main.h"
+#include "cmsis_os.h"
+#include "lasertag_ir.h"
+#include "lasertag_game.h"
+#include "lasertag_setup.h"
+#include "lasertag_power.h"
+
+#define IR_TX_PULSE_CNT		(2 + 2 * LASERTAG_IR_BITS)
+#define IR_TX_IDLE				0xFF
+// packet on air + waiting packets + one free slot of the ring
+#define IR_TX_SLOTS				(LASERTAG_IR_TX_QUEUE_LEN + 2)
+
+// RX - decoder fed from EXTI, frame gap counted down by SysTick
+static LASERTAG_IR_DecoderTypeDef IrDecoder = { 0xFF, 0 };
+static uint32_t IrMarkStart;
+static volatile uint8_t IrGap;
+
+// TX - packet on air and packets waiting for it, mark/space index of the
+// packet on air (even = mark), IR_TX_IDLE = IRTIM stopped
+static uint16_t IrTxPacket[IR_TX_SLOTS];
+static volatile uint8_t IrTxHead;
+static volatile uint8_t IrTxTail;
+static volatile uint8_t IrTxIndex = IR_TX_IDLE;
+
+static void LASERTAG_IR_TxConfig(void);
+
+
+void LASERTAG_IR_Init(void)
+{
+	LASERTAG_IR_TxConfig();
+}
+
+/**		IR_RX_Pin EXTI, both edges. Receiver output is active low.
+			Mark end is decoded here, hit goes straight to the game queue.
+*/
+void LASERTAG_IR_EdgeCallback(void)
+{
+	uint32_t Now = CYCLE_COUNTER();
+	uint32_t Width;
+	LASERTAG_GAME_EventTypeDef Event;
+	BaseType_t Woken = pdFALSE;
+	
+	// TIM2 and SysTick must run until the frame ends
+	LASERTAG_POWER_Hold(LASERTAG_POWER_HOLD_IR_RX);
+	IrGap = LASERTAG_IR_GAP_MS / portTICK_PERIOD_MS + 1;
+	
+	if ((IR_RX_GPIO_Port->IDR & IR_RX_Pin) == 0)
+	{
+		IrMarkStart = Now;
+		return;
+	}
+	
+	Width = (Now - IrMarkStart) / CYCLES_PER_US;
+	if (Width > 0xFFFF)
+		Width = 0xFFFF;
+	
+	if (LASERTAG_IR_Decode(&IrDecoder, (uint16_t)Width))
+	{
+		Event.Type = LASERTAG_GAME_EVENT_HIT;
+		Event.Reserved = 0;
+		Event.Data = IrDecoder.Packet;
+		Event.Time = Now;
+		LASERTAG_GAME_PostFromISR(&Event, &Woken);
+		portYIELD_FROM_ISR(Woken);
+	}
+}
+
+/**		SysTick, no edge for LASERTAG_IR_GAP_MS = frame aborted
+*/
+void LASERTAG_IR_Tick(void)
+{
+	uint32_t Primask;
+	
+	if (IrGap == 0)
+		return;
+	
+	// EXTI preempts SysTick
+	Primask = __get_PRIMASK();
+	__disable_irq();
+	if (IrGap != 0 && --IrGap == 0)
+	{
+		LASERTAG_IR_DecodeReset(&IrDecoder);
+		LASERTAG_POWER_Release(LASERTAG_POWER_HOLD_IR_RX);
+	}
+	__set_PRIMASK(Primask);
+}
+
+static uint8_t LASERTAG_IR_Near(uint16_t MarkUs, uint16_t Us)
+{
+	return (MarkUs > Us - LASERTAG_IR_TOLERANCE_US) && (MarkUs < Us + LASERTAG_IR_TOLERANCE_US);
+}
+
+static uint8_t LASERTAG_IR_Header(uint16_t MarkUs)
+{
+	return (MarkUs > LASERTAG_IR_HEADER_US - LASERTAG_IR_TOLERANCE_US - LASERTAG_IR_WAKE_US) &&
+				 (MarkUs < LASERTAG_IR_HEADER_US + LASERTAG_IR_TOLERANCE_US);
+}
+
+void LASERTAG_IR_DecodeReset(LASERTAG_IR_DecoderTypeDef *pDecoder)
+{
+	pDecoder->Bit = 0xFF;
+	pDecoder->Packet = 0;
+}
+
+/**		Feed one mark width
+			retval: TRUE complete packet in pDecoder->Packet
+*/
+uint8_t LASERTAG_IR_Decode(LASERTAG_IR_DecoderTypeDef *pDecoder, uint16_t MarkUs)
+{
+	if (LASERTAG_IR_Header(MarkUs))
+	{
+		pDecoder->Bit = 0;
+		pDecoder->Packet = 0;
+		return FALSE;
+	}
+	
+	if (pDecoder->Bit >= LASERTAG_IR_BITS)
+		return FALSE;
+	
+	if (LASERTAG_IR_Near(MarkUs, LASERTAG_IR_ONE_US))
+		pDecoder->Packet = (pDecoder->Packet << 1) | 1;
+	else if (LASERTAG_IR_Near(MarkUs, LASERTAG_IR_ZERO_US))
+		pDecoder->Packet <<= 1;
+	else
+	{
+		LASERTAG_IR_DecodeReset(pDecoder);
+		return FALSE;
+	}
+	
+	if (++pDecoder->Bit < LASERTAG_IR_BITS)
+		return FALSE;
+	
+	pDecoder->Bit = 0xFF;
+	// bit 13 = 0 marks shot packet
+	return (pDecoder->Packet & (1 << (LASERTAG_IR_BITS - 1))) == 0;
+}
+
+/**		IRTIM setup from game configuration
+			TIM17 carrier PWM, IrPower = duty 1/8..4/8
+			TIM16 envelope, 1us tick, output forced by TIM16 update interrupt
+*/
+static void LASERTAG_IR_TxConfig(void)
+{
+	uint32_t Carrier = LASERTAG_Setup.IrCarrier ? LASERTAG_Setup.IrCarrier : 56;
+	uint32_t Period = SystemCoreClock / (Carrier * 1000);
+	
+	TIM17->CR1 = 0;
+	TIM17->PSC = 0;
+	TIM17->ARR = Period - 1;
+	TIM17->CCR1 = Period * ((LASERTAG_Setup.IrPower & 0x03) + 1) / 8;
+	TIM17->CCMR1 = TIM_OCMODE_PWM1 | TIM_CCMR1_OC1PE;
+	TIM17->CCER = TIM_CCER_CC1E;
+	TIM17->BDTR = TIM_BDTR_MOE;
+	TIM17->EGR = TIM_EGR_UG;
+	
+	TIM16->CR1 = 0;
+	TIM16->PSC = SystemCoreClock / 1000000 - 1;
+	TIM16->CCMR1 = TIM_OCMODE_FORCED_INACTIVE;
+	TIM16->CCER = TIM_CCER_CC1E;
+	TIM16->BDTR = TIM_BDTR_MOE;
+}
+
+/**		Mark/space duration [us] of a packet, even index = mark
+*/
+static uint16_t LASERTAG_IR_TxPulse(uint16_t Packet, uint8_t Index)
+{
+	if (Index == 0)
+		return LASERTAG_IR_HEADER_US;
+	if (Index & 1)
+		return LASERTAG_IR_SPACE_US;
+	
+	return (Packet & (1 << (LASERTAG_IR_BITS - Index / 2))) ? LASERTAG_IR_ONE_US : LASERTAG_IR_ZERO_US;
+}
+
+/**		Start header mark of the packet at IrTxTail, TIM16 interrupt or
+			interrupts masked
+*/
+static void LASERTAG_IR_TxStart(void)
+{
+	IrTxIndex = 0;
+	TIM16->ARR = LASERTAG_IR_HEADER_US - 1;
+	TIM16->EGR = TIM_EGR_UG;
+	TIM16->SR = 0;
+	TIM16->CCMR1 = TIM_OCMODE_FORCED_ACTIVE;
+	TIM16->DIER = TIM_DIER_UIE;
+	TIM17->CR1 = TIM_CR1_CEN;
+	TIM16->CR1 = TIM_CR1_CEN;
+}
+
+/**		Queue shot packet, IRTIM starts at once when idle
+			retval: FALSE LASERTAG_IR_TX_QUEUE_LEN packets already waiting
+*/
+uint8_t LASERTAG_IR_Send(uint16_t Packet)
+{
+	uint8_t Head;
+	
+	taskENTER_CRITICAL();
+	Head = (IrTxHead + 1) % IR_TX_SLOTS;
+	if (Head == IrTxTail)
+	{
+		taskEXIT_CRITICAL();
+		return FALSE;
+	}
+	
+	IrTxPacket[IrTxHead] = Packet;
+	IrTxHead = Head;
+	if (IrTxIndex == IR_TX_IDLE)
+	{
+		LASERTAG_POWER_Hold(LASERTAG_POWER_HOLD_IR_TX);
+		LASERTAG_IR_TxStart();
+	}
+	taskEXIT_CRITICAL();
+	
+	return TRUE;
+}
+
+/**		TIM16 update - next mark/space, next packet or IRTIM off
+*/
+void LASERTAG_IR_TxTimerCallback(void)
+{
+	if (++IrTxIndex < IR_TX_PULSE_CNT)
+	{
+		TIM16->CCMR1 = (IrTxIndex & 1) ? TIM_OCMODE_FORCED_INACTIVE : TIM_OCMODE_FORCED_ACTIVE;
+		TIM16->ARR = LASERTAG_IR_TxPulse(IrTxPacket[IrTxTail], IrTxIndex) - 1;
+		return;
+	}
+	
+	IrTxTail = (IrTxTail + 1) % IR_TX_SLOTS;
+	if (IrTxTail != IrTxHead)
+	{
+		LASERTAG_IR_TxStart();
+		return;
+	}
+	
+	TIM16->CR1 = 0;
+	TIM16->DIER = 0;
+	TIM16->CCMR1 = TIM_OCMODE_FORCED_INACTIVE;
+	TIM17->CR1 = 0;
+	IrTxIndex = IR_TX_IDLE;
+	LASERTAG_POWER_Release(LASERTAG_POWER_HOLD_IR_TX);
+}
+
+/*****************************END OF FILE************************************/
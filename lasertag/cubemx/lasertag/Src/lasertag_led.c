@@ -0,0 +1,55 @@
+/**
+  ******************************************************************************
+  * File Name          : lasertag_led.c
+  * Description        : activity LEDs, low rate indicator task
+  ******************************************************************************
+  * author: Tomas Krejci <info@tomaskrejci.com>
+  *
+  *
+  ******************************************************************************
+  */
+#include "main.h"
+#include "cmsis_os.h"
+#include "lasertag_led.h"
+
+
+/**		Report activity from task
+*/
+void LASERTAG_LED_Activity(uint32_t Led)
+{
+	if (ledTaskHandle != NULL)
+		xTaskNotify(ledTaskHandle, Led, eSetBits);
+}
+
+/**		Report activity from ISR, caller yields on *pWoken
+*/
+void LASERTAG_LED_ActivityFromISR(uint32_t Led, BaseType_t *pWoken)
+{
+	if (ledTaskHandle != NULL)
+		xTaskNotifyFromISR(ledTaskHandle, Led, eSetBits, pWoken);
+}
+
+void LASERTAG_LED_Task(void const *argument)
+{
+	uint32_t Led;
+	
+	for (;;)
+	{
+		// activity during the blink is collected for the next one
+		xTaskNotifyWait(0, 0xFFFFFFFF, &Led, portMAX_DELAY);
+		
+		if (Led & LASERTAG_LED_LINK)
+			PIN_HIGH(LD3);
+		if (Led & LASERTAG_LED_FLASH)
+			PIN_HIGH(LD4);
+		
+		osDelay(LASERTAG_LED_ON_MS);
+		
+		PIN_LOW(LD3);
+		PIN_LOW(LD4);
+		
+		osDelay(LASERTAG_LED_PERIOD_MS - LASERTAG_LED_ON_MS);
+	}
+}
+
+/*****************************END OF FILE************************************/
@@ -0,0 +1,317 @@
+/**
+  ******************************************************************************
+  * File Name          : lasertag_power.c
+  * Description        : tickless idle, STOP mode and energy accounting
+  ******************************************************************************
+  * author: Tomas Krejci <info@tomaskrejci.com>
+  *
+  *
+  ******************************************************************************
+  */
+#include "main.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include "lasertag_power.h"
+#include "lasertag_trace.h"
+
+// RTC clock LSI ~40kHz, ck_apre ~10kHz, sub second counter 9999..0
+#define POWER_RTC_PREDIV_A		3
+#define POWER_RTC_PREDIV_S		9999
+#define POWER_RTC_SS_CNT			(POWER_RTC_PREDIV_S + 1)
+// LSI calibration window [sub second counts]
+#define POWER_RTC_CAL_CNT			1000
+
+LASERTAG_POWER_StatsTypeDef LASERTAG_POWER_Stats[LASERTAG_POWER_PHASE_CNT];
+
+static volatile uint32_t PowerHold;
+static volatile TickType_t PowerAwakeUntil;
+// measured sub second counter rate [Hz], 0 = RTC not running -> no STOP
+static uint32_t PowerRtcHz;
+// sub second counts not yet stepped into ticks
+static uint32_t PowerStopCarry;
+static uint32_t PowerSleepCycles;
+static uint8_t PowerPhase;
+static TickType_t PowerPhaseStart;
+
+
+static uint32_t LASERTAG_POWER_SubSecond(void)
+{
+	uint32_t Ss;
+	
+	// BYPSHAD - read counter twice for stable value
+	do
+	{
+		Ss = RTC->SSR;
+	} while (Ss != RTC->SSR);
+	
+	return Ss;
+}
+
+/**		RTC on LSI, alarm A compares sub seconds only
+*/
+static void LASERTAG_POWER_RtcInit(void)
+{
+	uint32_t Ss, Start, Cycles;
+	
+	__HAL_RCC_PWR_CLK_ENABLE();
+	PWR->CR |= PWR_CR_DBP;
+	
+	RCC->CSR |= RCC_CSR_LSION;
+	while ((RCC->CSR & RCC_CSR_LSIRDY) == 0);
+	
+	if ((RCC->BDCR & RCC_BDCR_RTCSEL) != RCC_BDCR_RTCSEL_LSI)
+	{
+		RCC->BDCR |= RCC_BDCR_BDRST;
+		RCC->BDCR &= ~RCC_BDCR_BDRST;
+		RCC->BDCR |= RCC_BDCR_RTCSEL_LSI;
+	}
+	RCC->BDCR |= RCC_BDCR_RTCEN;
+	
+	RTC->WPR = 0xCA;
+	RTC->WPR = 0x53;
+	
+	RTC->ISR |= RTC_ISR_INIT;
+	while ((RTC->ISR & RTC_ISR_INITF) == 0);
+	RTC->PRER = POWER_RTC_PREDIV_S;
+	RTC->PRER |= (uint32_t)POWER_RTC_PREDIV_A << 16;
+	RTC->ISR &= ~RTC_ISR_INIT;
+	
+	RTC->CR = RTC_CR_BYPSHAD;
+	while ((RTC->ISR & RTC_ISR_ALRAWF) == 0);
+	RTC->ALRMAR = RTC_ALRMAR_MSK4 | RTC_ALRMAR_MSK3 | RTC_ALRMAR_MSK2 | RTC_ALRMAR_MSK1;
+	
+	RTC->WPR = 0xFF;
+	
+	EXTI->IMR |= EXTI_IMR_MR17;
+	EXTI->RTSR |= EXTI_RTSR_TR17;
+	HAL_NVIC_SetPriority(RTC_IRQn, 3, 0);
+	HAL_NVIC_EnableIRQ(RTC_IRQn);
+	
+	// LSI is +-50%, measure it against CYCLE_COUNTER
+	Ss = LASERTAG_POWER_SubSecond();
+	while (LASERTAG_POWER_SubSecond() == Ss);
+	Ss = LASERTAG_POWER_SubSecond();
+	Start = CYCLE_COUNTER();
+	while ((Ss + POWER_RTC_SS_CNT - LASERTAG_POWER_SubSecond()) % POWER_RTC_SS_CNT < POWER_RTC_CAL_CNT);
+	Cycles = CYCLE_COUNTER() - Start;
+	
+	PowerRtcHz = (uint32_t)((uint64_t)POWER_RTC_CAL_CNT * SystemCoreClock / Cycles);
+}
+
+/**		Start before LASERTAG_BOARD_Init (USART reconfig) and after TIM2
+*/
+void LASERTAG_POWER_Init(void)
+{
+	UART_WakeUpTypeDef WakeUp;
+	
+	LASERTAG_POWER_RtcInit();
+	
+	// USART1 on HSI keeps receiving in STOP, start bit wakes MCU
+	WakeUp.WakeUpEvent = UART_WAKEUP_ON_STARTBIT;
+	WakeUp.AddressLength = UART_ADDRESS_DETECT_4B;
+	WakeUp.Address = 0;
+	HAL_UARTEx_StopModeWakeUpSourceConfig(&huart1, WakeUp);
+	__HAL_UART_ENABLE_IT(&huart1, UART_IT_WUF);
+	HAL_UARTEx_EnableStopMode(&huart1);
+}
+
+/**		Hold bits, task or ISR context
+*/
+void LASERTAG_POWER_Hold(uint32_t Hold)
+{
+	uint32_t Primask = __get_PRIMASK();
+	
+	__disable_irq();
+	PowerHold |= Hold;
+	__set_PRIMASK(Primask);
+}
+
+void LASERTAG_POWER_Release(uint32_t Hold)
+{
+	uint32_t Primask = __get_PRIMASK();
+	
+	__disable_irq();
+	PowerHold &= ~Hold;
+	__set_PRIMASK(Primask);
+}
+
+uint8_t LASERTAG_POWER_Held(uint32_t Hold)
+{
+	return (PowerHold & Hold) != 0;
+}
+
+/**		No STOP for Ms, ISR context
+*/
+void LASERTAG_POWER_Awake(uint32_t Ms)
+{
+	PowerAwakeUntil = xTaskGetTickCountFromISR() + Ms / portTICK_PERIOD_MS;
+}
+
+/**		RTC alarm - only wakes from STOP
+*/
+void LASERTAG_POWER_AlarmCallback(void)
+{
+	RTC->ISR &= ~RTC_ISR_ALRAF;
+	EXTI->PR = EXTI_PR_PR17;
+}
+
+/**		USART1 start bit in STOP - the rest of pc packet comes soon
+*/
+void LASERTAG_POWER_LinkWakeupCallback(void)
+{
+	LASERTAG_POWER_Awake(LASERTAG_POWER_LINK_MS);
+}
+
+static void LASERTAG_POWER_Account(void)
+{
+	TickType_t Now = xTaskGetTickCount();
+	
+	LASERTAG_POWER_Stats[PowerPhase].Time += Now - PowerPhaseStart;
+	PowerPhaseStart = Now;
+}
+
+/**		Game phase change, closes residency of previous phase
+*/
+void LASERTAG_POWER_Phase(uint8_t Phase)
+{
+	if (Phase >= LASERTAG_POWER_PHASE_CNT)
+		return;
+	
+	vTaskSuspendAll();
+	LASERTAG_POWER_Account();
+	PowerPhase = Phase;
+	xTaskResumeAll();
+}
+
+/**		Average current of game phase from residency and current model
+			retval: [uA], 0 = phase not entered yet
+*/
+uint32_t LASERTAG_POWER_Current(uint8_t Phase)
+{
+	LASERTAG_POWER_StatsTypeDef Stats;
+	uint32_t Run;
+	
+	if (Phase >= LASERTAG_POWER_PHASE_CNT)
+		return 0;
+	
+	vTaskSuspendAll();
+	LASERTAG_POWER_Account();
+	Stats = LASERTAG_POWER_Stats[Phase];
+	xTaskResumeAll();
+	
+	if (Stats.Time == 0)
+		return 0;
+	
+	Run = (Stats.Sleep + Stats.Stop < Stats.Time) ? Stats.Time - Stats.Sleep - Stats.Stop : 0;
+	
+	return (uint32_t)(((uint64_t)Run * LASERTAG_POWER_RUN_UA +
+										 (uint64_t)Stats.Sleep * LASERTAG_POWER_SLEEP_UA +
+										 (uint64_t)Stats.Stop * LASERTAG_POWER_STOP_UA) / Stats.Time) + LASERTAG_POWER_BOARD_UA;
+}
+
+/**		After STOP system clock is HSI, PLL setup is kept in RCC_CFGR
+*/
+static void LASERTAG_POWER_ClockRestore(void)
+{
+	RCC->CR |= RCC_CR_PLLON;
+	while ((RCC->CR & RCC_CR_PLLRDY) == 0);
+	
+	RCC->CFGR = (RCC->CFGR & ~RCC_CFGR_SW) | RCC_CFGR_SW_PLL;
+	while ((RCC->CFGR & RCC_CFGR_SWS) != RCC_CFGR_SWS_PLL);
+}
+
+static void LASERTAG_POWER_Alarm(uint32_t Ss, uint8_t Enable)
+{
+	RTC->WPR = 0xCA;
+	RTC->WPR = 0x53;
+	
+	RTC->CR &= ~(RTC_CR_ALRAE | RTC_CR_ALRAIE);
+	if (Enable)
+	{
+		while ((RTC->ISR & RTC_ISR_ALRAWF) == 0);
+		// compare SS[13:0], POWER_RTC_PREDIV_S < 0x4000
+		RTC->ALRMASSR = (14UL << 24) | Ss;
+		RTC->ISR &= ~RTC_ISR_ALRAF;
+		EXTI->PR = EXTI_PR_PR17;
+		RTC->CR |= RTC_CR_ALRAE | RTC_CR_ALRAIE;
+	}
+	
+	RTC->WPR = 0xFF;
+}
+
+static void LASERTAG_POWER_Sleep(void)
+{
+	uint32_t Start = CYCLE_COUNTER();
+	
+	__WFI();
+	
+	PowerSleepCycles += CYCLE_COUNTER() - Start;
+	LASERTAG_POWER_Stats[PowerPhase].Sleep += PowerSleepCycles / (CYCLES_PER_US * 1000);
+	PowerSleepCycles %= CYCLES_PER_US * 1000;
+}
+
+/**		Tickless idle, replaces the SysTick based port implementation
+			called by idle task with scheduler suspended
+*/
+void vPortSuppressTicksAndSleep(TickType_t xExpectedIdleTime)
+{
+	uint32_t Ss, Counts;
+	TickType_t Ms;
+	
+	__disable_irq();
+	
+	if (eTaskConfirmSleepModeStatus() == eAbortSleep)
+	{
+		__enable_irq();
+		return;
+	}
+	
+	// SLEEP, tick keeps running, any interrupt ends it
+	if (PowerHold != 0 || PowerRtcHz == 0 ||
+			xExpectedIdleTime < LASERTAG_POWER_STOP_MIN_MS / portTICK_PERIOD_MS ||
+			(int32_t)(PowerAwakeUntil - xTaskGetTickCount()) > 0)
+	{
+		LASERTAG_POWER_Sleep();
+		__enable_irq();
+		return;
+	}
+	
+	if (xExpectedIdleTime > LASERTAG_POWER_STOP_MAX_MS / portTICK_PERIOD_MS)
+		xExpectedIdleTime = LASERTAG_POWER_STOP_MAX_MS / portTICK_PERIOD_MS;
+	
+	// STOP, part of current tick period is lost (< 1ms)
+	SysTick->CTRL &= ~SysTick_CTRL_ENABLE_Msk;
+	HAL_SuspendTick();
+	
+	LASERTAG_TRACE_Put(LASERTAG_TRACE_APP, LASERTAG_TRACE_STOP_ENTER, xExpectedIdleTime);
+	Ss = LASERTAG_POWER_SubSecond();
+	Counts = xExpectedIdleTime * portTICK_PERIOD_MS * PowerRtcHz / 1000;
+	LASERTAG_POWER_Alarm((Ss + POWER_RTC_SS_CNT - Counts) % POWER_RTC_SS_CNT, TRUE);
+	
+	HAL_PWR_EnterSTOPMode(PWR_LOWPOWERREGULATOR_ON, PWR_STOPENTRY_WFI);
+	
+	LASERTAG_POWER_ClockRestore();
+	LASERTAG_POWER_Alarm(0, FALSE);
+	
+	Counts = (Ss + POWER_RTC_SS_CNT - LASERTAG_POWER_SubSecond()) % POWER_RTC_SS_CNT + PowerStopCarry;
+	Ms = Counts * 1000 / PowerRtcHz;
+	PowerStopCarry = Counts - Ms * PowerRtcHz / 1000;
+	if (Ms / portTICK_PERIOD_MS > xExpectedIdleTime)
+	{
+		Ms = xExpectedIdleTime * portTICK_PERIOD_MS;
+		PowerStopCarry = 0;
+	}
+	
+	vTaskStepTick(Ms / portTICK_PERIOD_MS);
+	LASERTAG_POWER_Stats[PowerPhase].Stop += Ms;
+	LASERTAG_POWER_Stats[PowerPhase].StopCnt++;
+	LASERTAG_TRACE_Put(LASERTAG_TRACE_APP, LASERTAG_TRACE_STOP_EXIT, Ms);
+	
+	SysTick->VAL = 0;
+	SysTick->CTRL |= SysTick_CTRL_ENABLE_Msk;
+	HAL_ResumeTick();
+	
+	__enable_irq();
+}
+
+/*****************************END OF FILE************************************/
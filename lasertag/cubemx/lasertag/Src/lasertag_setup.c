@@ -0,0 +1,145 @@
+/**
+  ******************************************************************************
+  * File Name          : lasertag_setup.c
+  * Description        : game configuration - validation, migration, RAM copy
+  ******************************************************************************
+  * author: Tomas Krejci <info@tomaskrejci.com>
+  *
+  *
+  ******************************************************************************
+  */
+#include <string.h>
+#include <stddef.h>
+#include "main.h"
+#include "cmsis_os.h"
+#include "setup_store.h"
+#include "lasertag_setup.h"
+
+#define SETUP_HEAD_SIZE		offsetof(LASERTAG_SetupTypeDef, Team)
+#define SETUP_CRC_SIZE		sizeof(uint16_t)
+
+// image must fit one setup store record
+typedef char LASERTAG_SETUP_SizeCheck[(sizeof(LASERTAG_SetupTypeDef) <= SETUP_STORE_VALUE_MAX) ? 1 : -1];
+
+// game configuration, used in place by all tasks
+LASERTAG_SetupTypeDef LASERTAG_Setup;
+
+static const LASERTAG_SetupTypeDef SetupDefault =
+{
+	LASERTAG_SETUP_MAGIC,
+	LASERTAG_SETUP_VERSION,
+	sizeof(LASERTAG_SetupTypeDef),
+
+	0,														// Team
+	1,														// Player
+	100,													// Health
+	0,														// Lives
+	30,														// Ammo
+	100,													// RespawnTime 10s
+	0,														// GameTime
+	FALSE,												// FriendlyFire
+	1,														// Damage
+	{ 1, 2, 4, 5, 7, 10, 15, 17, 20, 25, 30, 35, 40, 50, 75, 100 },
+	LASERTAG_IR_PROTOCOL_MILESTAG,
+	3,														// IrPower
+	56,														// IrCarrier 56kHz
+	200,													// Volume
+	{ 0, 1, 2, 3, 4, 5, 6, 7 },		// SoundMap
+
+	0															// Crc
+};
+
+
+static uint16_t LASERTAG_SETUP_Crc(const uint8_t *pImage, uint8_t Size)
+{
+	return CRC16_Calc(CRC16_INIT, pImage, Size - SETUP_CRC_SIZE);
+}
+
+/**		Check stored image header and crc
+			retval: TRUE valid image of any known version
+*/
+static uint8_t LASERTAG_SETUP_Valid(const uint8_t *pImage, uint8_t Size)
+{
+	const LASERTAG_SetupTypeDef *pSetup = (const LASERTAG_SetupTypeDef *)pImage;
+	uint16_t Crc;
+
+	if ((Size < SETUP_HEAD_SIZE + SETUP_CRC_SIZE) || (pSetup->Size != Size))
+		return FALSE;
+	if ((pSetup->Magic != LASERTAG_SETUP_MAGIC) || (pSetup->Version == 0) ||
+			(pSetup->Version > LASERTAG_SETUP_VERSION))
+		return FALSE;
+
+	Crc = pImage[Size - 2] | ((uint16_t)pImage[Size - 1] << 8);
+	return (LASERTAG_SETUP_Crc(pImage, Size) == Crc);
+}
+
+/**		Migrate older image in LASERTAG_Setup to current version
+			Fields are only appended, stored prefix keeps its meaning.
+*/
+static void LASERTAG_SETUP_Migrate(uint8_t Size)
+{
+	uint8_t Image[sizeof(LASERTAG_SetupTypeDef)];
+
+	memcpy(Image, &LASERTAG_Setup, Size - SETUP_CRC_SIZE);
+	LASERTAG_Setup = SetupDefault;
+	memcpy((uint8_t *)&LASERTAG_Setup + SETUP_HEAD_SIZE, Image + SETUP_HEAD_SIZE,
+				 Size - SETUP_CRC_SIZE - SETUP_HEAD_SIZE);
+
+	/* non append changes of older versions go here:
+	switch (((LASERTAG_SetupTypeDef *)Image)->Version)
+	{
+		case 1: ...
+	}
+	*/
+
+	LASERTAG_SETUP_Save();
+}
+
+/**		Load game configuration into RAM copy, no field parsing
+			invalid image -> defaults, older version -> migrate
+*/
+void LASERTAG_SETUP_Init(void)
+{
+	uint8_t Size = sizeof(LASERTAG_SetupTypeDef);
+
+	if (SETUP_STORE_Read(LASERTAG_SETUP_KEY, (uint8_t *)&LASERTAG_Setup, &Size) != SETUP_STORE_OK ||
+			Size > sizeof(LASERTAG_SetupTypeDef) ||
+			!LASERTAG_SETUP_Valid((uint8_t *)&LASERTAG_Setup, Size))
+	{
+		LASERTAG_Setup = SetupDefault;
+		LASERTAG_SETUP_Save();
+		return;
+	}
+
+	if (LASERTAG_Setup.Version != LASERTAG_SETUP_VERSION)
+		LASERTAG_SETUP_Migrate(Size);
+}
+
+/**		Store RAM copy, one setup store record
+*/
+uint8_t LASERTAG_SETUP_Save(void)
+{
+	LASERTAG_Setup.Crc = LASERTAG_SETUP_Crc((uint8_t *)&LASERTAG_Setup, sizeof(LASERTAG_SetupTypeDef));
+
+	return SETUP_STORE_Write(LASERTAG_SETUP_KEY, (uint8_t *)&LASERTAG_Setup, sizeof(LASERTAG_SetupTypeDef));
+}
+
+/**		Overwrite part of configuration (pc link) and store it
+			Runs in storage task only (pc link job), that serialises patches and
+			saves. Tasks reading LASERTAG_Setup see a field either old or new.
+			param: Offset - byte offset in LASERTAG_SetupTypeDef, header and Crc are read only
+*/
+uint8_t LASERTAG_SETUP_Patch(uint8_t Offset, const uint8_t *pData, uint8_t Size)
+{
+	if ((Offset < SETUP_HEAD_SIZE) ||
+			(Offset + Size > sizeof(LASERTAG_SetupTypeDef) - SETUP_CRC_SIZE))
+		return SETUP_STORE_ERROR;
+
+	taskENTER_CRITICAL();
+	memcpy((uint8_t *)&LASERTAG_Setup + Offset, pData, Size);
+	taskEXIT_CRITICAL();
+
+	return LASERTAG_SETUP_Save();
+}
+
+/*****************************END OF FILE************************************/
@@ -0,0 +1,154 @@
+/**
+  ******************************************************************************
+  * File Name          : lasertag_storage.c
+  * Description        : flash I/O task - the only task touching the serial flash
+  ******************************************************************************
+  * author: Tomas Krejci <info@tomaskrejci.com>
+  *
+  *
+  ******************************************************************************
+  */
+#include "main.h"
+#include "cmsis_os.h"
+#include "lasertag_storage.h"
+#include "lasertag_diag.h"
+#include "lasertag_trace.h"
+#include "lasertag_led.h"
+#include "flash_cache.h"
+
+// queue of job pointers, job lives on the blocked caller stack
+static QueueHandle_t StorageQueue;
+static StaticQueue_t StorageQueueBuffer;
+static uint8_t StorageQueueStorage[LASERTAG_STORAGE_QUEUE_LEN * sizeof(LASERTAG_STORAGE_JobTypeDef *)];
+
+// read-ahead after a cache hit, nobody waits for it
+static uint8_t LASERTAG_STORAGE_PrefetchJob(void *pArg);
+static LASERTAG_STORAGE_JobTypeDef StoragePrefetch = LASERTAG_STORAGE_JOB(LASERTAG_STORAGE_PrefetchJob);
+static volatile uint8_t StoragePrefetchQueued;
+
+
+void LASERTAG_STORAGE_Init(void)
+{
+	StorageQueue = xQueueCreateStatic(LASERTAG_STORAGE_QUEUE_LEN, sizeof(LASERTAG_STORAGE_JobTypeDef *),
+																		StorageQueueStorage, &StorageQueueBuffer);
+	LASERTAG_DIAG_Queue(StorageQueue, LASERTAG_DIAG_QUEUE_STORAGE);
+	FLASH_CACHE_Invalidate();
+}
+
+static uint8_t LASERTAG_STORAGE_PrefetchJob(void *pArg)
+{
+	StoragePrefetchQueued = FALSE;
+	FLASH_CACHE_Prefetch();
+	
+	return FLASH_OK;
+}
+
+/**		Post job and wait for the storage task
+*/
+static uint8_t LASERTAG_STORAGE_Post(LASERTAG_STORAGE_JobTypeDef *pJob)
+{
+	pJob->Caller = xTaskGetCurrentTaskHandle();
+	pJob->Result = FLASH_ERROR;
+	
+	xQueueSend(StorageQueue, &pJob, portMAX_DELAY);
+	NOTIFY_Wait(LASERTAG_STORAGE_NOTIFY, portMAX_DELAY);
+	
+	return pJob->Result;
+}
+
+/**		Read flash block, cache hit returns at once, miss blocks caller task
+			retval: FLASH_OK / FLASH_ERROR
+*/
+uint8_t LASERTAG_STORAGE_Read(uint32_t Address, uint8_t *pData, uint32_t Size)
+{
+	LASERTAG_STORAGE_JobTypeDef Job;
+	LASERTAG_STORAGE_JobTypeDef *pJob = &StoragePrefetch;
+	
+	if (FLASH_CACHE_Lookup(Address, pData, Size))
+	{
+		if (FLASH_CACHE_Pending() && !StoragePrefetchQueued)
+		{
+			StoragePrefetchQueued = TRUE;
+			if (!LASERTAG_STORAGE_Queue(pJob))
+				StoragePrefetchQueued = FALSE;
+		}
+		return FLASH_OK;
+	}
+	
+	Job.Function = NULL;
+	Job.pArg = NULL;
+	Job.Address = Address;
+	Job.pData = pData;
+	Job.Size = Size;
+	
+	return LASERTAG_STORAGE_Post(&Job);
+}
+
+/**		Run Function(pArg) in storage task context, blocks caller task
+			retval: return value of Function
+*/
+uint8_t LASERTAG_STORAGE_Call(LASERTAG_STORAGE_FunctionTypeDef Function, void *pArg)
+{
+	LASERTAG_STORAGE_JobTypeDef Job;
+	
+	Job.Function = Function;
+	Job.pArg = pArg;
+	Job.Address = 0;
+	Job.pData = NULL;
+	Job.Size = 0;
+	
+	return LASERTAG_STORAGE_Post(&Job);
+}
+
+/**		Queue job nobody waits for, task context, does not block
+			pJob (LASERTAG_STORAGE_JOB) must stay valid until it ran
+			retval: FALSE queue full
+*/
+uint8_t LASERTAG_STORAGE_Queue(LASERTAG_STORAGE_JobTypeDef *pJob)
+{
+	return xQueueSend(StorageQueue, &pJob, 0) == pdPASS;
+}
+
+/**		Same from ISR, caller yields on *pWoken
+			retval: FALSE queue full or not created yet
+*/
+uint8_t LASERTAG_STORAGE_QueueFromISR(LASERTAG_STORAGE_JobTypeDef *pJob, BaseType_t *pWoken)
+{
+	if (StorageQueue == NULL)
+		return FALSE;
+	
+	return xQueueSendFromISR(StorageQueue, &pJob, pWoken) == pdPASS;
+}
+
+void LASERTAG_STORAGE_Task(void const *argument)
+{
+	LASERTAG_STORAGE_JobTypeDef *pJob;
+	
+	for (;;)
+	{
+		xQueueReceive(StorageQueue, &pJob, portMAX_DELAY);
+		LASERTAG_TRACE_Put(LASERTAG_TRACE_APP, LASERTAG_TRACE_STORAGE_BEGIN, pJob->Size);
+		LASERTAG_LED_Activity(LASERTAG_LED_FLASH);
+		
+		if (pJob == &StoragePrefetch)
+			pJob->Result = pJob->Function(pJob->pArg);
+		else if (pJob->Function != NULL)
+		{
+			// function may write flash (setup store, pc link) - drop cache
+			pJob->Result = pJob->Function(pJob->pArg);
+			FLASH_CACHE_Invalidate();
+		}
+		else
+			pJob->Result = FLASH_CACHE_Read(pJob->Address, pJob->pData, pJob->Size);
+		
+		LASERTAG_TRACE_Put(LASERTAG_TRACE_APP, LASERTAG_TRACE_STORAGE_END, pJob->Result);
+		if (pJob->Caller != NULL)
+			xTaskNotify(pJob->Caller, LASERTAG_STORAGE_NOTIFY, eSetBits);
+		
+		// read-ahead of a missed stream, only when nobody waits
+		if (FLASH_CACHE_Pending() && uxQueueMessagesWaiting(StorageQueue) == 0)
+			FLASH_CACHE_Prefetch();
+	}
+}
+
+/*****************************END OF FILE************************************/
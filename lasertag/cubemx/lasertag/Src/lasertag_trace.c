@@ -0,0 +1,74 @@
+/**
+  ******************************************************************************
+  * File Name          : lasertag_trace.c
+  * Description        : RAM trace ring for ISR and task events
+  ******************************************************************************
+  * author: Tomas Krejci <info@tomaskrejci.com>
+  *
+  *
+  ******************************************************************************
+  */
+#include "main.h"
+#include "lasertag_trace.h"
+
+#if LASERTAG_TRACE
+
+// records per pc link page
+#define TRACE_PAGE_RECS		32
+
+LASERTAG_TRACE_RecordTypeDef LASERTAG_TraceRing[LASERTAG_TRACE_SIZE];
+// records written since boot, ring position = index mod size
+uint32_t LASERTAG_TraceIndex;
+volatile uint32_t LASERTAG_TraceMask = LASERTAG_TRACE_DEFAULT;
+
+
+/**		traceTASK_SWITCHED_IN hook, PendSV with interrupts masked
+*/
+void LASERTAG_TRACE_TaskIn(const char *pName)
+{
+	LASERTAG_TRACE_Put(LASERTAG_TRACE_TASK, LASERTAG_TRACE_TASK_IN,
+										 (uint8_t)pName[0] | ((uint32_t)(uint8_t)pName[1] << 8) | ((uint32_t)(uint8_t)pName[2] << 16));
+}
+
+/**		Copy page of records, oldest first, trace should be frozen (mask 0)
+			<index 4B>	<core clock 4B>	<record cnt>	<records...>
+			retval: size in bytes
+*/
+uint32_t LASERTAG_TRACE_Read(uint8_t Page, uint8_t *pData)
+{
+	uint32_t Index = LASERTAG_TraceIndex;
+	uint32_t Cnt = (Index < LASERTAG_TRACE_SIZE) ? Index : LASERTAG_TRACE_SIZE;
+	uint32_t First = Index - Cnt + (uint32_t)Page * TRACE_PAGE_RECS;
+	uint32_t i, n = 0;
+	uint8_t *p = pData + 9;
+	LASERTAG_TRACE_RecordTypeDef *pRec;
+	
+	for (i = First; i < Index && n < TRACE_PAGE_RECS; i++, n++)
+	{
+		pRec = &LASERTAG_TraceRing[i & (LASERTAG_TRACE_SIZE - 1)];
+		*p++ = (uint8_t)(pRec->Time);
+		*p++ = (uint8_t)(pRec->Time >> 8);
+		*p++ = (uint8_t)(pRec->Time >> 16);
+		*p++ = (uint8_t)(pRec->Time >> 24);
+		*p++ = (uint8_t)(pRec->Event >> 24);
+		*p++ = (uint8_t)(pRec->Event);
+		*p++ = (uint8_t)(pRec->Event >> 8);
+		*p++ = (uint8_t)(pRec->Event >> 16);
+	}
+	
+	pData[0] = (uint8_t)(Index);
+	pData[1] = (uint8_t)(Index >> 8);
+	pData[2] = (uint8_t)(Index >> 16);
+	pData[3] = (uint8_t)(Index >> 24);
+	pData[4] = (uint8_t)(SystemCoreClock);
+	pData[5] = (uint8_t)(SystemCoreClock >> 8);
+	pData[6] = (uint8_t)(SystemCoreClock >> 16);
+	pData[7] = (uint8_t)(SystemCoreClock >> 24);
+	pData[8] = (uint8_t)n;
+	
+	return (uint32_t)(p - pData);
+}
+
+#endif /* LASERTAG_TRACE */
+
+/*****************************END OF FILE************************************/
@@ -42,6 +42,11 @@
 
 /* USER CODE BEGIN Includes */
 #include "main.h"
+#include "fatfs.h"
+#include "setup_store.h"
+#include "lasertag_setup.h"
+#include "lasertag_power.h"
+#include "lasertag_diag.h"
 
 /* USER CODE END Includes */
 
@@ -70,6 +75,7 @@ int main(void)
 {
 
   /* USER CODE BEGIN 1 */
+	LASERTAG_DIAG_StackFill();
 
   /* USER CODE END 1 */
 
@@ -91,25 +97,30 @@ int main(void)
   MX_TIM17_Init();
 
   /* USER CODE BEGIN 2 */
+	// peripherals not in lasertag.ioc
+	LASERTAG_GPIO_Init();
+	MX_TIM2_Init();
+	MX_TIM15_Init();
+	MX_FATFS_Init();
 	
-	
-	
+	// SPI1 owned by the bus layer, flash is its first device
+	SPI_BUS_Init();
 	BSP_SERIAL_FLASH_Init();
-	LASERTAG_BOARD_Init();
 	
+	// flash test without erase - sector 0x000000 holds setup store
+	if (BSP_SERIAL_FLASH_ReadID() == 0x000000 || BSP_SERIAL_FLASH_ReadID() == 0xFFFFFF)
+	{
+		Error_Handler();
+	}
 	
+	SETUP_STORE_Init();
+	LASERTAG_SETUP_Init();
 	
-
-  //uint32_t FlashId;
-	uint8_t TxTemp[16] = "TEST";
-	uint8_t RXTemp[16];
+	// cycle time stamps (CYCLE_COUNTER)
+	HAL_TIM_Base_Start(&htim2);
 	
-	BSP_SERIAL_FLASH_EraseSector(0x000000);
-	BSP_SERIAL_FLASH_WritePage(0x000000, (uint8_t*) TxTemp, 16);
-	BSP_SERIAL_FLASH_ReadData(0x000000, (uint8_t*) RXTemp, 16);
-	HAL_Delay(1500);
-
-	BSP_SERIAL_FLASH_ReadData(0x000002, (uint8_t*) RXTemp, 16);
+	LASERTAG_POWER_Init();
+	LASERTAG_BOARD_Init();
   /* USER CODE END 2 */
 
   /* Call init function for freertos objects (in freertos.c) */
@@ -127,7 +138,7 @@ int main(void)
   /* USER CODE END WHILE */
 
   /* USER CODE BEGIN 3 */
-		HAL_GPIO_TogglePin(LD4_GPIO_Port, LD4_Pin); //blue
+		PIN_TOGGLE(LD4); //blue
 		
 		HAL_Delay(1500);
 		
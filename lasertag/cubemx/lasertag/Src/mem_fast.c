@@ -0,0 +1,149 @@
+/**
+  ******************************************************************************
+  * File Name          : mem_fast.c
+  * Description        : copy, fill and compare tuned for Cortex-M0
+  ******************************************************************************
+  * author: Tomas Krejci <info@tomaskrejci.com>
+  *
+  *
+  ******************************************************************************
+  */
+#include "mem_fast.h"
+
+#define MEM_FAST_ALIGN(p)		((uint32_t)(p) & 3)
+
+
+/**		Destination aligned, source at Shift bytes (1..3) past a word
+			boundary. Source words are read aligned - the last one may hold
+			up to 3 bytes behind the source end, always in the same word.
+*/
+static uint8_t *MEM_FAST_CopyShifted(uint32_t *pDst, const uint8_t *pSrc, uint32_t Words)
+{
+	const uint32_t *pWord = (const uint32_t *)(pSrc - MEM_FAST_ALIGN(pSrc));
+	uint32_t Right = MEM_FAST_ALIGN(pSrc) * 8, Left = 32 - Right;
+	uint32_t Prev, Next;
+
+	Prev = *pWord++;
+	while (Words--)
+	{
+		Next = *pWord++;
+		*pDst++ = (Prev >> Right) | (Next << Left);
+		Prev = Next;
+	}
+
+	return (uint8_t *)pDst;
+}
+
+void MEM_FAST_Copy(void *pDst, const void *pSrc, uint32_t Size)
+{
+	uint8_t *d = (uint8_t *)pDst;
+	const uint8_t *s = (const uint8_t *)pSrc;
+	uint32_t *dw;
+	const uint32_t *sw;
+	uint32_t w0, w1, w2, w3;
+
+	if (Size >= 8)
+	{
+		while (MEM_FAST_ALIGN(d))
+		{
+			*d++ = *s++;
+			Size--;
+		}
+
+		if (MEM_FAST_ALIGN(s) == 0)
+		{
+			dw = (uint32_t *)d;
+			sw = (const uint32_t *)s;
+
+			// 4 loads + 4 stores -> LDM/STM
+			for (; Size >= 16; Size -= 16)
+			{
+				w0 = sw[0]; w1 = sw[1]; w2 = sw[2]; w3 = sw[3];
+				sw += 4;
+				dw[0] = w0; dw[1] = w1; dw[2] = w2; dw[3] = w3;
+				dw += 4;
+			}
+			for (; Size >= 4; Size -= 4)
+				*dw++ = *sw++;
+
+			d = (uint8_t *)dw;
+			s = (const uint8_t *)sw;
+		}
+		else
+		{
+			d = MEM_FAST_CopyShifted((uint32_t *)d, s, Size / 4);
+			s += Size & ~3;
+			Size &= 3;
+		}
+	}
+
+	while (Size--)
+		*d++ = *s++;
+}
+
+void MEM_FAST_Set(void *pDst, int Value, uint32_t Size)
+{
+	uint8_t *d = (uint8_t *)pDst;
+	uint32_t *dw;
+	uint32_t w = (uint8_t)Value;
+
+	if (Size >= 8)
+	{
+		while (MEM_FAST_ALIGN(d))
+		{
+			*d++ = (uint8_t)w;
+			Size--;
+		}
+
+		w |= w << 8;
+		w |= w << 16;
+		dw = (uint32_t *)d;
+		for (; Size >= 16; Size -= 16)
+		{
+			dw[0] = w; dw[1] = w; dw[2] = w; dw[3] = w;
+			dw += 4;
+		}
+		for (; Size >= 4; Size -= 4)
+			*dw++ = w;
+		d = (uint8_t *)dw;
+	}
+
+	while (Size--)
+		*d++ = (uint8_t)w;
+}
+
+/**		retval: difference of first differing bytes (as memcmp), 0 = equal
+			Same alignment - words until a difference, bytes resolve it.
+*/
+int MEM_FAST_Compare(const void *pData1, const void *pData2, uint32_t Size)
+{
+	const uint8_t *p1 = (const uint8_t *)pData1, *p2 = (const uint8_t *)pData2;
+
+	if (Size >= 8 && MEM_FAST_ALIGN(p1) == MEM_FAST_ALIGN(p2))
+	{
+		while (MEM_FAST_ALIGN(p1))
+		{
+			if (*p1 != *p2)
+				return *p1 - *p2;
+			p1++;
+			p2++;
+			Size--;
+		}
+		while (Size >= 4 && *(const uint32_t *)p1 == *(const uint32_t *)p2)
+		{
+			p1 += 4;
+			p2 += 4;
+			Size -= 4;
+		}
+	}
+
+	for (; Size != 0; Size--, p1++, p2++)
+	{
+		if (*p1 != *p2)
+			return *p1 - *p2;
+	}
+
+	return 0;
+}
+
+/*****************************END OF FILE************************************/
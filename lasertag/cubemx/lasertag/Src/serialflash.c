@@ -48,15 +48,15 @@
   */ 
 
 
-uint32_t SpixTimeout = EVAL_SPIx_TIMEOUT_MAX;        /*<! Value of Timeout when SPI communication fails */
-static SPI_HandleTypeDef heval_Spi;
+/* Flash on the shared SPI1 bus (spi_bus.c) */
+const SPI_BUS_DeviceTypeDef FLASH_SPI_Device =
+{
+  FLASH_SPI_CS_GPIO_PORT,
+  FLASH_SPI_CS_PIN,
+  SPI_BAUDRATEPRESCALER_4 | SPI_POLARITY_LOW | SPI_PHASE_1EDGE   /* 12 MHz, mode 0 */
+};
 
-/* SPIx bus function */
-static HAL_StatusTypeDef  SPIx_Init(void);
-static uint8_t            SPIx_Write(uint8_t Value);
-static uint8_t            SPIx_Read(void);
-static void               SPIx_Error (void);
-static void               SPIx_MspInit(SPI_HandleTypeDef *hspi);
+static uint8_t            FLASH_SPI_WritePage(uint32_t uwStartAddress, uint8_t* pData, uint32_t uwDataSize);
 
 /* Link function for EEPROM peripheral over SPI */
 HAL_StatusTypeDef         FLASH_SPI_IO_Init(void);
@@ -93,6 +93,10 @@ uint8_t BSP_SERIAL_FLASH_Init(void)
   */
 uint8_t BSP_SERIAL_FLASH_EraseSector(uint32_t SectorAddr)
 {
+  HAL_StatusTypeDef Status;
+  
+  SPI_BUS_Acquire(&FLASH_SPI_Device);
+  
   /*!< Sector Erase */
   /*!< Select the FLASH  and send "Write Enable" instruction */
   FLASH_SPI_IO_WriteEnable();
@@ -107,7 +111,10 @@ uint8_t BSP_SERIAL_FLASH_EraseSector(uint32_t SectorAddr)
   FLASH_SPI_IO_WriteByte(SectorAddr & 0xFF);
 
   /*!< Wait the end of Flash writing and Deselect the FLASH*/
-  if(FLASH_SPI_IO_WaitForWriteEnd()!= HAL_OK)
+  Status = FLASH_SPI_IO_WaitForWriteEnd();
+  SPI_BUS_Release();
+  
+  if(Status != HAL_OK)
   {
     return FLASH_ERROR;
   }
@@ -124,6 +131,10 @@ uint8_t BSP_SERIAL_FLASH_EraseSector(uint32_t SectorAddr)
   */
 uint8_t BSP_SERIAL_FLASH_EraseBulk(void)
 {
+  HAL_StatusTypeDef Status;
+  
+  SPI_BUS_Acquire(&FLASH_SPI_Device);
+  
   /*!< Bulk Erase */
   /*!< Select the FLASH  and send "Write Enable" instruction */
   FLASH_SPI_IO_WriteEnable();
@@ -132,7 +143,10 @@ uint8_t BSP_SERIAL_FLASH_EraseBulk(void)
   FLASH_SPI_IO_WriteByte(FLASH_SPI_CMD_BE);
 
   /*!< Wait the end of Flash writing and Deselect the FLASH*/
-  if(FLASH_SPI_IO_WaitForWriteEnd()!= HAL_OK)
+  Status = FLASH_SPI_IO_WaitForWriteEnd();
+  SPI_BUS_Release();
+  
+  if(Status != HAL_OK)
   {
     return FLASH_ERROR;
   }
@@ -155,6 +169,23 @@ uint8_t BSP_SERIAL_FLASH_EraseBulk(void)
   *         return FLASH_ERROR (0x01).
   */
 uint8_t BSP_SERIAL_FLASH_WritePage(uint32_t uwStartAddress, uint8_t* pData, uint32_t uwDataSize)
+{
+  uint8_t status;
+  
+  SPI_BUS_Acquire(&FLASH_SPI_Device);
+  status = FLASH_SPI_WritePage(uwStartAddress, pData, uwDataSize);
+  SPI_BUS_Release();
+  
+  return status;
+}
+
+/**
+  * @brief  Page WRITE sequence, bus already acquired
+  * @param  pData, uwStartAddress, uwDataSize: see BSP_SERIAL_FLASH_WritePage
+  * @retval FLASH_OK (0x00) if operation is correctly performed, else 
+  *         return FLASH_ERROR (0x01).
+  */
+static uint8_t FLASH_SPI_WritePage(uint32_t uwStartAddress, uint8_t* pData, uint32_t uwDataSize)
 {
   /*!< Select the FLASH  and send "Write Enable" instruction */
   FLASH_SPI_IO_WriteEnable();
@@ -168,14 +199,8 @@ uint8_t BSP_SERIAL_FLASH_WritePage(uint32_t uwStartAddress, uint8_t* pData, uint
   /*!< Send uwStartAddress low nibble address byte to write to */
   FLASH_SPI_IO_WriteByte(uwStartAddress & 0xFF);
 
-  /*!< while there is data to be written on the FLASH */
-  while (uwDataSize--)
-  {
-    /*!< Send the current byte */
-    FLASH_SPI_IO_WriteByte(*pData);
-    /*!< Point on the next byte to be written */
-    pData++;
-  }
+  /*!< Send the data bytes */
+  SPI_BUS_WriteBlock(pData, uwDataSize);
 
   /*!< Wait the end of Flash writing */
   if (FLASH_SPI_IO_WaitForWriteEnd()!= HAL_OK)
@@ -202,6 +227,9 @@ uint8_t BSP_SERIAL_FLASH_WriteData(uint32_t uwStartAddress, uint8_t* pData, uint
 {
   uint8_t NumOfPage = 0, NumOfSingle = 0, Addr = 0, count = 0, temp = 0, status = 0;
 
+  /* all pages in one bus transaction batch */
+  SPI_BUS_Acquire(&FLASH_SPI_Device);
+  
   Addr = uwStartAddress % FLASH_SPI_PAGESIZE;
   count = FLASH_SPI_PAGESIZE - Addr;
   NumOfPage =  uwDataSize / FLASH_SPI_PAGESIZE;
@@ -211,18 +239,18 @@ uint8_t BSP_SERIAL_FLASH_WriteData(uint32_t uwStartAddress, uint8_t* pData, uint
   {
     if (NumOfPage == 0) /*!< uwDataSize < FLASH_SPI_PAGESIZE */
     {
-      status = BSP_SERIAL_FLASH_WritePage(uwStartAddress, pData, uwDataSize);
+      status = FLASH_SPI_WritePage(uwStartAddress, pData, uwDataSize);
     }
     else /*!< uwDataSize > FLASH_SPI_PAGESIZE */
     {
       while (NumOfPage--)
       {
-        status = BSP_SERIAL_FLASH_WritePage(uwStartAddress, pData, FLASH_SPI_PAGESIZE);
+        status = FLASH_SPI_WritePage(uwStartAddress, pData, FLASH_SPI_PAGESIZE);
         uwStartAddress +=  FLASH_SPI_PAGESIZE;
         pData += FLASH_SPI_PAGESIZE;
       }
 
-      status = BSP_SERIAL_FLASH_WritePage(uwStartAddress, pData, NumOfSingle);
+      status = FLASH_SPI_WritePage(uwStartAddress, pData, NumOfSingle);
     }
   }
   else /*!< uwStartAddress is not FLASH_SPI_PAGESIZE aligned  */
@@ -233,15 +261,15 @@ uint8_t BSP_SERIAL_FLASH_WriteData(uint32_t uwStartAddress, uint8_t* pData, uint
       {
         temp = NumOfSingle - count;
 
-        status = BSP_SERIAL_FLASH_WritePage(uwStartAddress, pData, count);
+        status = FLASH_SPI_WritePage(uwStartAddress, pData, count);
         uwStartAddress +=  count;
         pData += count;
 
-        status = BSP_SERIAL_FLASH_WritePage(uwStartAddress, pData, temp);
+        status = FLASH_SPI_WritePage(uwStartAddress, pData, temp);
       }
       else
       {
-        status = BSP_SERIAL_FLASH_WritePage(uwStartAddress, pData, uwDataSize);
+        status = FLASH_SPI_WritePage(uwStartAddress, pData, uwDataSize);
       }
     }
     else /*!< uwDataSize > BSP_SERIAL_FLASH_PAGESIZE */
@@ -250,23 +278,25 @@ uint8_t BSP_SERIAL_FLASH_WriteData(uint32_t uwStartAddress, uint8_t* pData, uint
       NumOfPage =  uwDataSize / FLASH_SPI_PAGESIZE;
       NumOfSingle = uwDataSize % FLASH_SPI_PAGESIZE;
 
-      status = BSP_SERIAL_FLASH_WritePage(uwStartAddress, pData, count);
+      status = FLASH_SPI_WritePage(uwStartAddress, pData, count);
       uwStartAddress +=  count;
       pData += count;
 
       while (NumOfPage--)
       {
-        status = BSP_SERIAL_FLASH_WritePage(uwStartAddress, pData, FLASH_SPI_PAGESIZE);
+        status = FLASH_SPI_WritePage(uwStartAddress, pData, FLASH_SPI_PAGESIZE);
         uwStartAddress +=  FLASH_SPI_PAGESIZE;
         pData += FLASH_SPI_PAGESIZE;
       }
 
       if (NumOfSingle != 0)
       {
-        status = BSP_SERIAL_FLASH_WritePage(uwStartAddress, pData, NumOfSingle);
+        status = FLASH_SPI_WritePage(uwStartAddress, pData, NumOfSingle);
       }
     }
   }
+  SPI_BUS_Release();
+  
   if (status!= HAL_OK)
   {
     return FLASH_ERROR;
@@ -287,7 +317,13 @@ uint8_t BSP_SERIAL_FLASH_WriteData(uint32_t uwStartAddress, uint8_t* pData, uint
   */
 uint8_t BSP_SERIAL_FLASH_ReadData(uint32_t uwStartAddress, uint8_t* pData, uint32_t uwDataSize)
 {
-  if(FLASH_SPI_IO_ReadData(uwStartAddress, pData, uwDataSize)!= HAL_OK)
+  HAL_StatusTypeDef Status;
+  
+  SPI_BUS_Acquire(&FLASH_SPI_Device);
+  Status = FLASH_SPI_IO_ReadData(uwStartAddress, pData, uwDataSize);
+  SPI_BUS_Release();
+  
+  if(Status != HAL_OK)
   {
     return FLASH_ERROR;
   }
@@ -304,7 +340,13 @@ uint8_t BSP_SERIAL_FLASH_ReadData(uint32_t uwStartAddress, uint8_t* pData, uint3
   */
 uint32_t BSP_SERIAL_FLASH_ReadID(void)
 {
-  return(FLASH_SPI_IO_ReadID());
+  uint32_t Id;
+  
+  SPI_BUS_Acquire(&FLASH_SPI_Device);
+  Id = FLASH_SPI_IO_ReadID();
+  SPI_BUS_Release();
+  
+  return Id;
 }
 
 
@@ -317,27 +359,13 @@ uint32_t BSP_SERIAL_FLASH_ReadID(void)
   */
 HAL_StatusTypeDef FLASH_SPI_IO_Init(void)
 {
-  HAL_StatusTypeDef Status = HAL_OK;
-  
-  GPIO_InitTypeDef  gpioinitstruct = {0};
-
   /* EEPROM_CS_GPIO Periph clock enable */
   FLASH_SPI_CS_GPIO_CLK_ENABLE();
 
-  /* Configure EEPROM_CS_PIN pin: EEPROM SPI CS pin */
-  gpioinitstruct.Pin    = FLASH_SPI_CS_PIN;
-  gpioinitstruct.Mode   = GPIO_MODE_OUTPUT_PP;
-  gpioinitstruct.Pull   = GPIO_PULLUP;
-  gpioinitstruct.Speed  = GPIO_SPEED_FREQ_HIGH;
-  HAL_GPIO_Init(FLASH_SPI_CS_GPIO_PORT, &gpioinitstruct);
-
-  /* SPI FLASH Config */
-  Status = SPIx_Init();
+  /* CS pin, chip select high; SPI1 itself is set up by SPI_BUS_Init */
+  SPI_BUS_Register(&FLASH_SPI_Device);
   
-  /* EEPROM chip select high */
-  FLASH_SPI_CS_HIGH();
-  
-  return Status;
+  return HAL_OK;
 }
 
 /**
@@ -348,7 +376,7 @@ HAL_StatusTypeDef FLASH_SPI_IO_Init(void)
 uint8_t FLASH_SPI_IO_WriteByte(uint8_t Data)
 {
   /* Send the byte */
-  return (SPIx_Write(Data));
+  return (SPI_BUS_Transfer(Data));
 }
 
 /**
@@ -360,7 +388,7 @@ uint8_t FLASH_SPI_IO_ReadByte(void)
   uint8_t data = 0;
   
   /* Get the received data */
-  data = SPIx_Read();
+  data = SPI_BUS_Transfer(FLASH_SPI_DUMMY_BYTE);
 
   /* Return the shifted data */
   return data;
@@ -375,31 +403,28 @@ uint8_t FLASH_SPI_IO_ReadByte(void)
   */
 HAL_StatusTypeDef FLASH_SPI_IO_ReadData(uint32_t MemAddress, uint8_t* pBuffer, uint32_t BufferSize)
 {
+  HAL_StatusTypeDef Status;
+  
   /*!< Select the FLASH: Chip Select low */
   FLASH_SPI_CS_LOW();
 
   /*!< Send "Read from Memory " instruction */
-  SPIx_Write(FLASH_SPI_CMD_READ);
+  SPI_BUS_Transfer(FLASH_SPI_CMD_READ);
 
   /*!< Send ReadAddr high nibble address byte to read from */
-  SPIx_Write((MemAddress & 0xFF0000) >> 16);
+  SPI_BUS_Transfer((MemAddress & 0xFF0000) >> 16);
   /*!< Send ReadAddr medium nibble address byte to read from */
-  SPIx_Write((MemAddress& 0xFF00) >> 8);
+  SPI_BUS_Transfer((MemAddress& 0xFF00) >> 8);
   /*!< Send ReadAddr low nibble address byte to read from */
-  SPIx_Write(MemAddress & 0xFF);
+  SPI_BUS_Transfer(MemAddress & 0xFF);
 
-  while (BufferSize--) /*!< while there is data to be read */
-  {
-    /*!< Read a byte from the FLASH */
-    *pBuffer = SPIx_Write(FLASH_SPI_DUMMY_BYTE);
-    /*!< Point to the next location where the byte read will be saved */
-    pBuffer++;
-  }
+  /*!< Read the data bytes */
+  Status = SPI_BUS_ReadBlock(pBuffer, BufferSize, FLASH_SPI_DUMMY_BYTE);
 
   /*!< Deselect the FLASH: Chip Select high */
   FLASH_SPI_CS_HIGH();
 
-  return HAL_OK;
+  return Status;
 }
 
 /**
@@ -412,7 +437,7 @@ void FLASH_SPI_IO_WriteEnable(void)
   FLASH_SPI_CS_LOW();
   
   /*!< Send "Write Enable" instruction */
-  SPIx_Write(FLASH_SPI_CMD_WREN);
+  SPI_BUS_Transfer(FLASH_SPI_CMD_WREN);
   
   /*!< Select the FLASH: Chip Select low */
   FLASH_SPI_CS_HIGH();
@@ -436,14 +461,14 @@ HAL_StatusTypeDef FLASH_SPI_IO_WaitForWriteEnd(void)
   uint8_t flashstatus = 0;
 
   /*!< Send "Read Status Register" instruction */
-  SPIx_Write(FLASH_SPI_CMD_RDSR);
+  SPI_BUS_Transfer(FLASH_SPI_CMD_RDSR);
 
   /*!< Loop as long as the memory is busy with a write cycle */
   do
   {
     /*!< Send a dummy byte to generate the clock needed by the FLASH
     and put the value of the status register in FLASH_Status variable */
-    flashstatus = SPIx_Write(FLASH_SPI_DUMMY_BYTE);
+    flashstatus = SPI_BUS_Transfer(FLASH_SPI_DUMMY_BYTE);
 
   }
   while ((flashstatus & FLASH_SPI_WIP_FLAG) == SET); /* Write in progress */
@@ -466,16 +491,16 @@ uint32_t FLASH_SPI_IO_ReadID(void)
   FLASH_SPI_CS_LOW();
 
   /*!< Send "RDID " instruction */
-  SPIx_Write(0x9F);
+  SPI_BUS_Transfer(0x9F);
 
   /*!< Read a byte from the FLASH */
-  Temp0 = SPIx_Write(FLASH_SPI_DUMMY_BYTE);
+  Temp0 = SPI_BUS_Transfer(FLASH_SPI_DUMMY_BYTE);
 
   /*!< Read a byte from the FLASH */
-  Temp1 = SPIx_Write(FLASH_SPI_DUMMY_BYTE);
+  Temp1 = SPI_BUS_Transfer(FLASH_SPI_DUMMY_BYTE);
 
   /*!< Read a byte from the FLASH */
-  Temp2 = SPIx_Write(FLASH_SPI_DUMMY_BYTE);
+  Temp2 = SPI_BUS_Transfer(FLASH_SPI_DUMMY_BYTE);
 
   /*!< Deselect the FLASH: Chip Select high */
   FLASH_SPI_CS_HIGH();
@@ -485,117 +510,6 @@ uint32_t FLASH_SPI_IO_ReadID(void)
   return Temp;
 }
 
-/******************************* SPI Routines**********************************/
-/**
-  * @brief  Initializes SPI MSP.
-  * @retval None
-  */
-static void SPIx_MspInit(SPI_HandleTypeDef *hspi)
-{
-  GPIO_InitTypeDef  gpioinitstruct = {0};
-  
-  /*** Configure the GPIOs ***/  
-  /* Enable GPIO clock */
-  EVAL_SPIx_SCK_GPIO_CLK_ENABLE();
-  EVAL_SPIx_MISO_MOSI_GPIO_CLK_ENABLE();
-  
-  /* configure SPI SCK */
-  gpioinitstruct.Pin        = EVAL_SPIx_SCK_PIN;
-  gpioinitstruct.Mode       = GPIO_MODE_AF_PP;
-  gpioinitstruct.Pull       = GPIO_NOPULL;
-  gpioinitstruct.Speed      = GPIO_SPEED_FREQ_HIGH;
-  HAL_GPIO_Init(EVAL_SPIx_SCK_GPIO_PORT, &gpioinitstruct);
-
-  /* configure SPI MISO and MOSI */
-  gpioinitstruct.Pin        = (EVAL_SPIx_MISO_PIN | EVAL_SPIx_MOSI_PIN);
-  gpioinitstruct.Mode       = GPIO_MODE_AF_PP;
-  gpioinitstruct.Pull       = GPIO_NOPULL;
-  gpioinitstruct.Speed      = GPIO_SPEED_FREQ_HIGH;
-  HAL_GPIO_Init(EVAL_SPIx_MISO_MOSI_GPIO_PORT, &gpioinitstruct);
-
-  /*** Configure the SPI peripheral ***/ 
-  /* Enable SPI clock */
-  EVAL_SPIx_CLK_ENABLE();
-}
-
-/**
-  * @brief  Initializes SPI HAL.
-  * @retval None
-  */
-HAL_StatusTypeDef SPIx_Init(void)
-{
-  /* DeInitializes the SPI peripheral */
-  heval_Spi.Instance = EVAL_SPIx;
-  HAL_SPI_DeInit(&heval_Spi);
-
-  /* SPI Config */
-  /* SPI baudrate is set to 36 MHz (PCLK2/SPI_BaudRatePrescaler = 48/2 = 36 MHz) */
-  heval_Spi.Init.BaudRatePrescaler  = SPI_BAUDRATEPRESCALER_4;
-  heval_Spi.Init.Direction          = SPI_DIRECTION_2LINES;
-  heval_Spi.Init.CLKPhase           = SPI_PHASE_1EDGE;
-  heval_Spi.Init.CLKPolarity        = SPI_POLARITY_LOW;
-  heval_Spi.Init.CRCCalculation     = SPI_CRCCALCULATION_DISABLE;
-  heval_Spi.Init.CRCPolynomial      = 7;
-  heval_Spi.Init.DataSize           = SPI_DATASIZE_8BIT;
-  heval_Spi.Init.FirstBit           = SPI_FIRSTBIT_MSB;
-  heval_Spi.Init.NSS                = SPI_NSS_SOFT;
-  heval_Spi.Init.TIMode             = SPI_TIMODE_DISABLE;
-  heval_Spi.Init.Mode               = SPI_MODE_MASTER;
-  
-  SPIx_MspInit(&heval_Spi);
-  
-  return (HAL_SPI_Init(&heval_Spi));
-}
-
-
-/**
-  * @brief  SPI Write a byte to device
-  * @param  WriteValue to be written
-  * @retval The value of the received byte.
-  */
-static uint8_t SPIx_Write(uint8_t WriteValue)
-{
-  HAL_StatusTypeDef status = HAL_OK;
-  uint8_t ReadValue = 0;
-
-  status = HAL_SPI_TransmitReceive(&heval_Spi, (uint8_t*) &WriteValue, (uint8_t*) &ReadValue, 1, SpixTimeout);
-
-  /* Check the communication status */
-  if(status != HAL_OK)
-  {
-    /* Execute user timeout callback */
-    SPIx_Error();
-  }
-  
-   return ReadValue;
-}
-
-
-/**
-  * @brief SPI Read 1 byte from device
-  * @retval Read data
-*/
-static uint8_t SPIx_Read(void)
-{
-  return (SPIx_Write(FLASH_SPI_DUMMY_BYTE));
-}
-
-
-/**
-  * @brief SPI error treatment function
-  * @retval None
-  */
-static void SPIx_Error (void)
-{
-  /* De-initialize the SPI communication BUS */
-  HAL_SPI_DeInit(&heval_Spi);
-  
-  /* Re- Initiaize the SPI communication BUS */
-  SPIx_Init();
-}
-
-
-
 /**
   * @}
   */
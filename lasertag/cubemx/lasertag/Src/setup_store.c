@@ -0,0 +1,286 @@
+/**
+  ******************************************************************************
+  * File Name          : setup_store.c
+  * Description        : wear-leveled key/value store in the setup flash region
+  ******************************************************************************
+  * author: Tomas Krejci <info@tomaskrejci.com>
+  *
+  *
+  ******************************************************************************
+  */
+#include <string.h>
+#include "main.h"
+#include "setup_store.h"
+
+#define SETUP_STORE_MAGIC				0x564B544C //"LTKV"
+#define SETUP_STORE_HEAD_SIZE		8
+#define SETUP_STORE_REC_SIZE		4
+#define SETUP_STORE_KEY_FREE		0xFF
+
+// active sector 0/1
+static uint8_t SetupSector;
+// sector sequence, newer sector wins
+static uint16_t SetupSequence;
+// next free offset in active sector
+static uint16_t SetupWrite;
+// RAM index: key -> record offset in active sector, 0 = not stored
+static uint16_t SetupIndex[SETUP_STORE_KEYS];
+// one record buffer
+static uint8_t SetupBuffer[SETUP_STORE_REC_SIZE + SETUP_STORE_VALUE_MAX];
+
+
+static uint32_t SETUP_STORE_Address(uint8_t Sector)
+{
+	return LASERTAG_ADR_SETUP + (uint32_t)Sector * SETUP_STORE_SECTOR_SIZE;
+}
+
+/**		Read sector header
+			retval: TRUE valid header, *pSequence sector sequence
+*/
+static uint8_t SETUP_STORE_ReadHead(uint8_t Sector, uint16_t *pSequence)
+{
+	uint8_t Head[SETUP_STORE_HEAD_SIZE];
+	uint32_t Magic;
+	uint16_t Crc;
+
+	if (BSP_SERIAL_FLASH_ReadData(SETUP_STORE_Address(Sector), Head, SETUP_STORE_HEAD_SIZE) != FLASH_OK)
+		return FALSE;
+
+	Magic = Head[0] | ((uint32_t)Head[1] << 8) | ((uint32_t)Head[2] << 16) | ((uint32_t)Head[3] << 24);
+	Crc = Head[6] | ((uint16_t)Head[7] << 8);
+
+	if ((Magic != SETUP_STORE_MAGIC) || (CRC16_Calc(CRC16_INIT, Head, 6) != Crc))
+		return FALSE;
+
+	*pSequence = Head[4] | ((uint16_t)Head[5] << 8);
+	return TRUE;
+}
+
+/**		Write sector header, sector must be erased and filled with records
+*/
+static uint8_t SETUP_STORE_WriteHead(uint8_t Sector, uint16_t Sequence)
+{
+	uint8_t Head[SETUP_STORE_HEAD_SIZE];
+	uint16_t Crc;
+
+	Head[0] = (uint8_t)(SETUP_STORE_MAGIC);
+	Head[1] = (uint8_t)(SETUP_STORE_MAGIC >> 8);
+	Head[2] = (uint8_t)(SETUP_STORE_MAGIC >> 16);
+	Head[3] = (uint8_t)(SETUP_STORE_MAGIC >> 24);
+	Head[4] = (uint8_t)(Sequence);
+	Head[5] = (uint8_t)(Sequence >> 8);
+	Crc = CRC16_Calc(CRC16_INIT, Head, 6);
+	Head[6] = (uint8_t)(Crc);
+	Head[7] = (uint8_t)(Crc >> 8);
+
+	return BSP_SERIAL_FLASH_WritePage(SETUP_STORE_Address(Sector), Head, SETUP_STORE_HEAD_SIZE);
+}
+
+/**		Read record at offset into SetupBuffer
+			retval: record size (header + data), 0 = end of log, *pValid crc check
+*/
+static uint16_t SETUP_STORE_ReadRecord(uint8_t Sector, uint16_t Offset, uint8_t *pValid)
+{
+	uint8_t *pRec = SetupBuffer;
+	uint16_t Crc;
+
+	*pValid = FALSE;
+
+	if (Offset + SETUP_STORE_REC_SIZE > SETUP_STORE_SECTOR_SIZE)
+		return 0;
+	if (BSP_SERIAL_FLASH_ReadData(SETUP_STORE_Address(Sector) + Offset, pRec, SETUP_STORE_REC_SIZE) != FLASH_OK)
+		return 0;
+
+	// erased flash - end of log
+	if (pRec[0] == SETUP_STORE_KEY_FREE)
+		return 0;
+
+	if ((pRec[1] > SETUP_STORE_VALUE_MAX) ||
+			(Offset + SETUP_STORE_REC_SIZE + pRec[1] > SETUP_STORE_SECTOR_SIZE))
+	{
+		// torn record - skip rest of sector
+		return SETUP_STORE_SECTOR_SIZE - Offset;
+	}
+
+	if (BSP_SERIAL_FLASH_ReadData(SETUP_STORE_Address(Sector) + Offset + SETUP_STORE_REC_SIZE,
+																pRec + SETUP_STORE_REC_SIZE, pRec[1]) != FLASH_OK)
+		return 0;
+
+	Crc = CRC16_Calc(CRC16_INIT, pRec, 2);
+	Crc = CRC16_Calc(Crc, pRec + SETUP_STORE_REC_SIZE, pRec[1]);
+	if ((Crc == (pRec[2] | ((uint16_t)pRec[3] << 8))) && (pRec[0] < SETUP_STORE_KEYS))
+		*pValid = TRUE;
+
+	return SETUP_STORE_REC_SIZE + pRec[1];
+}
+
+/**		Format empty store into sector 0
+*/
+static uint8_t SETUP_STORE_Format(void)
+{
+	uint8_t i;
+
+	for (i = 0; i < SETUP_STORE_KEYS; i++)
+		SetupIndex[i] = 0;
+
+	SetupSector = 0;
+	SetupSequence = 1;
+	SetupWrite = SETUP_STORE_HEAD_SIZE;
+
+	if (BSP_SERIAL_FLASH_EraseSector(SETUP_STORE_Address(0)) != FLASH_OK)
+		return SETUP_STORE_ERROR;
+	if (BSP_SERIAL_FLASH_EraseSector(SETUP_STORE_Address(1)) != FLASH_OK)
+		return SETUP_STORE_ERROR;
+	if (SETUP_STORE_WriteHead(0, SetupSequence) != FLASH_OK)
+		return SETUP_STORE_ERROR;
+
+	return SETUP_STORE_OK;
+}
+
+/**		Find active sector and build RAM index from its log
+*/
+uint8_t SETUP_STORE_Init(void)
+{
+	uint16_t Seq0, Seq1, Size;
+	uint8_t Valid0, Valid1, Valid, i;
+
+	Valid0 = SETUP_STORE_ReadHead(0, &Seq0);
+	Valid1 = SETUP_STORE_ReadHead(1, &Seq1);
+
+	if (!Valid0 && !Valid1)
+		return SETUP_STORE_Format();
+
+	// both valid = compaction finished, old sector not erased yet -> newer wins
+	if (Valid0 && (!Valid1 || (int16_t)(Seq0 - Seq1) > 0))
+	{
+		SetupSector = 0;
+		SetupSequence = Seq0;
+	}
+	else
+	{
+		SetupSector = 1;
+		SetupSequence = Seq1;
+	}
+
+	for (i = 0; i < SETUP_STORE_KEYS; i++)
+		SetupIndex[i] = 0;
+
+	SetupWrite = SETUP_STORE_HEAD_SIZE;
+	while ((Size = SETUP_STORE_ReadRecord(SetupSector, SetupWrite, &Valid)) != 0)
+	{
+		if (Valid)
+			SetupIndex[SetupBuffer[0]] = SetupWrite;
+		SetupWrite += Size;
+	}
+
+	return SETUP_STORE_OK;
+}
+
+/**		Read newest value of key
+			param: pSize in - pData buffer size, out - value size
+*/
+uint8_t SETUP_STORE_Read(uint8_t Key, uint8_t *pData, uint8_t *pSize)
+{
+	uint8_t Valid, Size;
+
+	if ((Key >= SETUP_STORE_KEYS) || (SetupIndex[Key] == 0))
+		return SETUP_STORE_NOT_FOUND;
+
+	if (SETUP_STORE_ReadRecord(SetupSector, SetupIndex[Key], &Valid) == 0 || !Valid)
+		return SETUP_STORE_ERROR;
+
+	Size = SetupBuffer[1];
+	if (Size > *pSize)
+		Size = *pSize;
+	memcpy(pData, SetupBuffer + SETUP_STORE_REC_SIZE, Size);
+	*pSize = SetupBuffer[1];
+
+	return SETUP_STORE_OK;
+}
+
+/**		Append new value of key, costs one page program
+			(two if record crosses page boundary), no erase
+*/
+uint8_t SETUP_STORE_Write(uint8_t Key, const uint8_t *pData, uint8_t Size)
+{
+	uint8_t Valid;
+	uint16_t Crc;
+
+	if ((Key >= SETUP_STORE_KEYS) || (Size > SETUP_STORE_VALUE_MAX))
+		return SETUP_STORE_ERROR;
+
+	// same value already stored - save flash
+	if (SetupIndex[Key] != 0 &&
+			SETUP_STORE_ReadRecord(SetupSector, SetupIndex[Key], &Valid) != 0 && Valid &&
+			SetupBuffer[1] == Size && memcmp(SetupBuffer + SETUP_STORE_REC_SIZE, pData, Size) == 0)
+		return SETUP_STORE_OK;
+
+	if (SetupWrite + SETUP_STORE_REC_SIZE + Size > SETUP_STORE_SECTOR_SIZE)
+	{
+		if (SETUP_STORE_Compact() != SETUP_STORE_OK)
+			return SETUP_STORE_ERROR;
+		if (SetupWrite + SETUP_STORE_REC_SIZE + Size > SETUP_STORE_SECTOR_SIZE)
+			return SETUP_STORE_ERROR;
+	}
+
+	SetupBuffer[0] = Key;
+	SetupBuffer[1] = Size;
+	memcpy(SetupBuffer + SETUP_STORE_REC_SIZE, pData, Size);
+	Crc = CRC16_Calc(CRC16_INIT, SetupBuffer, 2);
+	Crc = CRC16_Calc(Crc, SetupBuffer + SETUP_STORE_REC_SIZE, Size);
+	SetupBuffer[2] = (uint8_t)(Crc);
+	SetupBuffer[3] = (uint8_t)(Crc >> 8);
+
+	if (BSP_SERIAL_FLASH_WriteData(SETUP_STORE_Address(SetupSector) + SetupWrite,
+																 SetupBuffer, SETUP_STORE_REC_SIZE + Size) != FLASH_OK)
+		return SETUP_STORE_ERROR;
+
+	SetupIndex[Key] = SetupWrite;
+	SetupWrite += SETUP_STORE_REC_SIZE + Size;
+
+	return SETUP_STORE_OK;
+}
+
+/**		Copy newest records into alternate sector and switch to it
+*/
+uint8_t SETUP_STORE_Compact(void)
+{
+	uint8_t Alternate = SetupSector ^ 1;
+	uint16_t Write = SETUP_STORE_HEAD_SIZE;
+	uint16_t Index[SETUP_STORE_KEYS];
+	uint16_t Size;
+	uint8_t Valid, i;
+
+	if (BSP_SERIAL_FLASH_EraseSector(SETUP_STORE_Address(Alternate)) != FLASH_OK)
+		return SETUP_STORE_ERROR;
+
+	for (i = 0; i < SETUP_STORE_KEYS; i++)
+	{
+		Index[i] = 0;
+		if (SetupIndex[i] == 0)
+			continue;
+
+		Size = SETUP_STORE_ReadRecord(SetupSector, SetupIndex[i], &Valid);
+		if (Size == 0 || !Valid)
+			continue;
+
+		if (BSP_SERIAL_FLASH_WriteData(SETUP_STORE_Address(Alternate) + Write, SetupBuffer, Size) != FLASH_OK)
+			return SETUP_STORE_ERROR;
+
+		Index[i] = Write;
+		Write += Size;
+	}
+
+	// header last - until now old sector stays active
+	if (SETUP_STORE_WriteHead(Alternate, SetupSequence + 1) != FLASH_OK)
+		return SETUP_STORE_ERROR;
+
+	SetupSector = Alternate;
+	SetupSequence++;
+	SetupWrite = Write;
+	memcpy(SetupIndex, Index, sizeof(SetupIndex));
+
+	return SETUP_STORE_OK;
+}
+
+/*****************************END OF FILE************************************/
@@ -0,0 +1,213 @@
+/**
+  ******************************************************************************
+  * File Name          : spi_bus.c
+  * Description        : SPI1 bus owner - arbitration, per device CS and clock
+  ******************************************************************************
+  * author: Tomas Krejci <info@tomaskrejci.com>
+  *
+  *
+  ******************************************************************************
+  */
+#include "FreeRTOS.h"
+#include "task.h"
+#include "semphr.h"
+#include "spi.h"
+#include "spi_bus.h"
+#include "lasertag_power.h"
+
+#define SPI_BUS_DMA_RX				DMA1_Channel2
+#define SPI_BUS_DMA_TX				DMA1_Channel3
+// CNDTR is 16 bit
+#define SPI_BUS_DMA_CHUNK			0x8000
+
+static SemaphoreHandle_t SpiBusMutex;
+static StaticSemaphore_t SpiBusMutexBuffer;
+// task waiting for RX channel transfer complete
+static TaskHandle_t volatile SpiBusTask;
+// transfer error on a channel of the running block
+static volatile uint8_t SpiBusError;
+// TX source of DMA read, not incremented
+static uint8_t SpiBusDummy;
+// device of last transaction, its CR1 config is loaded
+static const SPI_BUS_DeviceTypeDef *SpiBusDevice;
+
+
+/**		Take over hspi1 after MX_SPI1_Init, before any device is used
+*/
+void SPI_BUS_Init(void)
+{
+	SpiBusMutex = xSemaphoreCreateMutexStatic(&SpiBusMutexBuffer);
+	SpiBusDevice = NULL;
+	
+	// RXNE per byte, SPI stays enabled between transactions
+	SET_BIT(hspi1.Instance->CR2, SPI_RXFIFO_THRESHOLD);
+	__HAL_SPI_ENABLE(&hspi1);
+	
+	// byte transfers on DR, channels are set up per block
+	__HAL_RCC_DMA1_CLK_ENABLE();
+	SPI_BUS_DMA_RX->CPAR = (uint32_t)&SPI1->DR;
+	SPI_BUS_DMA_TX->CPAR = (uint32_t)&SPI1->DR;
+	HAL_NVIC_SetPriority(DMA1_Channel2_3_IRQn, 3, 0);
+	HAL_NVIC_EnableIRQ(DMA1_Channel2_3_IRQn);
+}
+
+/**		Configure device CS pin as output, inactive
+*/
+void SPI_BUS_Register(const SPI_BUS_DeviceTypeDef *pDevice)
+{
+	GPIO_InitTypeDef GPIO_InitStruct;
+	
+	SPI_BUS_Deselect(pDevice);
+	
+	GPIO_InitStruct.Pin = pDevice->CsPin;
+	GPIO_InitStruct.Mode = GPIO_MODE_OUTPUT_PP;
+	GPIO_InitStruct.Pull = GPIO_PULLUP;
+	GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_HIGH;
+	HAL_GPIO_Init(pDevice->CsPort, &GPIO_InitStruct);
+}
+
+/**		Wait for the bus, load device clock and mode if another device was last
+*/
+void SPI_BUS_Acquire(const SPI_BUS_DeviceTypeDef *pDevice)
+{
+	if (xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED)
+		xSemaphoreTake(SpiBusMutex, portMAX_DELAY);
+	
+	if (SpiBusDevice != pDevice)
+	{
+		// CR1 mode bits only with SPE off, last frame must be out
+		while (SPI1->SR & SPI_SR_BSY);
+		__HAL_SPI_DISABLE(&hspi1);
+		MODIFY_REG(SPI1->CR1, SPI_BUS_CONFIG_MASK, pDevice->Config);
+		__HAL_SPI_ENABLE(&hspi1);
+		
+		SpiBusDevice = pDevice;
+	}
+}
+
+void SPI_BUS_Release(void)
+{
+	if (xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED)
+		xSemaphoreGive(SpiBusMutex);
+}
+
+/**		Write block, received bytes dropped
+			Next byte is queued in TX FIFO while current one is shifted,
+			SCK runs without gaps between bytes.
+*/
+void SPI_BUS_WriteBlock(const uint8_t *pData, uint32_t Size)
+{
+	if (Size == 0)
+		return;
+	
+	*(__IO uint8_t *)&SPI1->DR = *pData++;
+	while (--Size)
+	{
+		*(__IO uint8_t *)&SPI1->DR = *pData++;
+		while ((SPI1->SR & SPI_SR_RXNE) == 0);
+		(void)*(__IO uint8_t *)&SPI1->DR;
+	}
+	while ((SPI1->SR & SPI_SR_RXNE) == 0);
+	(void)*(__IO uint8_t *)&SPI1->DR;
+}
+
+/**		One DMA block, RX enabled before TX (RM0091 SPI DMA sequence),
+			RX FIFO is empty - byte routines always drain it
+			retval: HAL_ERROR DMA transfer error, data incomplete
+*/
+static HAL_StatusTypeDef SPI_BUS_ReadDMA(uint8_t *pData, uint16_t Size)
+{
+	SpiBusTask = xTaskGetCurrentTaskHandle();
+	SpiBusError = FALSE;
+	
+	// no STOP while the block is on the bus, released by SPI_BUS_DMA_IRQHandler
+	LASERTAG_POWER_Hold(LASERTAG_POWER_HOLD_SPI);
+	
+	SPI_BUS_DMA_RX->CMAR = (uint32_t)pData;
+	SPI_BUS_DMA_RX->CNDTR = Size;
+	SPI_BUS_DMA_RX->CCR = DMA_CCR_MINC | DMA_CCR_TCIE | DMA_CCR_TEIE | DMA_CCR_PL_1 | DMA_CCR_EN;
+	SET_BIT(SPI1->CR2, SPI_CR2_RXDMAEN);
+	
+	SPI_BUS_DMA_TX->CMAR = (uint32_t)&SpiBusDummy;
+	SPI_BUS_DMA_TX->CNDTR = Size;
+	SPI_BUS_DMA_TX->CCR = DMA_CCR_DIR | DMA_CCR_TEIE | DMA_CCR_PL_1 | DMA_CCR_EN;
+	SET_BIT(SPI1->CR2, SPI_CR2_TXDMAEN);
+	
+	NOTIFY_Wait(SPI_BUS_NOTIFY, portMAX_DELAY);
+	
+	SPI_BUS_DMA_TX->CCR = 0;
+	SPI_BUS_DMA_RX->CCR = 0;
+	CLEAR_BIT(SPI1->CR2, SPI_CR2_RXDMAEN | SPI_CR2_TXDMAEN);
+	
+	if (!SpiBusError)
+		return HAL_OK;
+	
+	// bytes left of the broken block must not reach the next transfer
+	while (SPI1->SR & SPI_SR_BSY);
+	while (SPI1->SR & SPI_SR_RXNE)
+		(void)*(__IO uint8_t *)&SPI1->DR;
+	
+	return HAL_ERROR;
+}
+
+/**		RX channel done or either channel failed, channels are stopped by
+			the waiting task
+*/
+void SPI_BUS_DMA_IRQHandler(void)
+{
+	BaseType_t Woken = pdFALSE;
+	uint32_t Isr = DMA1->ISR;
+	
+	if (Isr & (DMA_ISR_TCIF2 | DMA_ISR_TEIF2 | DMA_ISR_TEIF3))
+	{
+		if (Isr & (DMA_ISR_TEIF2 | DMA_ISR_TEIF3))
+			SpiBusError = TRUE;
+		
+		DMA1->IFCR = DMA_IFCR_CGIF2 | DMA_IFCR_CGIF3;
+		SPI_BUS_DMA_RX->CCR &= ~(DMA_CCR_TCIE | DMA_CCR_TEIE);
+		SPI_BUS_DMA_TX->CCR &= ~DMA_CCR_TEIE;
+		LASERTAG_POWER_Release(LASERTAG_POWER_HOLD_SPI);
+		xTaskNotifyFromISR(SpiBusTask, SPI_BUS_NOTIFY, eSetBits, &Woken);
+	}
+	DMA1->IFCR = DMA_IFCR_CGIF3;
+	
+	portYIELD_FROM_ISR(Woken);
+}
+
+/**		Read block, Dummy byte sent for each byte
+			Large block on DMA, otherwise one byte ahead in TX FIFO.
+			retval: HAL_ERROR DMA transfer error
+*/
+HAL_StatusTypeDef SPI_BUS_ReadBlock(uint8_t *pData, uint32_t Size, uint8_t Dummy)
+{
+	uint32_t Part;
+	
+	if (Size >= SPI_BUS_DMA_MIN && xTaskGetSchedulerState() != taskSCHEDULER_NOT_STARTED)
+	{
+		SpiBusDummy = Dummy;
+		for (; Size != 0; Size -= Part, pData += Part)
+		{
+			Part = (Size < SPI_BUS_DMA_CHUNK) ? Size : SPI_BUS_DMA_CHUNK;
+			if (SPI_BUS_ReadDMA(pData, (uint16_t)Part) != HAL_OK)
+				return HAL_ERROR;
+		}
+		return HAL_OK;
+	}
+	
+	if (Size == 0)
+		return HAL_OK;
+	
+	*(__IO uint8_t *)&SPI1->DR = Dummy;
+	while (--Size)
+	{
+		*(__IO uint8_t *)&SPI1->DR = Dummy;
+		while ((SPI1->SR & SPI_SR_RXNE) == 0);
+		*pData++ = *(__IO uint8_t *)&SPI1->DR;
+	}
+	while ((SPI1->SR & SPI_SR_RXNE) == 0);
+	*pData = *(__IO uint8_t *)&SPI1->DR;
+	
+	return HAL_OK;
+}
+
+/*****************************END OF FILE************************************/
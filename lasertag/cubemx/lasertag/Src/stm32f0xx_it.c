@@ -38,6 +38,11 @@
 
 /* USER CODE BEGIN 0 */
 #include "main.h"
+#include "lasertag_ir.h"
+#include "lasertag_audio.h"
+#include "lasertag_power.h"
+#include "lasertag_trace.h"
+#include "spi_bus.h"
 
 /* USER CODE END 0 */
 
@@ -59,10 +64,13 @@ extern TIM_HandleTypeDef htim6;
 void SysTick_Handler(void)
 {
   /* USER CODE BEGIN SysTick_IRQn 0 */
+  LASERTAG_TRACE_ENTER(LASERTAG_TRACE_TICK, SysTick_IRQn);
 
   /* USER CODE END SysTick_IRQn 0 */
   osSystickHandler();
   /* USER CODE BEGIN SysTick_IRQn 1 */
+  LASERTAG_IR_Tick();
+  LASERTAG_TRACE_EXIT(LASERTAG_TRACE_TICK, SysTick_IRQn);
 
   /* USER CODE END SysTick_IRQn 1 */
 }
@@ -80,11 +88,13 @@ void SysTick_Handler(void)
 void DMA1_Channel4_5_IRQHandler(void)
 {
   /* USER CODE BEGIN DMA1_Channel4_5_IRQn 0 */
+  LASERTAG_TRACE_ENTER(LASERTAG_TRACE_ISR, DMA1_Channel4_5_IRQn);
 
   /* USER CODE END DMA1_Channel4_5_IRQn 0 */
   HAL_DMA_IRQHandler(&hdma_usart1_tx);
   HAL_DMA_IRQHandler(&hdma_usart1_rx);
   /* USER CODE BEGIN DMA1_Channel4_5_IRQn 1 */
+  LASERTAG_TRACE_EXIT(LASERTAG_TRACE_ISR, DMA1_Channel4_5_IRQn);
 
   /* USER CODE END DMA1_Channel4_5_IRQn 1 */
 }
@@ -95,10 +105,12 @@ void DMA1_Channel4_5_IRQHandler(void)
 void TIM6_DAC_IRQHandler(void)
 {
   /* USER CODE BEGIN TIM6_DAC_IRQn 0 */
+  LASERTAG_TRACE_ENTER(LASERTAG_TRACE_TICK, TIM6_DAC_IRQn);
 
   /* USER CODE END TIM6_DAC_IRQn 0 */
   HAL_TIM_IRQHandler(&htim6);
   /* USER CODE BEGIN TIM6_DAC_IRQn 1 */
+  LASERTAG_TRACE_EXIT(LASERTAG_TRACE_TICK, TIM6_DAC_IRQn);
 
   /* USER CODE END TIM6_DAC_IRQn 1 */
 }
@@ -109,10 +121,12 @@ void TIM6_DAC_IRQHandler(void)
 void SPI1_IRQHandler(void)
 {
   /* USER CODE BEGIN SPI1_IRQn 0 */
+  LASERTAG_TRACE_ENTER(LASERTAG_TRACE_ISR, SPI1_IRQn);
 
   /* USER CODE END SPI1_IRQn 0 */
   HAL_SPI_IRQHandler(&hspi1);
   /* USER CODE BEGIN SPI1_IRQn 1 */
+  LASERTAG_TRACE_EXIT(LASERTAG_TRACE_ISR, SPI1_IRQn);
   
   /* USER CODE END SPI1_IRQn 1 */
 }
@@ -123,15 +137,76 @@ void SPI1_IRQHandler(void)
 void USART1_IRQHandler(void)
 {
   /* USER CODE BEGIN USART1_IRQn 0 */
+  LASERTAG_TRACE_ENTER(LASERTAG_TRACE_ISR, USART1_IRQn);
+  // wake-up flag handled here - HAL_UART_IRQHandler would reset the DMA state
+  if (USART1->ISR & USART_ISR_WUF)
+  {
+    USART1->ICR = USART_ICR_WUCF;
+    LASERTAG_POWER_LinkWakeupCallback();
+  }
 
   /* USER CODE END USART1_IRQn 0 */
   HAL_UART_IRQHandler(&huart1);
   /* USER CODE BEGIN USART1_IRQn 1 */
+  LASERTAG_TRACE_EXIT(LASERTAG_TRACE_ISR, USART1_IRQn);
 
   /* USER CODE END USART1_IRQn 1 */
 }
 
 /* USER CODE BEGIN 1 */
+/**
+* @brief This function handles RTC interrupt through EXTI line 17 (STOP wake-up alarm).
+*/
+void RTC_IRQHandler(void)
+{
+  LASERTAG_TRACE_ENTER(LASERTAG_TRACE_ISR, RTC_IRQn);
+  LASERTAG_POWER_AlarmCallback();
+  LASERTAG_TRACE_EXIT(LASERTAG_TRACE_ISR, RTC_IRQn);
+}
+
+/**
+* @brief This function handles EXTI line 0 and 1 interrupts.
+*/
+void EXTI0_1_IRQHandler(void)
+{
+  LASERTAG_TRACE_ENTER(LASERTAG_TRACE_ISR, EXTI0_1_IRQn);
+  HAL_GPIO_EXTI_IRQHandler(IR_RX_Pin);
+  HAL_GPIO_EXTI_IRQHandler(B1_Pin);
+  LASERTAG_TRACE_EXIT(LASERTAG_TRACE_ISR, EXTI0_1_IRQn);
+}
+
+/**
+* @brief This function handles TIM15 global interrupt (audio sample clock).
+*/
+void TIM15_IRQHandler(void)
+{
+  // no HAL_TIM_IRQHandler - HAL_TIM_PeriodElapsedCallback is the TIM6 time base
+  LASERTAG_TRACE_ENTER(LASERTAG_TRACE_AUDIO, TIM15_IRQn);
+  TIM15->SR = ~TIM_SR_UIF;
+  LASERTAG_AUDIO_SampleCallback();
+  LASERTAG_TRACE_EXIT(LASERTAG_TRACE_AUDIO, TIM15_IRQn);
+}
+
+/**
+* @brief This function handles TIM16 global interrupt (IR envelope).
+*/
+void TIM16_IRQHandler(void)
+{
+  LASERTAG_TRACE_ENTER(LASERTAG_TRACE_ISR, TIM16_IRQn);
+  TIM16->SR = ~TIM_SR_UIF;
+  LASERTAG_IR_TxTimerCallback();
+  LASERTAG_TRACE_EXIT(LASERTAG_TRACE_ISR, TIM16_IRQn);
+}
+
+/**
+* @brief This function handles DMA1 channel 2 and 3 interrupts (SPI1 block read).
+*/
+void DMA1_Channel2_3_IRQHandler(void)
+{
+  LASERTAG_TRACE_ENTER(LASERTAG_TRACE_ISR, DMA1_Channel2_3_IRQn);
+  SPI_BUS_DMA_IRQHandler();
+  LASERTAG_TRACE_EXIT(LASERTAG_TRACE_ISR, DMA1_Channel2_3_IRQn);
+}
 
 /* USER CODE END 1 */
 /************************ (C) COPYRIGHT STMicroelectronics *****END OF FILE****/
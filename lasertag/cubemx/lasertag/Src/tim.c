@@ -36,6 +36,9 @@
 #include "tim.h"
 
 /* USER CODE BEGIN 0 */
+// TIM2 cycle counter, TIM15 audio sample tick - not in lasertag.ioc
+TIM_HandleTypeDef htim2;
+TIM_HandleTypeDef htim15;
 
 /* USER CODE END 0 */
 
@@ -124,7 +127,9 @@ void HAL_TIM_Base_MspInit(TIM_HandleTypeDef* htim_base)
     /* Peripheral clock enable */
     __HAL_RCC_TIM16_CLK_ENABLE();
   /* USER CODE BEGIN TIM16_MspInit 1 */
-
+    // IR TX envelope (lasertag_ir.c)
+    HAL_NVIC_SetPriority(TIM16_IRQn, 3, 0);
+    HAL_NVIC_EnableIRQ(TIM16_IRQn);
   /* USER CODE END TIM16_MspInit 1 */
   }
   else if(htim_base->Instance==TIM17)
@@ -151,7 +156,7 @@ void HAL_TIM_Base_MspDeInit(TIM_HandleTypeDef* htim_base)
     /* Peripheral clock disable */
     __HAL_RCC_TIM16_CLK_DISABLE();
   /* USER CODE BEGIN TIM16_MspDeInit 1 */
-
+    HAL_NVIC_DisableIRQ(TIM16_IRQn);
   /* USER CODE END TIM16_MspDeInit 1 */
   }
   else if(htim_base->Instance==TIM17)
@@ -168,6 +173,60 @@ void HAL_TIM_Base_MspDeInit(TIM_HandleTypeDef* htim_base)
 } 
 
 /* USER CODE BEGIN 1 */
+/* TIM2 init function
+   free running at SystemCoreClock, cycle time stamps (CYCLE_COUNTER) */
+void MX_TIM2_Init(void)
+{
+  TIM_ClockConfigTypeDef sClockSourceConfig;
+  TIM_MasterConfigTypeDef sMasterConfig;
+
+  // no MspInit branch for TIM2, clock enabled here
+  __HAL_RCC_TIM2_CLK_ENABLE();
+
+  htim2.Instance = TIM2;
+  htim2.Init.Prescaler = 0;
+  htim2.Init.CounterMode = TIM_COUNTERMODE_UP;
+  htim2.Init.Period = 0xFFFFFFFF;
+  htim2.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+  HAL_TIM_Base_Init(&htim2);
+
+  sClockSourceConfig.ClockSource = TIM_CLOCKSOURCE_INTERNAL;
+  HAL_TIM_ConfigClockSource(&htim2, &sClockSourceConfig);
+
+  sMasterConfig.MasterOutputTrigger = TIM_TRGO_RESET;
+  sMasterConfig.MasterSlaveMode = TIM_MASTERSLAVEMODE_DISABLE;
+  HAL_TIMEx_MasterConfigSynchronization(&htim2, &sMasterConfig);
+
+}
+
+/* TIM15 init function
+   8 kHz audio sample tick (lasertag_audio.c) */
+void MX_TIM15_Init(void)
+{
+  TIM_ClockConfigTypeDef sClockSourceConfig;
+  TIM_MasterConfigTypeDef sMasterConfig;
+
+  // no MspInit branch for TIM15, clock and interrupt enabled here
+  __HAL_RCC_TIM15_CLK_ENABLE();
+  HAL_NVIC_SetPriority(TIM15_IRQn, 3, 0);
+  HAL_NVIC_EnableIRQ(TIM15_IRQn);
+
+  htim15.Instance = TIM15;
+  htim15.Init.Prescaler = 0;
+  htim15.Init.CounterMode = TIM_COUNTERMODE_UP;
+  htim15.Init.Period = 5999;
+  htim15.Init.ClockDivision = TIM_CLOCKDIVISION_DIV1;
+  htim15.Init.RepetitionCounter = 0;
+  HAL_TIM_Base_Init(&htim15);
+
+  sClockSourceConfig.ClockSource = TIM_CLOCKSOURCE_INTERNAL;
+  HAL_TIM_ConfigClockSource(&htim15, &sClockSourceConfig);
+
+  sMasterConfig.MasterOutputTrigger = TIM_TRGO_RESET;
+  sMasterConfig.MasterSlaveMode = TIM_MASTERSLAVEMODE_DISABLE;
+  HAL_TIMEx_MasterConfigSynchronization(&htim15, &sMasterConfig);
+
+}
 
 /* USER CODE END 1 */
 
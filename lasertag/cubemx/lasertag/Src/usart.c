@@ -77,6 +77,9 @@ void HAL_UART_MspInit(UART_HandleTypeDef* huart)
   if(huart->Instance==USART1)
   {
   /* USER CODE BEGIN USART1_MspInit 0 */
+    // HSI kernel clock keeps USART1 receiving in STOP (lasertag_power.c),
+    // set before HAL_UART_Init computes BRR
+    __HAL_RCC_USART1_CONFIG(RCC_USART1CLKSOURCE_HSI);
 
   /* USER CODE END USART1_MspInit 0 */
     /* Peripheral clock enable */
@@ -176,13 +179,7 @@ void HAL_UART_MspDeInit(UART_HandleTypeDef* huart)
   */
 void HAL_UART_RxCpltCallback(UART_HandleTypeDef *UartHandle)
 {
-  HAL_GPIO_TogglePin(LD3_GPIO_Port, LD3_Pin); //green
-	
-	if (HAL_UART_Transmit_DMA(&huart1, (uint8_t *)"OK \n\r", 5) == HAL_ERROR)
-  {
-    /* Transfer error in reception process */
-    Error_Handler();
-  }
+	LASERTAG_BOARD_RxCpltCallback();
 	
 	
 	
@@ -205,7 +202,7 @@ void HAL_UART_RxCpltCallback(UART_HandleTypeDef *UartHandle)
   */
 void HAL_UART_TxCpltCallback(UART_HandleTypeDef *UartHandle)
 {
-  
+  LASERTAG_BOARD_TxCpltCallback();
 	
 	
 	/* Set transmission flag: trasfer complete*/
@@ -0,0 +1,189 @@
+/**
+  ******************************************************************************
+  * File Name          : setuptool.c
+  * Description        : game configuration image <-> pc link packets
+  ******************************************************************************
+  * author: Tomas Krejci <info@tomaskrejci.com>
+  *
+  *	usage: setuptool dump <answer.bin>
+  *	       setuptool set <field>[.<index>] <value> ... > packets.bin
+  *	answer.bin  = answer page of <CMD_READ_DATA> <TAR_SETUP> <x> <LASERTAG_SETUP_KEY>
+  *	packets.bin = one <CMD_WRITE_DATA> <TAR_SETUP> page per field, send as is
+  *	build:  cc -I../cubemx/lasertag/Inc -o setuptool setuptool.c
+  *
+  *	Field layout comes from lasertag_setup.h only - rebuild after schema change.
+  ******************************************************************************
+  */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#define LASERTAG_SETUP_PC
+#include "lasertag_setup.h"
+
+// pc link protocol, see lasertag_board.h (not includable on pc)
+#define		PAGE_SIZE							512
+#define		CMD_WRITE_DATA				0x01
+#define		TAR_SETUP							0x11
+#define		STATUS_OK							0x00
+
+typedef struct
+{
+	const char	*Name;
+	uint8_t			Offset;
+	uint8_t			Size;				/* element size */
+	uint8_t			Count;			/* elements, 1 = scalar */
+} FieldTypeDef;
+
+#define		FIELD(f)	{ #f, offsetof(LASERTAG_SetupTypeDef, f), \
+										sizeof(((LASERTAG_SetupTypeDef *)0)->f[0]), \
+										sizeof(((LASERTAG_SetupTypeDef *)0)->f) / sizeof(((LASERTAG_SetupTypeDef *)0)->f[0]) }
+#define		SCALAR(f)	{ #f, offsetof(LASERTAG_SetupTypeDef, f), \
+										sizeof(((LASERTAG_SetupTypeDef *)0)->f), 1 }
+
+// writable fields only - header and Crc are refused by the firmware
+static const FieldTypeDef Field[] =
+{
+	SCALAR(Team),
+	SCALAR(Player),
+	SCALAR(Health),
+	SCALAR(Lives),
+	SCALAR(Ammo),
+	SCALAR(RespawnTime),
+	SCALAR(GameTime),
+	SCALAR(FriendlyFire),
+	SCALAR(Damage),
+	FIELD(DamageTable),
+	SCALAR(IrProtocol),
+	SCALAR(IrPower),
+	SCALAR(IrCarrier),
+	SCALAR(Volume),
+	FIELD(SoundMap),
+};
+
+#define		FIELD_CNT		(sizeof(Field) / sizeof(Field[0]))
+
+static uint16_t Crc16(const uint8_t *pData, uint32_t Size)
+{
+	uint16_t Crc = 0xFFFF;
+	uint8_t i;
+
+	while (Size--)
+	{
+		Crc ^= (uint16_t)*pData++ << 8;
+		for (i = 0; i < 8; i++)
+			Crc = (Crc & 0x8000) ? (uint16_t)((Crc << 1) ^ 0x1021) : (uint16_t)(Crc << 1);
+	}
+	return Crc;
+}
+
+static uint32_t Get(const uint8_t *p, uint8_t Size)
+{
+	return (Size == 2) ? (uint32_t)(p[0] | (p[1] << 8)) : p[0];
+}
+
+static int Dump(const char *pPath)
+{
+	uint8_t Page[PAGE_SIZE];
+	const uint8_t *pImage = &Page[5];
+	uint16_t Crc;
+	uint32_t i, j;
+	FILE *f;
+
+	f = fopen(pPath, "rb");
+	if (f == NULL || fread(Page, 1, sizeof(Page), f) < 5 + offsetof(LASERTAG_SetupTypeDef, Team))
+	{
+		fprintf(stderr, "cannot read %s\n", pPath);
+		return 1;
+	}
+	fclose(f);
+
+	if (Page[1] != TAR_SETUP || Page[2] != STATUS_OK || Page[3] != LASERTAG_SETUP_KEY)
+	{
+		fprintf(stderr, "not a setup image answer\n");
+		return 1;
+	}
+	if (Get(pImage, 2) != LASERTAG_SETUP_MAGIC || pImage[3] != Page[4] || Page[4] < 2)
+	{
+		fprintf(stderr, "bad image header\n");
+		return 1;
+	}
+	Crc = (uint16_t)Get(&pImage[Page[4] - 2], 2);
+	printf("Version %u Size %u Crc %04X %s\n", pImage[2], Page[4], Crc,
+		(Crc == Crc16(pImage, Page[4] - 2)) ? "ok" : "BAD");
+	if (pImage[2] != LASERTAG_SETUP_VERSION)
+		printf("schema version %u, fields past the image are not shown\n", LASERTAG_SETUP_VERSION);
+
+	for (i = 0; i < FIELD_CNT; i++)
+	{
+		if (Field[i].Offset + Field[i].Size * Field[i].Count > Page[4] - 2)
+			continue;
+		printf("%-14s", Field[i].Name);
+		for (j = 0; j < Field[i].Count; j++)
+			printf(" %u", Get(&pImage[Field[i].Offset + j * Field[i].Size], Field[i].Size));
+		printf("\n");
+	}
+	return 0;
+}
+
+static int Set(int Argc, char **Argv)
+{
+	uint8_t Page[PAGE_SIZE];
+	char Name[32];
+	const char *pDot;
+	unsigned long Index, Value;
+	uint32_t i;
+	uint8_t Offset;
+
+	if (Argc == 0 || (Argc & 1))
+	{
+		fprintf(stderr, "set needs <field>[.<index>] <value> pairs\n");
+		return 1;
+	}
+	for (; Argc > 0; Argc -= 2, Argv += 2)
+	{
+		pDot = strchr(Argv[0], '.');
+		Index = pDot ? strtoul(pDot + 1, NULL, 0) : 0;
+		snprintf(Name, sizeof(Name), "%.*s", pDot ? (int)(pDot - Argv[0]) : (int)strlen(Argv[0]), Argv[0]);
+		Value = strtoul(Argv[1], NULL, 0);
+
+		for (i = 0; i < FIELD_CNT && strcmp(Name, Field[i].Name) != 0; i++);
+		if (i == FIELD_CNT || Index >= Field[i].Count || (pDot == NULL && Field[i].Count > 1))
+		{
+			fprintf(stderr, "unknown field %s\n", Argv[0]);
+			return 1;
+		}
+		if (Value >> (8 * Field[i].Size))
+		{
+			fprintf(stderr, "%s: value %lu out of range\n", Argv[0], Value);
+			return 1;
+		}
+
+		Offset = (uint8_t)(Field[i].Offset + Index * Field[i].Size);
+		memset(Page, 0, sizeof(Page));
+		Page[0] = CMD_WRITE_DATA;
+		Page[1] = TAR_SETUP;
+		Page[3] = Offset;
+		Page[4] = Field[i].Size;
+		Page[5] = (uint8_t)Value;
+		Page[6] = (uint8_t)(Value >> 8);
+		fwrite(Page, 1, sizeof(Page), stdout);
+	}
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	if (argc == 3 && strcmp(argv[1], "dump") == 0)
+		return Dump(argv[2]);
+	if (argc >= 2 && strcmp(argv[1], "set") == 0)
+		return Set(argc - 2, &argv[2]);
+
+	fprintf(stderr, "usage: setuptool dump <answer.bin>\n"
+		"       setuptool set <field>[.<index>] <value> ... > packets.bin\n");
+	return 1;
+}
+
+/*****************************END OF FILE************************************/
@@ -0,0 +1,97 @@
+/**
+  ******************************************************************************
+  * File Name          : cycles.c
+  * Description        : host test harness - firmware benchmarks on the cycle stand-in
+  ******************************************************************************
+  * author: Tomas Krejci <info@tomaskrejci.com>
+  *
+  *	usage: cycles [iterations]
+  *	Runs every benchmark of lasertag_bench.c (the BENCH pc link target) as
+  *	the firmware does, default 100 iterations. CYCLE_COUNTER is the estimate
+  *	of host_os.c, flash and SPI time come from the S25FL164K model, the FatFs
+  *	benches run on a freshly formatted log volume.
+  *
+  *	One line per benchmark: estimated M0 cycles min/avg/max without the call
+  *	overhead, as on the pc link, and the longest interrupt masked span inside
+  *	it ("-" = none). Exit code 1 when the volume cannot be set up.
+  ******************************************************************************
+  */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ff.h"
+#include "serialflash.h"
+#include "spi_bus.h"
+#include "lasertag_setup.h"
+#include "lasertag_bench.h"
+#include "host.h"
+
+// SPI1 at SystemCoreClock / 4, one byte
+#define		SPI_BYTE_CYCLES		32
+
+
+// audio decode scales by the volume
+LASERTAG_SetupTypeDef LASERTAG_Setup = { .Volume = 200 };
+
+/*---------------------------------------------------------------------------*/
+/* SPI bus stand-ins, spi byte bench                                         */
+/*---------------------------------------------------------------------------*/
+
+const SPI_BUS_DeviceTypeDef FLASH_SPI_Device;
+
+void SPI_BUS_Acquire(const SPI_BUS_DeviceTypeDef *pDevice)
+{
+}
+
+void SPI_BUS_Release(void)
+{
+}
+
+uint8_t FLASH_SPI_IO_ReadByte(void)
+{
+	TEST_CYCLE_Wait(SPI_BYTE_CYCLES);
+	return 0xFF;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static uint32_t Get32(const uint8_t *p)
+{
+	return p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+int main(int argc, char **argv)
+{
+	static FATFS Fs;
+	uint8_t Data[16 + LASERTAG_BENCH_NAME_LEN + 1];
+	uint16_t Iterations = (argc > 1) ? (uint16_t)strtoul(argv[1], NULL, 0) : 100;
+	uint8_t i;
+
+	TEST_DISK_Init(TEST_DISK_FLASH);
+	if (f_mount(&Fs, TEST_DISK_Path, 0) != FR_OK || f_mkfs(TEST_DISK_Path, 1, 0) != FR_OK
+		|| f_mount(&Fs, TEST_DISK_Path, 1) != FR_OK)
+	{
+		fprintf(stderr, "cycles: no log volume\n");
+		return 1;
+	}
+
+	TEST_CYCLE_Calibrate();
+	printf("%s, estimated M0 cycles, %.3f per host tick\n", TEST_CONFIG, TEST_CYCLE_Scale());
+	printf("%-16s %5s %9s %9s %9s %7s\n", "bench", "iter", "min", "avg", "max", "masked");
+	for (i = 0; i < LASERTAG_BENCH_Count(); i++)
+	{
+		// pc link answer, layout in lasertag_bench.h
+		TEST_CYCLE_Masked = 0;
+		memset(Data, 0, sizeof(Data));
+		LASERTAG_BENCH_Read(i, Iterations, Data);
+		printf("%-16s %5u %9u %9u %9u", (const char *)&Data[16], Data[2] | Data[3] << 8,
+			Get32(&Data[4]), Get32(&Data[8]), Get32(&Data[12]));
+		if (TEST_CYCLE_Masked)
+			printf(" %7u\n", TEST_CYCLE_Masked);
+		else
+			printf(" %7s\n", "-");
+	}
+	return 0;
+}
+
+/*****************************END OF FILE************************************/
@@ -0,0 +1,341 @@
+/**
+  ******************************************************************************
+  * File Name          : disk.c
+  * Description        : host test harness - RAM disk, S25FL164K model, counting driver
+  ******************************************************************************
+  * author: Tomas Krejci <info@tomaskrejci.com>
+  *
+  *
+  ******************************************************************************
+  */
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "ff_gen_drv.h"
+#include "user_diskio.h"
+#include "serialflash.h"
+#include "ftl.h"
+#include "host.h"
+
+#define		RAM_SIZE		(FTL_SECTORS * FTL_SECTOR_SIZE)
+
+// TEST_DISK_Op
+#define		OP_DONE			0
+#define		OP_TORN			1				/* power fails during this one */
+#define		OP_DEAD			2				/* no power */
+
+TEST_DISK_StatsTypeDef TEST_DISK_Stats;
+char TEST_DISK_Path[4];
+uint32_t TEST_DISK_RealTime;
+uint32_t TEST_DISK_EraseBlock;
+
+static uint8_t DiskFlash[TEST_FLASH_SIZE];
+static uint8_t DiskRam[RAM_SIZE];
+static uint8_t *pDiskSave;
+static Diskio_drvTypeDef *pDiskBackend;
+
+static uint32_t DiskOps;				/* page programs + erases or RAM sector writes */
+static uint32_t DiskCutAt;			/* 0 = no cut */
+static uint8_t  DiskDead;
+
+
+/**		Flash busy time, slept too when threads compete for the volume
+*/
+static void TEST_DISK_Busy(uint32_t Us)
+{
+	TEST_DISK_Stats.FlashTime += Us;
+	if (TEST_DISK_RealTime)
+		usleep(Us);
+}
+
+/**		Count one program or erase
+*/
+static uint8_t TEST_DISK_Op(void)
+{
+	if (DiskDead)
+		return OP_DEAD;
+	DiskOps++;
+	if (DiskCutAt != 0 && DiskOps >= DiskCutAt)
+	{
+		DiskDead = TRUE;
+		return OP_TORN;
+	}
+	return OP_DONE;
+}
+
+/*---------------------------------------------------------------------------*/
+/* S25FL164K model, serialflash.c interface used by ftl.c                    */
+/*---------------------------------------------------------------------------*/
+
+uint8_t BSP_SERIAL_FLASH_ReadData(uint32_t uwStartAddress, uint8_t* pData, uint32_t uwDataSize)
+{
+	if (DiskDead || uwStartAddress + uwDataSize > TEST_FLASH_SIZE)
+		return FLASH_ERROR;
+
+	memcpy(pData, &DiskFlash[uwStartAddress], uwDataSize);
+	TEST_DISK_Stats.FlashRead += uwDataSize;
+	TEST_DISK_Busy(TEST_FLASH_T_CMD + uwDataSize * 2 / 3);
+	return FLASH_OK;
+}
+
+uint8_t BSP_SERIAL_FLASH_WriteData(uint32_t uwStartAddress, uint8_t* pData, uint32_t uwDataSize)
+{
+	uint32_t Part, i, Torn;
+	uint8_t Op;
+
+	if (uwStartAddress + uwDataSize > TEST_FLASH_SIZE)
+		return FLASH_ERROR;
+
+	// page by page, as serialflash.c splits it
+	while (uwDataSize > 0)
+	{
+		Part = TEST_FLASH_PAGE - (uwStartAddress % TEST_FLASH_PAGE);
+		if (Part > uwDataSize)
+			Part = uwDataSize;
+
+		Op = TEST_DISK_Op();
+		if (Op == OP_DEAD)
+			return FLASH_ERROR;
+		// power lost during this program, a prefix reached the cells
+		Torn = (Op == OP_TORN) ? (uint32_t)rand() % (Part + 1) : Part;
+
+		for (i = 0; i < Torn; i++)
+			DiskFlash[uwStartAddress + i] &= pData[i];
+		if (Torn != Part)
+			return FLASH_ERROR;
+
+		TEST_DISK_Stats.FlashPage++;
+		TEST_DISK_Busy(TEST_FLASH_T_PAGE);
+		uwStartAddress += Part;
+		pData += Part;
+		uwDataSize -= Part;
+	}
+	return FLASH_OK;
+}
+
+uint8_t BSP_SERIAL_FLASH_WritePage(uint32_t uwStartAddress, uint8_t* pData, uint32_t uwDataSize)
+{
+	return BSP_SERIAL_FLASH_WriteData(uwStartAddress, pData, uwDataSize);
+}
+
+uint8_t BSP_SERIAL_FLASH_EraseSector(uint32_t SectorAddr)
+{
+	uint32_t Torn;
+	uint8_t Op;
+
+	SectorAddr &= ~(TEST_FLASH_SECTOR - 1);
+	if (SectorAddr >= TEST_FLASH_SIZE)
+		return FLASH_ERROR;
+
+	Op = TEST_DISK_Op();
+	if (Op == OP_DEAD)
+		return FLASH_ERROR;
+	// interrupted erase, part of the sector is erased
+	Torn = (Op == OP_TORN) ? (uint32_t)rand() % TEST_FLASH_SECTOR : TEST_FLASH_SECTOR;
+
+	memset(&DiskFlash[SectorAddr], 0xFF, Torn);
+	if (Torn != TEST_FLASH_SECTOR)
+		return FLASH_ERROR;
+
+	TEST_DISK_Stats.FlashErase++;
+	TEST_DISK_Busy(TEST_FLASH_T_ERASE);
+	return FLASH_OK;
+}
+
+/*---------------------------------------------------------------------------*/
+/* RAM disk, same geometry as the log volume                                 */
+/*---------------------------------------------------------------------------*/
+
+static DSTATUS TEST_DISK_RamInit(BYTE lun)
+{
+	return 0;
+}
+
+static DSTATUS TEST_DISK_RamStatus(BYTE lun)
+{
+	return 0;
+}
+
+static DRESULT TEST_DISK_RamRead(BYTE lun, BYTE *buff, DWORD sector, UINT count)
+{
+	if (DiskDead)
+		return RES_NOTRDY;
+	if (sector + count > FTL_SECTORS)
+		return RES_PARERR;
+	memcpy(buff, &DiskRam[sector * FTL_SECTOR_SIZE], count * FTL_SECTOR_SIZE);
+	return RES_OK;
+}
+
+static DRESULT TEST_DISK_RamWrite(BYTE lun, const BYTE *buff, DWORD sector, UINT count)
+{
+	if (sector + count > FTL_SECTORS)
+		return RES_PARERR;
+
+	// sectors are atomic here, power fails between two of them
+	for (; count > 0; count--, sector++, buff += FTL_SECTOR_SIZE)
+	{
+		if (TEST_DISK_Op() != OP_DONE)
+			return RES_NOTRDY;
+		memcpy(&DiskRam[sector * FTL_SECTOR_SIZE], buff, FTL_SECTOR_SIZE);
+	}
+	return RES_OK;
+}
+
+static DRESULT TEST_DISK_RamIoctl(BYTE lun, BYTE cmd, void *buff)
+{
+	switch (cmd)
+	{
+		case CTRL_SYNC:
+			return RES_OK;
+		case GET_SECTOR_COUNT:
+			*(DWORD *)buff = FTL_SECTORS;
+			return RES_OK;
+		case GET_SECTOR_SIZE:
+			*(WORD *)buff = FTL_SECTOR_SIZE;
+			return RES_OK;
+		case GET_BLOCK_SIZE:
+			*(DWORD *)buff = FTL_BLOCK_SECTORS;
+			return RES_OK;
+	}
+	return RES_PARERR;
+}
+
+static Diskio_drvTypeDef RamDriver =
+{
+	TEST_DISK_RamInit,
+	TEST_DISK_RamStatus,
+	TEST_DISK_RamRead,
+	TEST_DISK_RamWrite,
+	TEST_DISK_RamIoctl,
+};
+
+/*---------------------------------------------------------------------------*/
+/* Counting driver linked to FatFs, forwards to the backend                  */
+/*---------------------------------------------------------------------------*/
+
+static DSTATUS TEST_DISK_DrvInit(BYTE lun)
+{
+	return pDiskBackend->disk_initialize(lun);
+}
+
+static DSTATUS TEST_DISK_DrvStatus(BYTE lun)
+{
+	return pDiskBackend->disk_status(lun);
+}
+
+static DRESULT TEST_DISK_DrvRead(BYTE lun, BYTE *buff, DWORD sector, UINT count)
+{
+	TEST_DISK_Stats.ReadCall++;
+	TEST_DISK_Stats.ReadSector += count;
+	return pDiskBackend->disk_read(lun, buff, sector, count);
+}
+
+static DRESULT TEST_DISK_DrvWrite(BYTE lun, const BYTE *buff, DWORD sector, UINT count)
+{
+	TEST_DISK_Stats.WriteCall++;
+	TEST_DISK_Stats.WriteSector += count;
+	return pDiskBackend->disk_write(lun, buff, sector, count);
+}
+
+static DRESULT TEST_DISK_DrvIoctl(BYTE lun, BYTE cmd, void *buff)
+{
+	if (cmd == CTRL_SYNC)
+		TEST_DISK_Stats.Sync++;
+	if (cmd == GET_BLOCK_SIZE && TEST_DISK_EraseBlock != 0)
+	{
+		*(DWORD *)buff = TEST_DISK_EraseBlock;
+		return RES_OK;
+	}
+	return pDiskBackend->disk_ioctl(lun, cmd, buff);
+}
+
+static Diskio_drvTypeDef TestDriver =
+{
+	TEST_DISK_DrvInit,
+	TEST_DISK_DrvStatus,
+	TEST_DISK_DrvRead,
+	TEST_DISK_DrvWrite,
+	TEST_DISK_DrvIoctl,
+};
+
+/**		Blank medium (erased flash / zeroed RAM), counters cleared
+*/
+void TEST_DISK_Init(uint8_t Backend)
+{
+	if (TEST_DISK_Path[0] != 0)
+		FATFS_UnLinkDriver(TEST_DISK_Path);
+
+	pDiskBackend = (Backend == TEST_DISK_FLASH) ? &USER_Driver : &RamDriver;
+	memset(DiskFlash, 0xFF, sizeof(DiskFlash));
+	memset(DiskRam, 0, sizeof(DiskRam));
+	DiskOps = 0;
+	DiskCutAt = 0;
+	DiskDead = FALSE;
+	TEST_DISK_Reset();
+
+	FATFS_LinkDriver(&TestDriver, TEST_DISK_Path);
+}
+
+void TEST_DISK_Reset(void)
+{
+	memset(&TEST_DISK_Stats, 0, sizeof(TEST_DISK_Stats));
+	memset(&FTL_Stats, 0, sizeof(FTL_Stats));
+}
+
+/**		Page programs and erases (flash) or sector writes (RAM) since TEST_DISK_Init
+*/
+uint32_t TEST_DISK_Ops(void)
+{
+	return DiskOps;
+}
+
+/**		Power fails during the Ops-th program/erase (before the Ops-th sector
+			write on the RAM disk) from now, 0 = never
+*/
+void TEST_DISK_Cut(uint32_t Ops, uint32_t Seed)
+{
+	srand(Seed);
+	DiskCutAt = (Ops != 0) ? DiskOps + Ops : 0;
+	DiskDead = FALSE;
+}
+
+uint8_t TEST_DISK_IsCut(void)
+{
+	return DiskDead;
+}
+
+/**		Reboot: flash keeps its cells, RAM state of FTL and driver is gone,
+			the next f_mount runs USER_initialize (FTL_Mount) again
+*/
+void TEST_DISK_PowerOn(void)
+{
+	DiskCutAt = 0;
+	DiskDead = FALSE;
+	FATFS_UnLinkDriver(TEST_DISK_Path);
+	FATFS_LinkDriver(&TestDriver, TEST_DISK_Path);
+}
+
+/**		Medium snapshot, e.g. freshly formatted volume reused by every run
+*/
+void TEST_DISK_Save(void)
+{
+	if (pDiskSave == NULL)
+		pDiskSave = malloc(TEST_FLASH_SIZE);
+	if (pDiskBackend == &RamDriver)
+		memcpy(pDiskSave, DiskRam, RAM_SIZE);
+	else
+		memcpy(pDiskSave, DiskFlash, TEST_FLASH_SIZE);
+}
+
+void TEST_DISK_Restore(void)
+{
+	if (pDiskBackend == &RamDriver)
+		memcpy(DiskRam, pDiskSave, RAM_SIZE);
+	else
+		memcpy(DiskFlash, pDiskSave, TEST_FLASH_SIZE);
+	DiskCutAt = 0;
+	DiskDead = FALSE;
+	TEST_DISK_PowerOn();
+}
+
+/*****************************END OF FILE************************************/
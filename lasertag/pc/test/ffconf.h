@@ -0,0 +1,54 @@
+/**
+  ******************************************************************************
+  * File Name          : ffconf.h
+  * Description        : host test FatFs configuration = firmware ffconf.h + overrides
+  ******************************************************************************
+  * author: Tomas Krejci <info@tomaskrejci.com>
+  *
+  *	Found before the firmware Inc/ffconf.h (include path order in Makefile).
+  *	A configuration of the Makefile sets TEST_<option> to override one option,
+  *	options without TEST_ define keep the firmware value.
+  ******************************************************************************
+  */
+#ifndef __TEST_FFCONF_H
+#define __TEST_FFCONF_H
+
+#include "../../cubemx/lasertag/Inc/ffconf.h"
+
+#ifdef TEST_FS_WINCACHE_FAT
+#undef _FS_WINCACHE_FAT
+#define _FS_WINCACHE_FAT	TEST_FS_WINCACHE_FAT
+#endif
+
+#ifdef TEST_FS_WINCACHE_DIR
+#undef _FS_WINCACHE_DIR
+#define _FS_WINCACHE_DIR	TEST_FS_WINCACHE_DIR
+#endif
+
+#ifdef TEST_FS_DIRHASH
+#undef _FS_DIRHASH
+#define _FS_DIRHASH				TEST_FS_DIRHASH
+#endif
+
+#ifdef TEST_FS_LAZYSYNC
+#undef _FS_LAZYSYNC
+#define _FS_LAZYSYNC			TEST_FS_LAZYSYNC
+#endif
+
+#ifdef TEST_FS_YIELD
+#undef _FS_YIELD
+#define _FS_YIELD					TEST_FS_YIELD
+#endif
+
+#ifdef TEST_FS_TINY
+#undef _FS_TINY
+#define _FS_TINY					TEST_FS_TINY
+#endif
+
+// volume lock by host_os.c (pthreads), not the FreeRTOS mutex of syscall.c
+#undef _SYNC_t
+#define _SYNC_t						void *
+
+#endif /* __TEST_FFCONF_H */
+
+/*****************************END OF FILE************************************/
@@ -0,0 +1,615 @@
+/**
+  ******************************************************************************
+  * File Name          : fftest.c
+  * Description        : host test harness - FatFs workloads, disk traffic report
+  ******************************************************************************
+  * author: Tomas Krejci <info@tomaskrejci.com>
+  *
+  *	usage: fftest [-a cluster] [-e sectors] [ram|flash] [workload ...]
+  *	Default is every workload on both backends. Each workload runs on a freshly
+  *	formatted volume, its setup is not counted, its data is read back and
+  *	checked after the counted part. Exit code 1 on any FatFs error or mismatch.
+  *	-a sets the f_mkfs cluster size in bytes, -e the erase block f_mkfs aligns
+  *	to (GET_BLOCK_SIZE, 1 = no alignment). share sleeps the flash time for
+  *	real, it runs on the flash only and only when named.
+  *
+  *	One line per workload: disk_read/disk_write calls and sectors, CTRL_SYNC,
+  *	KB moved at the driver, flash page programs and sector erases, FTL write
+  *	amplification (flash sector writes / host sector writes), simulated flash
+  *	time and host wall time.
+  ******************************************************************************
+  */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include "ff.h"
+#include "ftl.h"
+#include "common.h"
+#include "host.h"
+
+#ifndef TEST_CONFIG
+#define TEST_CONFIG		"target"
+#endif
+
+typedef struct
+{
+	const char	*pName;
+	uint8_t			(*pSetup)(void);		/* not counted, may be NULL */
+	uint8_t			(*pRun)(void);			/* counted */
+	uint8_t			(*pVerify)(void);		/* not counted, may be NULL */
+	uint8_t			RealTime;						/* flash only, sleeps, runs when named */
+} WorkTypeDef;
+
+#define		TRY(x)		do { FRESULT TryRes = (x); if (TryRes != FR_OK) { \
+										fprintf(stderr, "%s:%d %s = %u\n", __FILE__, __LINE__, #x, TryRes); \
+										return 1; } } while (0)
+#define		CHECK(c)	do { if (!(c)) { \
+										fprintf(stderr, "%s:%d %s failed\n", __FILE__, __LINE__, #c); \
+										return 1; } } while (0)
+
+// sound bank
+#define		SND_FILES			40
+#define		SND_PLAYS			200
+#define		SND_CHUNK			128				/* audio buffer half */
+// game log
+#define		LOG_RECORDS		3000
+#define		LOG_REC				61
+#define		LOG_PERIOD		20				/* ms between records */
+#define		LOG_SYNC			25				/* records between f_sync, 0.5 s */
+// directory
+#define		DIR_FILES			300
+#define		DIR_HOT				12
+#define		DIR_OPENS			1000
+// full volume
+#define		FILL_DIR			200				/* files per directory */
+#define		FILL_GAP			40				/* every 40th file deleted */
+#define		FILL_WRITE		700
+// deep path
+#define		DEEP_FILES		40				/* files in each of the 4 directories */
+#define		DEEP_APPENDS	500
+// shared volume
+#define		SHARE_WRITE		32768			/* bytes between f_sync of the writer */
+#define		SHARE_LIMIT		0x100000	/* log size */
+#define		SHARE_READ		512
+#define		SHARE_READS		100
+#define		SHARE_PERIOD	5000			/* us between reads */
+
+static FATFS Fs;
+static FIL File;
+static uint8_t Buf[512];
+static char Note[80];
+static UINT Au;										/* f_mkfs cluster size, 0 = auto */
+
+
+/**		File content, byte Ofs of file Id
+*/
+static uint8_t Pattern(uint32_t Id, uint32_t Ofs)
+{
+	return (uint8_t)((Ofs * 131 + (Ofs >> 9) + Id * 29) ^ (Id >> 3));
+}
+
+static uint8_t WriteFile(const char *pPath, uint32_t Id, uint32_t Size, uint32_t Chunk)
+{
+	uint32_t Ofs, Part, i;
+	UINT Bw;
+
+	TRY(f_open(&File, pPath, FA_CREATE_ALWAYS | FA_WRITE));
+	for (Ofs = 0; Ofs < Size; Ofs += Part)
+	{
+		Part = (Size - Ofs < Chunk) ? Size - Ofs : Chunk;
+		for (i = 0; i < Part; i++)
+			Buf[i] = Pattern(Id, Ofs + i);
+		TRY(f_write(&File, Buf, Part, &Bw));
+		CHECK(Bw == Part);
+	}
+	TRY(f_close(&File));
+	return 0;
+}
+
+static uint8_t ReadFile(const char *pPath, uint32_t Id, uint32_t Size, uint32_t Chunk)
+{
+	uint32_t Ofs, i;
+	UINT Br;
+
+	TRY(f_open(&File, pPath, FA_READ));
+	CHECK(f_size(&File) == Size);
+	for (Ofs = 0; ; Ofs += Br)
+	{
+		TRY(f_read(&File, Buf, Chunk, &Br));
+		if (Br == 0)
+			break;
+		for (i = 0; i < Br; i++)
+			CHECK(Buf[i] == Pattern(Id, Ofs + i));
+	}
+	CHECK(Ofs == Size);
+	TRY(f_close(&File));
+	return 0;
+}
+
+/*---------------------------------------------------------------------------*/
+/* play - sound bank of 40 files, 200 plays read sequentially in 128 B       */
+/*---------------------------------------------------------------------------*/
+
+static uint32_t SndSize(uint32_t Id)
+{
+	return 4096 + (Id * 1637) % 16384;
+}
+
+static void SndPath(char *pPath, uint32_t Id)
+{
+	sprintf(pPath, "SND/S%02u.ADP", (unsigned)Id);
+}
+
+static uint8_t SndSetup(void)
+{
+	char Path[24];
+	uint32_t i;
+
+	TRY(f_mkdir("SND"));
+	for (i = 0; i < SND_FILES; i++)
+	{
+		SndPath(Path, i);
+		if (WriteFile(Path, i, SndSize(i), sizeof(Buf)))
+			return 1;
+	}
+	return 0;
+}
+
+static uint8_t SndPlay(void)
+{
+	char Path[24];
+	uint32_t i, Id, Bytes = 0;
+
+	for (i = 0; i < SND_PLAYS; i++)
+	{
+		Id = (i * 7) % SND_FILES;
+		SndPath(Path, Id);
+		if (ReadFile(Path, Id, SndSize(Id), SND_CHUNK))
+			return 1;
+		Bytes += SndSize(Id);
+	}
+	sprintf(Note, "%.2f sectors read per KB played",
+		TEST_DISK_Stats.ReadSector * 1024.0 / Bytes);
+	return 0;
+}
+
+/*---------------------------------------------------------------------------*/
+/* log - 61 B record every 20 ms, f_sync every 0.5 s                         */
+/*---------------------------------------------------------------------------*/
+
+static uint8_t LogRun(void)
+{
+	uint32_t i, j;
+	UINT Bw;
+
+	TRY(f_open(&File, "GAME.LOG", FA_CREATE_ALWAYS | FA_WRITE));
+	for (i = 0; i < LOG_RECORDS; i++)
+	{
+		for (j = 0; j < LOG_REC; j++)
+			Buf[j] = Pattern(0, i * LOG_REC + j);
+		TRY(f_write(&File, Buf, LOG_REC, &Bw));
+		CHECK(Bw == LOG_REC);
+		TEST_OS_Tick += LOG_PERIOD;
+		if ((i + 1) % LOG_SYNC == 0)
+			TRY(f_sync(&File));
+	}
+	TRY(f_close(&File));
+	sprintf(Note, "%.2f sectors written per record",
+		(double)TEST_DISK_Stats.WriteSector / LOG_RECORDS);
+	return 0;
+}
+
+static uint8_t LogVerify(void)
+{
+	return ReadFile("GAME.LOG", 0, LOG_RECORDS * LOG_REC, sizeof(Buf));
+}
+
+/*---------------------------------------------------------------------------*/
+/* dir - 300 files in one directory, 1000 opens of 12 hot names              */
+/*---------------------------------------------------------------------------*/
+
+static void DirPath(char *pPath, uint32_t Id)
+{
+	sprintf(pPath, "DIR/F%03u.DAT", (unsigned)Id);
+}
+
+static uint8_t DirSetup(void)
+{
+	char Path[24];
+	uint32_t i;
+
+	TRY(f_mkdir("DIR"));
+	for (i = 0; i < DIR_FILES; i++)
+	{
+		DirPath(Path, i);
+		if (WriteFile(Path, i, 16, 16))
+			return 1;
+	}
+	return 0;
+}
+
+static uint8_t DirOpen(void)
+{
+	char Path[24];
+	uint32_t i, Id;
+
+	for (i = 0; i < DIR_OPENS; i++)
+	{
+		Id = (i % DIR_HOT) * (DIR_FILES / DIR_HOT) + DIR_HOT;
+		DirPath(Path, Id);
+		if (ReadFile(Path, Id, 16, 16))
+			return 1;
+	}
+	sprintf(Note, "%.1f sectors read per open",
+		(double)TEST_DISK_Stats.ReadSector / DIR_OPENS);
+	return 0;
+}
+
+/*---------------------------------------------------------------------------*/
+/* sound - writing the sound bank of play                                    */
+/*---------------------------------------------------------------------------*/
+
+static uint8_t SndVerify(void)
+{
+	char Path[24];
+	uint32_t i;
+
+	for (i = 0; i < SND_FILES; i++)
+	{
+		SndPath(Path, i);
+		if (ReadFile(Path, i, SndSize(i), sizeof(Buf)))
+			return 1;
+	}
+	return 0;
+}
+
+/*---------------------------------------------------------------------------*/
+/* log2 - two logs of log written record by record in turns                  */
+/*---------------------------------------------------------------------------*/
+
+static uint8_t Log2Run(void)
+{
+	static FIL Log2;
+	FIL *pLog;
+	uint32_t i, j;
+	UINT Bw;
+
+	TRY(f_open(&File, "GAME.LOG", FA_CREATE_ALWAYS | FA_WRITE));
+	TRY(f_open(&Log2, "HITS.LOG", FA_CREATE_ALWAYS | FA_WRITE));
+	for (i = 0; i < 2 * LOG_RECORDS; i++)
+	{
+		pLog = (i & 1) ? &Log2 : &File;
+		for (j = 0; j < LOG_REC; j++)
+			Buf[j] = Pattern(i & 1, (i / 2) * LOG_REC + j);
+		TRY(f_write(pLog, Buf, LOG_REC, &Bw));
+		CHECK(Bw == LOG_REC);
+		TEST_OS_Tick += LOG_PERIOD / 2;
+		if ((i / 2 + 1) % LOG_SYNC == 0)
+			TRY(f_sync(pLog));
+	}
+	TRY(f_close(&File));
+	TRY(f_close(&Log2));
+	sprintf(Note, "%.2f sectors written per record",
+		(double)TEST_DISK_Stats.WriteSector / (2 * LOG_RECORDS));
+	return 0;
+}
+
+static uint8_t Log2Verify(void)
+{
+	if (ReadFile("GAME.LOG", 0, LOG_RECORDS * LOG_REC, sizeof(Buf)))
+		return 1;
+	return ReadFile("HITS.LOG", 1, LOG_RECORDS * LOG_REC, sizeof(Buf));
+}
+
+/*---------------------------------------------------------------------------*/
+/* fill - full volume of 1 cluster files, every 40th deleted, then appended  */
+/*        in 700 B writes until the freed clusters are used                  */
+/*---------------------------------------------------------------------------*/
+
+static uint32_t FillFree;
+
+static void FillPath(char *pPath, uint32_t Id)
+{
+	sprintf(pPath, "D%02u/F%03u.DAT", (unsigned)(Id / FILL_DIR), (unsigned)(Id % FILL_DIR));
+}
+
+static uint8_t FillSetup(void)
+{
+	char Path[24];
+	uint32_t Id, Clust = Fs.csize * 512, Ofs;
+	FRESULT Res;
+	UINT Bw = 0;
+
+	memset(Buf, 0xA5, sizeof(Buf));
+	for (Id = 0; ; Id++)
+	{
+		if (Id % FILL_DIR == 0)
+		{
+			sprintf(Path, "D%02u", (unsigned)(Id / FILL_DIR));
+			Res = f_mkdir(Path);
+			if (Res == FR_DENIED)
+				break;
+			TRY(Res);
+		}
+		FillPath(Path, Id);
+		Res = f_open(&File, Path, FA_CREATE_ALWAYS | FA_WRITE);
+		if (Res == FR_DENIED)
+			break;
+		TRY(Res);
+		for (Ofs = 0; Ofs < Clust; Ofs += Bw)
+		{
+			TRY(f_write(&File, Buf, sizeof(Buf), &Bw));
+			if (Bw != sizeof(Buf))
+				break;
+		}
+		TRY(f_close(&File));
+		if (Ofs < Clust)
+		{
+			TRY(f_unlink(Path));
+			break;
+		}
+	}
+	CHECK(Id > FILL_GAP);
+
+	for (FillFree = 0; FillFree < Id / FILL_GAP; FillFree++)
+	{
+		FillPath(Path, FillFree * FILL_GAP + FILL_GAP / 2);
+		TRY(f_unlink(Path));
+	}
+	// remount, the first allocation starts from a cold volume
+	TRY(f_mount(NULL, TEST_DISK_Path, 0));
+	return f_mount(&Fs, TEST_DISK_Path, 1) != FR_OK;
+}
+
+static uint8_t FillRun(void)
+{
+	uint32_t Clust = Fs.csize * 512, Size = 0;
+	UINT Bw;
+
+	memset(Buf, 0x5A, sizeof(Buf));
+	TRY(f_open(&File, "APPEND.LOG", FA_CREATE_ALWAYS | FA_WRITE));
+	while (Size + FILL_WRITE <= (FillFree - 1) * Clust)
+	{
+		TRY(f_write(&File, Buf, FILL_WRITE, &Bw));
+		CHECK(Bw == FILL_WRITE);
+		Size += FILL_WRITE;
+	}
+	TRY(f_close(&File));
+	sprintf(Note, "%.1f sectors read per allocated cluster",
+		(double)TEST_DISK_Stats.ReadSector / ((Size + Clust - 1) / Clust));
+	return 0;
+}
+
+/*---------------------------------------------------------------------------*/
+/* deep - open/append/close of a log 4 directories deep                      */
+/*---------------------------------------------------------------------------*/
+
+static uint8_t DeepSetup(void)
+{
+	static const char * const Dir[] = { "A", "A/B", "A/B/C", "A/B/C/D" };
+	char Path[24];
+	uint32_t i, j;
+
+	for (i = 0; i < sizeof(Dir) / sizeof(Dir[0]); i++)
+	{
+		TRY(f_mkdir(Dir[i]));
+		for (j = 0; j < DEEP_FILES; j++)
+		{
+			sprintf(Path, "%s/F%02u.DAT", Dir[i], (unsigned)j);
+			if (WriteFile(Path, j, 16, 16))
+				return 1;
+		}
+	}
+	return 0;
+}
+
+static uint8_t DeepRun(void)
+{
+	uint32_t i, j;
+	UINT Bw;
+
+	for (i = 0; i < DEEP_APPENDS; i++)
+	{
+		TRY(f_open(&File, "A/B/C/D/DEEP.LOG", FA_OPEN_ALWAYS | FA_WRITE));
+		TRY(f_lseek(&File, f_size(&File)));
+		for (j = 0; j < LOG_REC; j++)
+			Buf[j] = Pattern(2, i * LOG_REC + j);
+		TRY(f_write(&File, Buf, LOG_REC, &Bw));
+		CHECK(Bw == LOG_REC);
+		TRY(f_close(&File));
+	}
+	sprintf(Note, "%.1f sectors read per append",
+		(double)TEST_DISK_Stats.ReadSector / DEEP_APPENDS);
+	return 0;
+}
+
+static uint8_t DeepVerify(void)
+{
+	return ReadFile("A/B/C/D/DEEP.LOG", 2, DEEP_APPENDS * LOG_REC, sizeof(Buf));
+}
+
+/*---------------------------------------------------------------------------*/
+/* share - 512 B sound reads of one thread against 32 KB log appends with    */
+/*         f_sync of another, flash time slept for real                      */
+/*---------------------------------------------------------------------------*/
+
+static volatile uint8_t ShareDone;
+
+static void *ShareWriter(void *pArg)
+{
+	static uint8_t Chunk[SHARE_WRITE];
+	static FIL Log;
+	UINT Bw;
+
+	memset(Chunk, 0x3C, sizeof(Chunk));
+	if (f_open(&Log, "SHARE.LOG", FA_CREATE_ALWAYS | FA_WRITE) != FR_OK)
+		return (void *)1;
+	while (!ShareDone)
+	{
+		if (f_write(&Log, Chunk, sizeof(Chunk), &Bw) != FR_OK || Bw != sizeof(Chunk)
+			|| f_sync(&Log) != FR_OK)
+			return (void *)1;
+		// overwrite from the start, keeps the volume from filling up
+		if (f_tell(&Log) >= SHARE_LIMIT && f_lseek(&Log, 0) != FR_OK)
+			return (void *)1;
+	}
+	return (f_close(&Log) != FR_OK) ? (void *)1 : NULL;
+}
+
+static uint8_t ShareRun(void)
+{
+	static uint8_t Data[SHARE_READ];
+	pthread_t Writer;
+	uint64_t Start, Time, Sum = 0, Max = 0;
+	void *pRes;
+	uint32_t i;
+	UINT Br;
+
+	TRY(f_open(&File, "SND/S00.ADP", FA_READ));
+	TEST_DISK_RealTime = TRUE;
+	ShareDone = FALSE;
+	CHECK(pthread_create(&Writer, NULL, ShareWriter, NULL) == 0);
+	for (i = 0; i < SHARE_READS; i++)
+	{
+		usleep(SHARE_PERIOD);
+		if (f_tell(&File) + SHARE_READ > f_size(&File))
+			TRY(f_lseek(&File, 0));
+		Start = TEST_OS_Us();
+		TRY(f_read(&File, Data, SHARE_READ, &Br));
+		Time = TEST_OS_Us() - Start;
+		CHECK(Br == SHARE_READ);
+		Sum += Time;
+		if (Time > Max)
+			Max = Time;
+	}
+	ShareDone = TRUE;
+	pthread_join(Writer, &pRes);
+	TEST_DISK_RealTime = FALSE;
+	CHECK(pRes == NULL);
+	TRY(f_close(&File));
+	sprintf(Note, "read avg %.1f ms max %.1f ms",
+		Sum / 1000.0 / SHARE_READS, Max / 1000.0);
+	return 0;
+}
+
+static uint8_t ShareSetup(void)
+{
+	TRY(f_mkdir("SND"));
+	return WriteFile("SND/S00.ADP", 0, SndSize(0), sizeof(Buf));
+}
+
+static const WorkTypeDef Work[] =
+{
+	{ "play",		SndSetup,		SndPlay,	NULL,				FALSE },
+	{ "log",		NULL,				LogRun,		LogVerify,	FALSE },
+	{ "dir",		DirSetup,		DirOpen,	NULL,				FALSE },
+	{ "sound",	NULL,				SndSetup,	SndVerify,	FALSE },
+	{ "log2",		NULL,				Log2Run,	Log2Verify,	FALSE },
+	{ "fill",		FillSetup,	FillRun,	NULL,				FALSE },
+	{ "deep",		DeepSetup,	DeepRun,	DeepVerify,	FALSE },
+	{ "share",	ShareSetup,	ShareRun,	NULL,				TRUE },
+};
+
+#define		WORK_CNT		(sizeof(Work) / sizeof(Work[0]))
+
+/*---------------------------------------------------------------------------*/
+
+static uint8_t Run(uint8_t Backend, const WorkTypeDef *pWork)
+{
+	TEST_DISK_StatsTypeDef Stats;
+	uint32_t HostWrite, FlashWrite;
+	uint64_t Start, Wall;
+
+	TEST_DISK_Init(Backend);
+	TEST_OS_Tick = 0;
+	Note[0] = 0;
+	TRY(f_mount(&Fs, TEST_DISK_Path, 0));
+	TRY(f_mkfs(TEST_DISK_Path, 1, Au));
+	TRY(f_mount(&Fs, TEST_DISK_Path, 1));
+	if (pWork->pSetup != NULL && pWork->pSetup())
+		return 1;
+
+	TEST_DISK_Reset();
+	Start = TEST_OS_Us();
+	if (pWork->pRun())
+		return 1;
+	Wall = TEST_OS_Us() - Start;
+	Stats = TEST_DISK_Stats;
+	HostWrite = FTL_Stats.HostWrite;
+	FlashWrite = FTL_Stats.FlashWrite;
+
+	if (pWork->pVerify != NULL && pWork->pVerify())
+		return 1;
+	TRY(f_mount(NULL, TEST_DISK_Path, 0));
+
+	printf("%-9s %-5s %-6s %7u %7u %7u %7u %5u %8u",
+		TEST_CONFIG, (Backend == TEST_DISK_FLASH) ? "flash" : "ram", pWork->pName,
+		Stats.ReadCall, Stats.ReadSector, Stats.WriteCall, Stats.WriteSector, Stats.Sync,
+		(Stats.ReadSector + Stats.WriteSector) / 2);
+	if (Backend == TEST_DISK_FLASH)
+		printf(" %7u %6u %5.2f %9.1f", Stats.FlashPage, Stats.FlashErase,
+			HostWrite ? (double)FlashWrite / HostWrite : 0.0, Stats.FlashTime / 1000.0);
+	else
+		printf(" %7s %6s %5s %9s", "-", "-", "-", "-");
+	printf(" %8.1f  %s\n", Wall / 1000.0, Note);
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	uint8_t Backend[2] = { TEST_DISK_RAM, TEST_DISK_FLASH };
+	uint8_t Backends = 2, Fail = 0, b;
+	uint32_t i;
+	int a = 1, w;
+
+	if (argc > a + 1 && strcmp(argv[a], "-a") == 0)
+	{
+		Au = strtoul(argv[a + 1], NULL, 0);
+		a += 2;
+	}
+	if (argc > a + 1 && strcmp(argv[a], "-e") == 0)
+	{
+		TEST_DISK_EraseBlock = strtoul(argv[a + 1], NULL, 0);
+		a += 2;
+	}
+	if (argc > a && strcmp(argv[a], "ram") == 0)
+		Backends = 1, a++;
+	else if (argc > a && strcmp(argv[a], "flash") == 0)
+		Backend[0] = TEST_DISK_FLASH, Backends = 1, a++;
+
+	for (w = a; w < argc; w++)
+	{
+		for (i = 0; i < WORK_CNT && strcmp(argv[w], Work[i].pName) != 0; i++);
+		if (i == WORK_CNT)
+		{
+			fprintf(stderr, "usage: fftest [-a cluster] [-e sectors] [ram|flash] [workload ...]\nworkloads:");
+			for (i = 0; i < WORK_CNT; i++)
+				fprintf(stderr, " %s", Work[i].pName);
+			fprintf(stderr, "\n");
+			return 1;
+		}
+	}
+
+	printf("%-9s %-5s %-6s %7s %7s %7s %7s %5s %8s %7s %6s %5s %9s %8s\n",
+		"config", "disk", "work", "rd_call", "rd_sect", "wr_call", "wr_sect", "sync", "kb_moved",
+		"fl_page", "fl_ers", "wa", "flash_ms", "wall_ms");
+	for (b = 0; b < Backends; b++)
+	{
+		for (i = 0; i < WORK_CNT; i++)
+		{
+			for (w = a; w < argc && strcmp(argv[w], Work[i].pName) != 0; w++);
+			if ((a < argc && w == argc) || (Work[i].RealTime && (w == argc || Backend[b] != TEST_DISK_FLASH)))
+				continue;
+			if (Run(Backend[b], &Work[i]))
+			{
+				fprintf(stderr, "%s %s: FAILED\n", TEST_CONFIG, Work[i].pName);
+				Fail = 1;
+			}
+		}
+	}
+	return Fail;
+}
+
+/*****************************END OF FILE************************************/
@@ -0,0 +1,433 @@
+/**
+  ******************************************************************************
+  * File Name          : fuzz.c
+  * Description        : host test harness - power cut fuzz of FatFs + FTL
+  ******************************************************************************
+  * author: Tomas Krejci <info@tomaskrejci.com>
+  *
+  *	usage: fuzz [runs] [first seed] [ram|flash]
+  *	Default is 300 runs on both backends. Each run starts from the same volume
+  *	(formatted, OLD.LOG of 40 KB), appends CRC protected 61 B records to two
+  *	logs in turns, f_sync of each log every 25 of its records, deletes OLD.LOG
+  *	half way. Power fails at a random program/erase (flash, torn) or between
+  *	two sector writes (RAM), then the volume is remounted and checked:
+  *	- mount works, the root holds only the expected files
+  *	- a log holds whole records with valid CRC and consecutive numbers, at
+  *	  most the records written and at least the records of the last good
+  *	  f_sync, less what _FS_LAZYSYNC may defer (_FS_LAZYSYNC_BYTES)
+  *	- OLD.LOG is intact before f_unlink started and gone after it returned
+  *	- every chain ends with EOC, covers the file size, no cross links, no
+  *	  free or bad entry in it (lost clusters are counted, not an error)
+  *	The logs are then appended again without a cut, closed, remounted and
+  *	checked once more with no loss allowed. A failing run is repeated by
+  *	"fuzz 1 <seed> <disk>". Exit code 1 on any failure.
+  ******************************************************************************
+  */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ff.h"
+#include "common.h"
+#include "host.h"
+
+#ifndef TEST_CONFIG
+#define TEST_CONFIG		"target"
+#endif
+
+#define		REC					61
+#define		REC_SEQ			0				/* uint32_t record number in the log */
+#define		REC_LOG			4				/* log index */
+#define		REC_CRC			(REC - 2)
+#define		LOGS				2
+#define		RECORDS			1200			/* per run, all logs */
+#define		PERIOD			20				/* ms between records */
+#define		SYNC				25				/* records of a log between f_sync */
+#define		OLD_SIZE		40960
+
+#if _FS_LAZYSYNC
+#define		ALLOW				(_FS_LAZYSYNC_BYTES / REC + 1)
+#else
+#define		ALLOW				0
+#endif
+
+// OldState
+#define		OLD_PRESENT		0
+#define		OLD_UNLINK		1				/* f_unlink started */
+#define		OLD_GONE			2
+
+/* ff.c hidden API for disk tools */
+DWORD get_fat(FATFS *fs, DWORD clst);
+
+static const char * const LogName[LOGS] = { "LOG0.LOG", "LOG1.LOG" };
+
+static FATFS Fs;
+static FIL Log[LOGS];
+static FIL File;
+static uint8_t Buf[512];
+static uint8_t *pUsed;
+
+static uint32_t Written[LOGS];		/* records passed to f_write */
+static uint32_t Synced[LOGS];			/* records at the last good f_sync */
+static uint8_t OldState;
+static uint8_t Clean;							/* unmounted cleanly, nothing may be lost */
+
+static char Why[120];
+static uint32_t LostRec, LostClust, ExtraClust;
+
+
+#define		FAIL(...)		do { snprintf(Why, sizeof(Why), __VA_ARGS__); return 1; } while (0)
+
+static uint8_t Pattern(uint32_t Ofs)
+{
+	return (uint8_t)(Ofs * 131 + (Ofs >> 9));
+}
+
+static uint32_t Random(uint32_t *pSeed)
+{
+	*pSeed = *pSeed * 1103515245 + 12345;
+	return *pSeed >> 8;
+}
+
+static void Record(uint8_t *pRec, uint8_t Idx, uint32_t Seq)
+{
+	uint16_t Crc;
+	uint32_t i;
+
+	memcpy(&pRec[REC_SEQ], &Seq, 4);
+	pRec[REC_LOG] = Idx;
+	for (i = REC_LOG + 1; i < REC_CRC; i++)
+		pRec[i] = (uint8_t)(Seq * 7 + i);
+	Crc = CRC16_Calc(CRC16_INIT, pRec, REC_CRC);
+	memcpy(&pRec[REC_CRC], &Crc, 2);
+}
+
+/*---------------------------------------------------------------------------*/
+/* Workload                                                                  */
+/*---------------------------------------------------------------------------*/
+
+/**		Fresh volume with OLD.LOG, saved for every run
+*/
+static uint8_t Setup(uint8_t Backend)
+{
+	uint32_t Ofs, i;
+	UINT Bw;
+
+	TEST_DISK_Init(Backend);
+	if (f_mount(&Fs, TEST_DISK_Path, 0) != FR_OK || f_mkfs(TEST_DISK_Path, 1, 0) != FR_OK
+		|| f_mount(&Fs, TEST_DISK_Path, 1) != FR_OK
+		|| f_open(&File, "OLD.LOG", FA_CREATE_ALWAYS | FA_WRITE) != FR_OK)
+		FAIL("setup");
+	for (Ofs = 0; Ofs < OLD_SIZE; Ofs += sizeof(Buf))
+	{
+		for (i = 0; i < sizeof(Buf); i++)
+			Buf[i] = Pattern(Ofs + i);
+		if (f_write(&File, Buf, sizeof(Buf), &Bw) != FR_OK || Bw != sizeof(Buf))
+			FAIL("setup");
+	}
+	if (f_close(&File) != FR_OK || f_mount(NULL, TEST_DISK_Path, 0) != FR_OK)
+		FAIL("setup");
+	TEST_DISK_Save();
+	return 0;
+}
+
+/**		Append to the logs, stops at the first error (power cut)
+*/
+static FRESULT Work(void)
+{
+	uint8_t Rec[REC];
+	FRESULT Res;
+	uint32_t i;
+	uint8_t l;
+	UINT Bw;
+
+	Res = f_mount(&Fs, TEST_DISK_Path, 1);
+	for (l = 0; l < LOGS && Res == FR_OK; l++)
+	{
+		Res = f_open(&Log[l], LogName[l], FA_OPEN_ALWAYS | FA_WRITE);
+		if (Res == FR_OK)
+			Res = f_lseek(&Log[l], f_size(&Log[l]));
+		if (Res == FR_OK)
+			Written[l] = Synced[l] = f_size(&Log[l]) / REC;
+	}
+
+	for (i = 0; i < RECORDS && Res == FR_OK; i++)
+	{
+		l = i % LOGS;
+		Record(Rec, l, Written[l]);
+		Res = f_write(&Log[l], Rec, REC, &Bw);
+		if (Res == FR_OK && Bw != REC)
+			Res = FR_DENIED;
+		Written[l]++;
+		TEST_OS_Tick += PERIOD;
+
+		if (Res == FR_OK && Written[l] % SYNC == 0)
+		{
+			Res = f_sync(&Log[l]);
+			if (Res == FR_OK)
+				Synced[l] = Written[l];
+		}
+		if (Res == FR_OK && i == RECORDS / 2 && OldState == OLD_PRESENT)
+		{
+			OldState = OLD_UNLINK;
+			Res = f_unlink("OLD.LOG");
+			if (Res == FR_OK)
+				OldState = OLD_GONE;
+		}
+	}
+
+	for (l = 0; l < LOGS && Res == FR_OK; l++)
+	{
+		Res = f_close(&Log[l]);
+		if (Res == FR_OK)
+			Synced[l] = Written[l];
+	}
+	return Res;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Check                                                                     */
+/*---------------------------------------------------------------------------*/
+
+/**		Walk the chain from Clust, at least Size bytes, marks pUsed[]
+*/
+static uint8_t Chain(const char *pName, DWORD Clust, DWORD Size)
+{
+	DWORD Need, Count = 0;
+
+	Need = (Size + Fs.csize * 512 - 1) / (Fs.csize * 512);
+	if (Size == 0 && Clust == 0)
+		return 0;
+
+	while (Clust < Fs.n_fatent)
+	{
+		if (Clust < 2)
+			FAIL("%s: chain hits entry %u after %u clusters", pName, (unsigned)Clust, (unsigned)Count);
+		if (pUsed[Clust])
+			FAIL("%s: cluster %u cross linked or looped", pName, (unsigned)Clust);
+		pUsed[Clust] = 1;
+		Count++;
+		Clust = get_fat(&Fs, Clust);
+		if (Clust == 0xFFFFFFFF)
+			FAIL("%s: disk error in FAT", pName);
+	}
+	if (Count < Need)
+		FAIL("%s: chain of %u clusters for %u bytes", pName, (unsigned)Count, (unsigned)Size);
+	ExtraClust += Count - Need;
+	return 0;
+}
+
+static uint8_t CheckLog(uint8_t Idx)
+{
+	uint8_t Rec[REC];
+	uint32_t Seq, Count;
+	uint16_t Crc;
+	FRESULT Res;
+	UINT Br;
+
+	Res = f_open(&File, LogName[Idx], FA_READ);
+	if (Res == FR_NO_FILE)
+		Count = 0;
+	else if (Res != FR_OK)
+		FAIL("%s: open %u", LogName[Idx], Res);
+	else
+	{
+		if (f_size(&File) % REC)
+			FAIL("%s: size %u not whole records", LogName[Idx], (unsigned)f_size(&File));
+		Count = f_size(&File) / REC;
+		for (Seq = 0; Seq < Count; Seq++)
+		{
+			if (f_read(&File, Rec, REC, &Br) != FR_OK || Br != REC)
+				FAIL("%s: read record %u", LogName[Idx], (unsigned)Seq);
+			memcpy(&Crc, &Rec[REC_CRC], 2);
+			if (Crc != CRC16_Calc(CRC16_INIT, Rec, REC_CRC))
+				FAIL("%s: record %u bad CRC", LogName[Idx], (unsigned)Seq);
+			if (memcmp(&Rec[REC_SEQ], &Seq, 4) != 0 || Rec[REC_LOG] != Idx)
+				FAIL("%s: record %u out of sequence", LogName[Idx], (unsigned)Seq);
+		}
+		if (Chain(LogName[Idx], File.sclust, f_size(&File)))
+			return 1;
+		f_close(&File);
+	}
+
+	if (Count > Written[Idx])
+		FAIL("%s: %u records, %u written", LogName[Idx], (unsigned)Count, (unsigned)Written[Idx]);
+	if (Count + (Clean ? 0 : ALLOW) < Synced[Idx])
+		FAIL("%s: %u records, %u synced", LogName[Idx], (unsigned)Count, (unsigned)Synced[Idx]);
+	if (Synced[Idx] > Count && Synced[Idx] - Count > LostRec)
+		LostRec = Synced[Idx] - Count;
+	Written[Idx] = Synced[Idx] = Count;
+	return 0;
+}
+
+static uint8_t CheckOld(void)
+{
+	uint32_t Ofs, i;
+	FRESULT Res;
+	UINT Br;
+
+	Res = f_open(&File, "OLD.LOG", FA_READ);
+	if (Res == FR_NO_FILE)
+	{
+		if (OldState == OLD_PRESENT)
+			FAIL("OLD.LOG lost");
+		OldState = OLD_GONE;
+		return 0;
+	}
+	if (Res != FR_OK)
+		FAIL("OLD.LOG: open %u", Res);
+	if (OldState == OLD_GONE)
+		FAIL("OLD.LOG back after f_unlink");
+	if (f_size(&File) != OLD_SIZE)
+		FAIL("OLD.LOG: size %u", (unsigned)f_size(&File));
+	for (Ofs = 0; Ofs < OLD_SIZE; Ofs += sizeof(Buf))
+	{
+		if (f_read(&File, Buf, sizeof(Buf), &Br) != FR_OK || Br != sizeof(Buf))
+			FAIL("OLD.LOG: read at %u", (unsigned)Ofs);
+		for (i = 0; i < sizeof(Buf); i++)
+			if (Buf[i] != Pattern(Ofs + i))
+				FAIL("OLD.LOG: data at %u", (unsigned)(Ofs + i));
+	}
+	if (Chain("OLD.LOG", File.sclust, OLD_SIZE))
+		return 1;
+	f_close(&File);
+	OldState = OLD_PRESENT;
+	return 0;
+}
+
+static uint8_t Check(void)
+{
+	FILINFO Info;
+	DIR Dir;
+	DWORD Clust, Val, Lost = 0;
+	uint8_t l;
+
+	if (f_mount(NULL, TEST_DISK_Path, 0) != FR_OK || f_mount(&Fs, TEST_DISK_Path, 1) != FR_OK)
+		FAIL("mount");
+	pUsed = calloc(Fs.n_fatent, 1);
+
+	if (f_opendir(&Dir, "") != FR_OK)
+		FAIL("open root");
+	while (f_readdir(&Dir, &Info) == FR_OK && Info.fname[0] != 0)
+	{
+		if (strcmp(Info.fname, LogName[0]) != 0 && strcmp(Info.fname, LogName[1]) != 0
+			&& strcmp(Info.fname, "OLD.LOG") != 0)
+			FAIL("unexpected entry %s", Info.fname);
+	}
+	f_closedir(&Dir);
+
+	for (l = 0; l < LOGS; l++)
+		if (CheckLog(l))
+			return 1;
+	if (CheckOld())
+		return 1;
+
+	for (Clust = 2; Clust < Fs.n_fatent; Clust++)
+	{
+		Val = get_fat(&Fs, Clust);
+		if (Val == 0xFFFFFFFF)
+			FAIL("disk error in FAT");
+		if (Val != 0 && !pUsed[Clust])
+			Lost++;
+	}
+	if (Lost > LostClust)
+		LostClust = Lost;
+	free(pUsed);
+	pUsed = NULL;
+	return 0;
+}
+
+/*---------------------------------------------------------------------------*/
+
+static uint8_t Run(uint32_t Ops, uint32_t Seed)
+{
+	uint32_t Cut;
+
+	TEST_DISK_Restore();
+	TEST_OS_Tick = 0;
+	memset(Written, 0, sizeof(Written));
+	memset(Synced, 0, sizeof(Synced));
+	OldState = OLD_PRESENT;
+	Clean = FALSE;
+	Cut = 1 + Random(&Seed) % Ops;
+	TEST_DISK_Cut(Cut, Seed);
+
+	if (Work() == FR_OK || !TEST_DISK_IsCut())
+		FAIL("no power cut at op %u of %u", (unsigned)Cut, (unsigned)Ops);
+	TEST_DISK_PowerOn();
+	if (Check())
+		return 1;
+
+	// the volume takes new data, a clean unmount loses nothing
+	if (Work() != FR_OK)
+		FAIL("append after the cut");
+	if (f_mount(NULL, TEST_DISK_Path, 0) != FR_OK)
+		FAIL("unmount");
+	TEST_DISK_PowerOn();
+	Clean = TRUE;
+	return Check();
+}
+
+static uint8_t Fuzz(uint8_t Backend, uint32_t Runs, uint32_t Seed)
+{
+	uint32_t Ops, MaxLostRec = 0, MaxLostClust = 0, MaxExtra = 0, Fails = 0, i;
+	const char *pDisk = (Backend == TEST_DISK_FLASH) ? "flash" : "ram";
+
+	if (Setup(Backend))
+	{
+		printf("fuzz %s %s: %s\n", TEST_CONFIG, pDisk, Why);
+		return 1;
+	}
+
+	// ops of one uncut run
+	TEST_DISK_Restore();
+	OldState = OLD_PRESENT;
+	Ops = TEST_DISK_Ops();
+	if (Work() != FR_OK || f_mount(NULL, TEST_DISK_Path, 0) != FR_OK)
+	{
+		printf("fuzz %s %s: workload fails without a cut\n", TEST_CONFIG, pDisk);
+		return 1;
+	}
+	Ops = TEST_DISK_Ops() - Ops;
+
+	for (i = 0; i < Runs; i++)
+	{
+		LostRec = LostClust = ExtraClust = 0;
+		if (Run(Ops, Seed + i))
+		{
+			printf("fuzz %s %s seed %u: %s\n", TEST_CONFIG, pDisk, (unsigned)(Seed + i), Why);
+			Fails++;
+			continue;
+		}
+		if (LostRec > MaxLostRec)
+			MaxLostRec = LostRec;
+		if (LostClust > MaxLostClust)
+			MaxLostClust = LostClust;
+		if (ExtraClust > MaxExtra)
+			MaxExtra = ExtraClust;
+	}
+
+	printf("fuzz %-9s %-5s %u cuts in %u ops: %u failed, synced records lost max %u (allowed %u),"
+		" clusters lost max %u, past size max %u\n",
+		TEST_CONFIG, pDisk, (unsigned)Runs, (unsigned)Ops, (unsigned)Fails, (unsigned)MaxLostRec,
+		(unsigned)ALLOW, (unsigned)MaxLostClust, (unsigned)MaxExtra);
+	return Fails != 0;
+}
+
+int main(int argc, char **argv)
+{
+	uint32_t Runs = 300, Seed = 1;
+	uint8_t Fail = 0;
+
+	if (argc > 1)
+		Runs = strtoul(argv[1], NULL, 0);
+	if (argc > 2)
+		Seed = strtoul(argv[2], NULL, 0);
+
+	if (argc <= 3 || strcmp(argv[3], "ram") == 0)
+		Fail |= Fuzz(TEST_DISK_RAM, Runs, Seed);
+	if (argc <= 3 || strcmp(argv[3], "flash") == 0)
+		Fail |= Fuzz(TEST_DISK_FLASH, Runs, Seed);
+	return Fail;
+}
+
+/*****************************END OF FILE************************************/
@@ -0,0 +1,392 @@
+/**
+  ******************************************************************************
+  * File Name          : hit.c
+  * Description        : host test harness - hit response on the cycle stand-in
+  ******************************************************************************
+  * author: Tomas Krejci <info@tomaskrejci.com>
+  *
+  *	usage: hit [runs]
+  *	Runs the firmware hit path on the cycle stand-in of host_os.c, default
+  *	1001 runs a case: the IR RX EXTI callback (lasertag_ir.c) decodes a
+  *	shot packet edge by edge, posts to the FreeRTOS game queue (queue.c,
+  *	list.c) and the game task (lasertag_game.c) takes it on its own
+  *	context. The scheduler is cut down to the game task and the interrupt
+  *	context here: the task blocking on its queue switches back, a PendSV
+  *	set by the interrupt switches to it. Peripheral and SCB registers are
+  *	plain memory at their addresses.
+  *
+  *	Every hit kills (death sound, power phase), cases:
+  *	hit					the game task waits on an empty queue
+  *	shot + hit	the trigger interrupt comes just before the last edge, the
+  *							shot (IR TX start, sound) runs ahead of the hit
+  *	Per case, median of the runs (same path every run, the spread is host
+  *	noise): LASERTAG_GAME_Stats.HitLast as the firmware measures it (edge
+  *	time stamp to hit done), the longest masked span of the run (delays the
+  *	edge interrupt) and bound = masked + hit + the longest TIM15 sample
+  *	interrupts in that time, all in estimated M0 cycles, bound in us too.
+  *	Not modelled: exception entry and exit, PendSV and SysTick kernel work,
+  *	take them from an on-target trace (pc/trace2json.c).
+  *	Exit code 1 when a hit is lost.
+  ******************************************************************************
+  */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ucontext.h>
+#include <sys/mman.h>
+#include "main.h"
+#include "cmsis_os.h"
+#include "lasertag_setup.h"
+#include "lasertag_ir.h"
+#include "lasertag_game.h"
+#include "lasertag_audio.h"
+#include "lasertag_power.h"
+#include "host.h"
+
+#define		HIT_RUNS				1001
+#define		HIT_TRIES				10
+#define		HIT_STACK				0x10000
+// packet from player 2 of team 1, damage code 15 kills
+#define		HIT_PACKET			LASERTAG_IR_PACKET(2, 1, 15)
+// IR_TX_PULSE_CNT of lasertag_ir.c, TIM16 updates of one packet
+#define		HIT_TX_PULSES		(2 + 2 * LASERTAG_IR_BITS)
+// past respawn and reload deadlines
+#define		HIT_LATER_TICKS		(60000 / portTICK_PERIOD_MS)
+// TIM15 sample interrupt period [cycles], 8 kHz
+#define		HIT_SAMPLE_CYCLES	(CYCLES_PER_US * 125)
+
+typedef struct
+{
+	const char *pName;
+	uint8_t Trigger;
+} HIT_CaseTypeDef;
+
+static const HIT_CaseTypeDef HitCase[] =
+{
+	{ "hit",        FALSE },
+	{ "shot + hit", TRUE  },
+};
+
+uint32_t SystemCoreClock = 48000000;
+osThreadId audioTaskHandle;
+
+LASERTAG_SetupTypeDef LASERTAG_Setup =
+{
+	.Team = 0, .Player = 1, .Health = 100, .Ammo = 30, .RespawnTime = 50,
+	.DamageTable = { [15] = 100 }, .IrPower = 3, .IrCarrier = 56, .Volume = 200,
+};
+
+static ucontext_t IsrContext;
+static ucontext_t TaskContext;
+static ListItem_t TaskItem;					/* the game task on an event list */
+static QueueHandle_t GameQueue;
+static QueueHandle_t AudioQueue;
+
+/*---------------------------------------------------------------------------*/
+/* Scheduler and power stand-ins                                             */
+/*---------------------------------------------------------------------------*/
+
+QueueHandle_t __real_xQueueGenericCreateStatic(const UBaseType_t uxQueueLength, const UBaseType_t uxItemSize, uint8_t *pucQueueStorage, StaticQueue_t *pxStaticQueue, const uint8_t ucQueueType);
+
+/**		-Wl,--wrap, keeps the queues of the firmware modules
+*/
+QueueHandle_t __wrap_xQueueGenericCreateStatic(const UBaseType_t uxQueueLength, const UBaseType_t uxItemSize, uint8_t *pucQueueStorage, StaticQueue_t *pxStaticQueue, const uint8_t ucQueueType)
+{
+	QueueHandle_t Queue = __real_xQueueGenericCreateStatic(uxQueueLength, uxItemSize, pucQueueStorage, pxStaticQueue, ucQueueType);
+
+	if (uxItemSize == sizeof(LASERTAG_GAME_EventTypeDef))
+		GameQueue = Queue;
+	else
+		AudioQueue = Queue;
+	return Queue;
+}
+
+void vTaskSuspendAll(void)
+{
+}
+
+BaseType_t xTaskResumeAll(void)
+{
+	return pdFALSE;
+}
+
+void vTaskMissedYield(void)
+{
+}
+
+void vTaskSetTimeOutState(TimeOut_t * const pxTimeOut)
+{
+	pxTimeOut->xTimeOnEntering = TEST_OS_Tick;
+}
+
+BaseType_t xTaskCheckForTimeOut(TimeOut_t * const pxTimeOut, TickType_t * const pxTicksToWait)
+{
+	TickType_t Elapsed = TEST_OS_Tick - pxTimeOut->xTimeOnEntering;
+
+	if (*pxTicksToWait == portMAX_DELAY)
+		return pdFALSE;
+	if (Elapsed < *pxTicksToWait)
+	{
+		*pxTicksToWait -= Elapsed;
+		vTaskSetTimeOutState(pxTimeOut);
+		return pdFALSE;
+	}
+	return pdTRUE;
+}
+
+void vTaskPlaceOnEventList(List_t * const pxEventList, const TickType_t xTicksToWait)
+{
+	vListInsert(pxEventList, &TaskItem);
+}
+
+BaseType_t xTaskRemoveFromEventList(const List_t * const pxEventList)
+{
+	uxListRemove(&TaskItem);
+	return pdTRUE;
+}
+
+BaseType_t xTaskGetSchedulerState(void)
+{
+	return taskSCHEDULER_RUNNING;
+}
+
+/**		Audio task notification, not timed
+*/
+BaseType_t xTaskNotifyFromISR(TaskHandle_t xTaskToNotify, uint32_t ulValue, eNotifyAction eAction, BaseType_t *pxHigherPriorityTaskWoken)
+{
+	return pdPASS;
+}
+
+/**		Mutex paths of queue.c, no mutex here
+*/
+void vTaskPriorityInherit(TaskHandle_t const pxMutexHolder)
+{
+	abort();
+}
+
+BaseType_t xTaskPriorityDisinherit(TaskHandle_t const pxMutexHolder)
+{
+	abort();
+}
+
+void *pvTaskIncrementMutexHeldCount(void)
+{
+	return NULL;
+}
+
+/**		Game task blocks, back to the interrupt context
+*/
+void vPortYield(void)
+{
+	TEST_CYCLE_Hold();
+	swapcontext(&TaskContext, &IsrContext);
+	TEST_CYCLE_Resume();
+}
+
+void LASERTAG_POWER_Hold(uint32_t Hold)
+{
+}
+
+void LASERTAG_POWER_Release(uint32_t Hold)
+{
+}
+
+void LASERTAG_POWER_Phase(uint8_t Phase)
+{
+}
+
+/*---------------------------------------------------------------------------*/
+
+static void HIT_TaskEntry(void)
+{
+	TEST_CYCLE_Resume();
+	LASERTAG_GAME_Task(NULL);
+}
+
+static void HIT_RunTask(void)
+{
+	TEST_CYCLE_Hold();
+	swapcontext(&IsrContext, &TaskContext);
+	TEST_CYCLE_Resume();
+}
+
+/**		Interrupts done, PendSV switches to the game task
+*/
+static void HIT_PendSV(void)
+{
+	if (SCB->ICSR & SCB_ICSR_PENDSVSET_Msk)
+	{
+		SCB->ICSR &= ~SCB_ICSR_PENDSVSET_Msk;
+		HIT_RunTask();
+	}
+}
+
+/**		Deadline passed, the game task wakes on its queue timeout
+*/
+static void HIT_Timeout(TickType_t Ticks)
+{
+	TEST_OS_Tick += Ticks;
+	if (listLIST_ITEM_CONTAINER(&TaskItem) != NULL)
+		uxListRemove(&TaskItem);
+	HIT_RunTask();
+}
+
+static void HIT_Edge(uint8_t Level)
+{
+	if (Level)
+		IR_RX_GPIO_Port->IDR |= IR_RX_Pin;
+	else
+		IR_RX_GPIO_Port->IDR &= ~IR_RX_Pin;
+	LASERTAG_IR_EdgeCallback();
+}
+
+/**		Receiver output of a packet, Trigger = B1 interrupt before the last edge
+*/
+static void HIT_Packet(uint16_t Packet, uint8_t Trigger)
+{
+	uint8_t i;
+
+	for (i = 0; i <= LASERTAG_IR_BITS; i++)
+	{
+		HIT_Edge(0);
+		if (i == 0)
+			TEST_CYCLE_Wait(LASERTAG_IR_HEADER_US * CYCLES_PER_US);
+		else if (Packet & (1 << (LASERTAG_IR_BITS - i)))
+			TEST_CYCLE_Wait(LASERTAG_IR_ONE_US * CYCLES_PER_US);
+		else
+			TEST_CYCLE_Wait(LASERTAG_IR_ZERO_US * CYCLES_PER_US);
+		if (i == LASERTAG_IR_BITS && Trigger)
+			LASERTAG_GAME_TriggerCallback();
+		HIT_Edge(1);
+		HIT_PendSV();
+		TEST_CYCLE_Wait(LASERTAG_IR_SPACE_US * CYCLES_PER_US);
+	}
+}
+
+/**		Audio queue holds the death sound, emptied
+*/
+static uint8_t HIT_Dead(void)
+{
+	uint8_t Sound, Dead = FALSE;
+
+	while (xQueueReceive(AudioQueue, &Sound, 0) == pdPASS)
+		if (Sound == LASERTAG_SOUND_DEAD)
+			Dead = TRUE;
+	return Dead;
+}
+
+/**		Longest TIM15 sample interrupt, a half buffer notification included
+*/
+static uint32_t HIT_Sample(uint32_t Runs)
+{
+	uint32_t *pSpan = malloc(Runs * sizeof(uint32_t));
+	uint32_t Run, i, Start, Cycles, Floor, Max;
+
+	for (Run = 0; Run < Runs; Run++)
+	{
+		Start = TEST_CYCLE_Counter();
+		pSpan[Run] = TEST_CYCLE_Counter() - Start;
+	}
+	Floor = TEST_CYCLE_Median(pSpan, Runs);
+
+	for (Run = 0; Run < Runs; Run++)
+	{
+		Max = 0;
+		for (i = 0; i < 2 * LASERTAG_AUDIO_HALF; i++)
+		{
+			Start = TEST_CYCLE_Counter();
+			LASERTAG_AUDIO_SampleCallback();
+			Cycles = TEST_CYCLE_Counter() - Start;
+			if (Cycles > Max)
+				Max = Cycles;
+		}
+		pSpan[Run] = (Max > Floor) ? Max - Floor : 1;
+	}
+	Max = TEST_CYCLE_Median(pSpan, Runs);
+	free(pSpan);
+	return Max;
+}
+
+int main(int argc, char **argv)
+{
+	static uint8_t Stack[HIT_STACK];
+	uint32_t Runs = (argc > 1) ? strtoul(argv[1], NULL, 0) : HIT_RUNS;
+	uint32_t *pLatency, *pMasked, Run, c, Sample, Latency, Masked, Bound, Prev, i;
+	uint8_t Try, Fail = 0;
+
+	// peripheral registers, SCB
+	if (mmap((void *)PERIPH_BASE, AHB2PERIPH_BASE + 0x2000 - PERIPH_BASE, PROT_READ | PROT_WRITE,
+					 MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE | MAP_NORESERVE, -1, 0) != (void *)PERIPH_BASE
+		|| mmap((void *)SCS_BASE, 0x1000, PROT_READ | PROT_WRITE,
+					 MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE, -1, 0) != (void *)SCS_BASE)
+	{
+		fprintf(stderr, "hit: no register window\n");
+		return 1;
+	}
+	pLatency = malloc(Runs * sizeof(uint32_t));
+	pMasked = malloc(Runs * sizeof(uint32_t));
+	if (Runs == 0 || pLatency == NULL || pMasked == NULL)
+		return 1;
+
+	LASERTAG_IR_Init();
+	LASERTAG_GAME_Init();
+	LASERTAG_AUDIO_Init();
+	IR_RX_GPIO_Port->IDR |= IR_RX_Pin;
+	vListInitialiseItem(&TaskItem);
+	getcontext(&TaskContext);
+	TaskContext.uc_stack.ss_sp = Stack;
+	TaskContext.uc_stack.ss_size = sizeof(Stack);
+	TaskContext.uc_link = NULL;
+	makecontext(&TaskContext, HIT_TaskEntry, 0);
+
+	TEST_CYCLE_Calibrate();
+	HIT_RunTask();
+	Sample = HIT_Sample(Runs);
+
+	printf("%s, estimated M0 cycles, median of %u runs, sample interrupt %u\n", TEST_CONFIG, Runs, Sample);
+	printf("%-12s %9s %9s %9s %8s\n", "case", "hit", "masked", "bound", "[us]");
+	for (c = 0; c < sizeof(HitCase) / sizeof(HitCase[0]); c++)
+	{
+		for (Run = 0; Run < Runs && !Fail; Run++)
+		{
+			HIT_Timeout(HIT_LATER_TICKS);
+			HIT_Dead();
+
+			// a host interruption between two edges breaks the mark width
+			LASERTAG_GAME_Stats.HitCnt = 0;
+			TEST_CYCLE_Masked = 0;
+			for (Try = 0; Try < HIT_TRIES && LASERTAG_GAME_Stats.HitCnt == 0; Try++)
+				HIT_Packet(HIT_PACKET, HitCase[c].Trigger);
+			pLatency[Run] = LASERTAG_GAME_Stats.HitLast;
+			pMasked[Run] = TEST_CYCLE_Masked;
+			if (LASERTAG_GAME_Stats.HitCnt != 1 || !HIT_Dead())
+			{
+				fprintf(stderr, "hit: %s run %u, hit lost\n", HitCase[c].pName, Run);
+				Fail = 1;
+			}
+			if (HitCase[c].Trigger)
+				for (i = 0; i < HIT_TX_PULSES; i++)
+					LASERTAG_IR_TxTimerCallback();
+		}
+		if (Fail)
+			break;
+
+		// fixed point of masked + hit + sample interrupts in that time
+		Latency = TEST_CYCLE_Median(pLatency, Runs);
+		Masked = TEST_CYCLE_Median(pMasked, Runs);
+		Bound = Masked + Latency;
+		do
+		{
+			Prev = Bound;
+			Bound = Masked + Latency + (Prev / HIT_SAMPLE_CYCLES + 1) * Sample;
+		} while (Bound != Prev);
+
+		printf("%-12s %9u %9u %9u %8.1f\n", HitCase[c].pName, Latency, Masked, Bound,
+			(double)Bound / CYCLES_PER_US);
+	}
+	free(pMasked);
+	free(pLatency);
+	return Fail;
+}
+
+/*****************************END OF FILE************************************/
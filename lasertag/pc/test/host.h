@@ -0,0 +1,110 @@
+/**
+  ******************************************************************************
+  * File Name          : host.h
+  * Description        : host test harness - disk backends, flash model, OS stand-ins
+  ******************************************************************************
+  * author: Tomas Krejci <info@tomaskrejci.com>
+  *
+  *
+  ******************************************************************************
+  */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __TEST_HOST_H
+#define __TEST_HOST_H
+
+#include <stdint.h>
+#include "ff.h"
+
+/**		Firmware code under test is built unchanged: ff.c, diskio.c, ff_gen_drv.c,
+			user_diskio.c, ftl.c, mem_fast.c, common.c (CRC16).
+
+			Disk backends, both with the geometry of the log volume (FTL_SECTORS):
+			TEST_DISK_RAM		sectors in host RAM, no translation
+			TEST_DISK_FLASH	firmware USER_Driver -> ftl.c -> S25FL164K model
+			Every sector transfer is counted at the driver (TEST_DISK_Stats).
+
+			Flash model: 8 MB NOR, program only clears bits, 4 KB sector erase.
+			Time is simulated from typical timing, the host runs at full speed
+			unless TEST_DISK_RealTime is set (threaded tests).
+			Power cut: TEST_DISK_Cut(n) lets n more page programs or erases run,
+			the last one is torn (random prefix applied), every flash access after
+			it fails until TEST_DISK_PowerOn. On the RAM disk the cut falls between
+			two sector writes.
+			TEST_DISK_EraseBlock replaces the GET_BLOCK_SIZE answer of both backends
+			(sectors, 0 = FTL_BLOCK_SECTORS), 1 formats without the f_mkfs alignment.
+*/
+#define		TEST_DISK_RAM					0
+#define		TEST_DISK_FLASH				1
+
+#define		TEST_FLASH_SIZE				0x800000
+#define		TEST_FLASH_PAGE				0x100
+#define		TEST_FLASH_SECTOR			0x1000
+
+// model timing [us], typical values, 12 MHz SPI
+#define		TEST_FLASH_T_PAGE			700
+#define		TEST_FLASH_T_ERASE		50000
+#define		TEST_FLASH_T_CMD			3
+
+typedef struct
+{
+	uint32_t ReadCall;				/*!< disk_read calls */
+	uint32_t ReadSector;			/*!< sectors read */
+	uint32_t WriteCall;				/*!< disk_write calls */
+	uint32_t WriteSector;			/*!< sectors written */
+	uint32_t Sync;						/*!< CTRL_SYNC */
+	uint32_t FlashRead;				/*!< bytes read from flash */
+	uint32_t FlashPage;				/*!< page programs */
+	uint32_t FlashErase;			/*!< sector erases */
+	uint64_t FlashTime;				/*!< simulated flash busy time [us] */
+} TEST_DISK_StatsTypeDef;
+
+extern TEST_DISK_StatsTypeDef TEST_DISK_Stats;
+extern char TEST_DISK_Path[4];
+extern uint32_t TEST_DISK_RealTime;
+extern uint32_t TEST_DISK_EraseBlock;
+
+void     TEST_DISK_Init(uint8_t Backend);
+void     TEST_DISK_Reset(void);
+uint32_t TEST_DISK_Ops(void);
+void     TEST_DISK_Cut(uint32_t Ops, uint32_t Seed);
+uint8_t  TEST_DISK_IsCut(void);
+void     TEST_DISK_PowerOn(void);
+void     TEST_DISK_Save(void);
+void     TEST_DISK_Restore(void);
+
+/**		OS stand-ins: RTOS tick = simulated ms advanced by the workload (lazy
+			sync thresholds), volume lock = FIFO ticket lock, so the yield at a
+			cluster boundary hands the volume to the waiting thread as
+			ff_yield_grant (option/syscall.c) does for a task of any priority.
+*/
+extern volatile uint32_t TEST_OS_Tick;
+
+uint64_t TEST_OS_Us(void);
+
+/**		Cycle stand-in, CYCLE_COUNTER of host builds (host_cm0.h): host time
+			stamp counter scaled to Cortex-M0 cycles, plus the simulated flash time
+			(TEST_DISK_Stats.FlashTime) and TEST_CYCLE_Wait at CYCLES_PER_US.
+			TEST_CYCLE_Calibrate sets the scale from a loop of known M0 cost
+			(9 cycles a pass: LDR, ADDS, STR, SUBS, BNE). An estimate to compare
+			runs and spot regressions, not a cycle count: the host gains on
+			arithmetic, loses nothing on wait states.
+			Interrupt masking (PRIMASK save/set, critical sections) is timed on
+			the same clock, the stand-ins take their own time off the counter,
+			the median span of an empty section is subtracted (1 = at or under
+			it). TEST_CYCLE_Masked = longest masked span, clear it to start.
+			Host work between TEST_CYCLE_Hold and TEST_CYCLE_Resume (a harness
+			switching contexts) is taken off the counter as well.
+*/
+extern uint32_t TEST_CYCLE_Masked;
+
+void     TEST_CYCLE_Calibrate(void);
+double   TEST_CYCLE_Scale(void);
+uint32_t TEST_CYCLE_Counter(void);
+void     TEST_CYCLE_Wait(uint32_t Cycles);
+uint32_t TEST_CYCLE_Median(uint32_t *pValue, uint32_t Cnt);
+void     TEST_CYCLE_Hold(void);
+void     TEST_CYCLE_Resume(void);
+
+#endif /* __TEST_HOST_H */
+
+/*****************************END OF FILE************************************/
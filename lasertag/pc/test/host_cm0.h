@@ -0,0 +1,42 @@
+/**
+  ******************************************************************************
+  * File Name          : host_cm0.h
+  * Description        : host test harness - Cortex-M0 core stand-ins
+  ******************************************************************************
+  * author: Tomas Krejci <info@tomaskrejci.com>
+  *
+  *	Forced in (-include) with -D__CMSIS_GCC_H when firmware sources that use
+  *	core functions are built for the host (make cycles, make pool). Replaces
+  *	the cmsis_gcc.h inline assembler: thread mode, PRIMASK reads 0, barriers
+  *	and sleep do nothing. CYCLE_COUNTER is the host stand-in of host_os.c.
+  ******************************************************************************
+  */
+/* Define to prevent recursive inclusion -------------------------------------*/
+#ifndef __TEST_HOST_CM0_H
+#define __TEST_HOST_CM0_H
+
+#include <stdint.h>
+
+#define __ASM										__asm
+#define __INLINE								inline
+#define __STATIC_INLINE					static inline
+
+#define CYCLE_COUNTER()					TEST_CYCLE_Counter()
+
+uint32_t TEST_CYCLE_Counter(void);
+
+static inline uint32_t __get_IPSR(void)					{ return 0; }
+static inline uint32_t __get_PRIMASK(void)			{ return 0; }
+static inline void __set_PRIMASK(uint32_t Mask)	{ }
+static inline void __disable_irq(void)					{ }
+static inline void __enable_irq(void)						{ }
+static inline void __DSB(void)									{ }
+static inline void __DMB(void)									{ }
+static inline void __ISB(void)									{ }
+static inline void __NOP(void)									{ }
+static inline void __WFI(void)									{ }
+static inline uint32_t __REV(uint32_t Value)		{ return __builtin_bswap32(Value); }
+
+#endif /* __TEST_HOST_CM0_H */
+
+/*****************************END OF FILE************************************/
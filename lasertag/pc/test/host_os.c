@@ -0,0 +1,292 @@
+/**
+  ******************************************************************************
+  * File Name          : host_os.c
+  * Description        : host test harness - RTOS, HAL and FatFs syscall stand-ins
+  ******************************************************************************
+  * author: Tomas Krejci <info@tomaskrejci.com>
+  *
+  *
+  ******************************************************************************
+  */
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <time.h>
+#include <x86intrin.h>
+#include "FreeRTOS.h"
+#include "task.h"
+#include "common.h"
+#include "host.h"
+
+// TEST_CYCLE_Calibrate reference loop
+#define		CALIB_PASSES		1000000
+#define		CALIB_CYCLES		9					/* M0 cycles a pass */
+#define		CALIB_RUNS			10
+#define		CALIB_SPANS			1001			/* empty masked spans */
+
+typedef struct
+{
+	pthread_mutex_t Mutex;
+	pthread_cond_t  Cond;
+	uint32_t        Next;			/*!< next ticket */
+	uint32_t        Serve;		/*!< ticket holding the volume */
+} TEST_OS_LockTypeDef;
+
+volatile uint32_t TEST_OS_Tick;
+
+static TEST_OS_LockTypeDef OsLock[_VOLUMES];
+
+uint32_t TEST_CYCLE_Masked;
+
+static uint64_t CycleBase;
+static uint64_t CyclePaused;				/* host ticks spent in the mask stand-ins */
+static double   CycleScale = 1.0;		/* M0 cycles per host tick */
+static uint64_t CycleHeld;
+static uint32_t CycleWaited;
+static uint32_t MaskDepth;
+static uint32_t MaskStart;
+static uint32_t MaskFloor;					/* empty masked span */
+
+
+static void TEST_OS_Unused(const char *pName)
+{
+	fprintf(stderr, "%s called on host\n", pName);
+	abort();
+}
+
+uint64_t TEST_OS_Us(void)
+{
+	struct timespec Now;
+
+	clock_gettime(CLOCK_MONOTONIC, &Now);
+	return (uint64_t)Now.tv_sec * 1000000 + Now.tv_nsec / 1000;
+}
+
+/*---------------------------------------------------------------------------*/
+/* Cycle stand-in                                                            */
+/*---------------------------------------------------------------------------*/
+
+static int TEST_CYCLE_Compare(const void *pA, const void *pB)
+{
+	uint32_t A = *(const uint32_t *)pA, B = *(const uint32_t *)pB;
+
+	return (A > B) - (A < B);
+}
+
+/**		Median of Cnt values, sorts them
+*/
+uint32_t TEST_CYCLE_Median(uint32_t *pValue, uint32_t Cnt)
+{
+	qsort(pValue, Cnt, sizeof(*pValue), TEST_CYCLE_Compare);
+	return pValue[Cnt / 2];
+}
+
+void TEST_CYCLE_Calibrate(void)
+{
+	static volatile uint32_t Sink;
+	static uint32_t Span[CALIB_SPANS];
+	uint64_t Start, Ticks, Best = ~0ULL;
+	uint32_t Run, i;
+
+	for (Run = 0; Run < CALIB_RUNS; Run++)
+	{
+		Start = __rdtsc();
+		for (i = CALIB_PASSES; i > 0; i--)
+			Sink += i;
+		Ticks = __rdtsc() - Start;
+		if (Ticks < Best)
+			Best = Ticks;
+	}
+	CycleScale = (double)CALIB_PASSES * CALIB_CYCLES / Best;
+	CycleBase = __rdtsc();
+	CyclePaused = 0;
+
+	MaskFloor = 0;
+	for (Run = 0; Run < CALIB_SPANS; Run++)
+	{
+		TEST_CYCLE_Masked = 0;
+		vPortEnterCritical();
+		vPortExitCritical();
+		Span[Run] = TEST_CYCLE_Masked;
+	}
+	MaskFloor = TEST_CYCLE_Median(Span, CALIB_SPANS);
+	TEST_CYCLE_Masked = 0;
+}
+
+double TEST_CYCLE_Scale(void)
+{
+	return CycleScale;
+}
+
+uint32_t TEST_CYCLE_Counter(void)
+{
+	return (uint32_t)((__rdtsc() - CycleBase - CyclePaused) * CycleScale)
+		+ (uint32_t)TEST_DISK_Stats.FlashTime * CYCLES_PER_US + CycleWaited;
+}
+
+/**		Simulated peripheral time, e.g. SPI transfers
+*/
+void TEST_CYCLE_Wait(uint32_t Cycles)
+{
+	CycleWaited += Cycles;
+}
+
+/**		Host-only work, e.g. a context switch of the harness
+*/
+void TEST_CYCLE_Hold(void)
+{
+	CycleHeld = __rdtsc();
+}
+
+void TEST_CYCLE_Resume(void)
+{
+	CyclePaused += __rdtsc() - CycleHeld;
+}
+
+/**		The time in here is taken off the counter, the code around sees only
+			its own masked span
+*/
+static void TEST_CYCLE_MaskBegin(void)
+{
+	uint64_t Enter = __rdtsc();
+
+	if (MaskDepth++ == 0)
+		MaskStart = TEST_CYCLE_Counter();
+	CyclePaused += __rdtsc() - Enter;
+}
+
+static void TEST_CYCLE_MaskEnd(void)
+{
+	uint64_t Enter = __rdtsc();
+	int32_t Cycles;
+
+	// the stand-in time is taken off after MaskStart, an empty span can
+	// come out below it
+	if (MaskDepth != 0 && --MaskDepth == 0)
+	{
+		Cycles = (int32_t)(TEST_CYCLE_Counter() - MaskStart);
+		Cycles = (Cycles > (int32_t)MaskFloor) ? Cycles - (int32_t)MaskFloor : 1;
+		if ((uint32_t)Cycles > TEST_CYCLE_Masked)
+			TEST_CYCLE_Masked = Cycles;
+	}
+	CyclePaused += __rdtsc() - Enter;
+}
+
+/**		port.c, interrupts masked by PRIMASK on the target
+*/
+uint32_t ulSetInterruptMaskFromISR(void)
+{
+	TEST_CYCLE_MaskBegin();
+	return 0;
+}
+
+void vClearInterruptMaskFromISR(uint32_t ulMask)
+{
+	TEST_CYCLE_MaskEnd();
+}
+
+void vPortEnterCritical(void)
+{
+	TEST_CYCLE_MaskBegin();
+}
+
+void vPortExitCritical(void)
+{
+	TEST_CYCLE_MaskEnd();
+}
+
+/*---------------------------------------------------------------------------*/
+/* RTOS and HAL                                                              */
+/*---------------------------------------------------------------------------*/
+
+/**		_FS_LAZYSYNC_TICK
+*/
+TickType_t xTaskGetTickCount(void)
+{
+	return TEST_OS_Tick;
+}
+
+/**		common.c references, not reached by the code under test
+*/
+void HAL_Delay(uint32_t Delay)
+{
+	TEST_OS_Unused("HAL_Delay");
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+	TEST_OS_Unused("xTaskGetCurrentTaskHandle");
+	return NULL;
+}
+
+BaseType_t xTaskGenericNotify(TaskHandle_t xTaskToNotify, uint32_t ulValue, eNotifyAction eAction, uint32_t *pulPreviousNotificationValue)
+{
+	TEST_OS_Unused("xTaskGenericNotify");
+	return pdFALSE;
+}
+
+BaseType_t xTaskNotifyWait(uint32_t ulBitsToClearOnEntry, uint32_t ulBitsToClearOnExit, uint32_t *pulNotificationValue, TickType_t xTicksToWait)
+{
+	TEST_OS_Unused("xTaskNotifyWait");
+	return pdFALSE;
+}
+
+/**		fatfs.c
+*/
+DWORD get_fattime(void)
+{
+	return 0;
+}
+
+/**		option/syscall.c - FIFO ticket lock per volume
+*/
+int ff_cre_syncobj(BYTE vol, _SYNC_t *sobj)
+{
+	TEST_OS_LockTypeDef *pLock = &OsLock[vol];
+
+	pthread_mutex_init(&pLock->Mutex, NULL);
+	pthread_cond_init(&pLock->Cond, NULL);
+	pLock->Next = pLock->Serve = 0;
+	*sobj = pLock;
+	return 1;
+}
+
+int ff_del_syncobj(_SYNC_t sobj)
+{
+	return 1;
+}
+
+int ff_req_grant(_SYNC_t sobj)
+{
+	TEST_OS_LockTypeDef *pLock = sobj;
+	uint32_t Ticket;
+
+	pthread_mutex_lock(&pLock->Mutex);
+	Ticket = pLock->Next++;
+	while (Ticket != pLock->Serve)
+		pthread_cond_wait(&pLock->Cond, &pLock->Mutex);
+	pthread_mutex_unlock(&pLock->Mutex);
+	return 1;
+}
+
+void ff_rel_grant(_SYNC_t sobj)
+{
+	TEST_OS_LockTypeDef *pLock = sobj;
+
+	pthread_mutex_lock(&pLock->Mutex);
+	pLock->Serve++;
+	pthread_cond_broadcast(&pLock->Cond);
+	pthread_mutex_unlock(&pLock->Mutex);
+}
+
+#if _FS_YIELD
+/**		Waiting threads hold older tickets and get the volume first
+*/
+int ff_yield_grant(_SYNC_t sobj)
+{
+	ff_rel_grant(sobj);
+	return ff_req_grant(sobj);
+}
+#endif
+
+/*****************************END OF FILE************************************/
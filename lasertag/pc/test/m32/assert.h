@@ -0,0 +1,2 @@
+/* "make ram": declarations of the MicroLIB calls the firmware makes, the i386
+   objects are built -nostdinc (no 32 bit libc needed) */
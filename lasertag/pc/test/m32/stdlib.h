@@ -0,0 +1,4 @@
+/* "make ram": declarations of the MicroLIB calls the firmware makes, the i386
+   objects are built -nostdinc (no 32 bit libc needed) */
+#include <stddef.h>
+void *malloc(size_t); void free(void *); int abs(int);
@@ -0,0 +1,6 @@
+/* "make ram": declarations of the MicroLIB calls the firmware makes, the i386
+   objects are built -nostdinc (no 32 bit libc needed) */
+#include <stddef.h>
+void *memcpy(void *, const void *, size_t); void *memset(void *, int, size_t); int memcmp(const void *, const void *, size_t);
+void *memmove(void *, const void *, size_t); void *memchr(const void *, int, size_t); size_t strlen(const char *);
+char *strncpy(char *, const char *, size_t); char *strcpy(char *, const char *); int strcmp(const char *, const char *); int strncmp(const char*,const char*,size_t);
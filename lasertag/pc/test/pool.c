@@ -0,0 +1,142 @@
+/**
+  ******************************************************************************
+  * File Name          : pool.c
+  * Description        : host test harness - osPool interrupt masked time
+  ******************************************************************************
+  * author: Tomas Krejci <info@tomaskrejci.com>
+  *
+  *	usage: pool
+  *	Times the interrupt masked span of osPoolAlloc and osPoolFree of the
+  *	firmware cmsis_os.c (or another one, make pool POOL_OS=<dir>) on the
+  *	cycle stand-in of host_os.c, pools of 4, 16 and 64 blocks:
+  *	alloc first		all blocks free
+  *	alloc empty		no block free, a scanning pool looks at every block
+  *	free					one block back
+  *	Each path runs POOL_RUNS times, the median span is printed (estimated M0
+  *	cycles, host interruptions left out), "-" = nothing masked. A double
+  *	free of the last freed block must be refused.
+  ******************************************************************************
+  */
+#include <stdio.h>
+#include <stdlib.h>
+#include "cmsis_os.h"
+#include "common.h"
+#include "host.h"
+
+#define		POOL_RUNS			1001
+#define		POOL_MAX			64
+
+// blocks hold the free list link
+#ifdef osPoolStaticDef
+#define		POOL_DEF(name, no)		osPoolStaticDef(name, no, void *)
+#else
+#define		POOL_DEF(name, no)		osPoolDef(name, no, void *)
+#endif
+
+POOL_DEF(Pool4, 4);
+POOL_DEF(Pool16, 16);
+POOL_DEF(Pool64, 64);
+
+typedef enum
+{
+	POOL_ALLOC_FIRST,
+	POOL_ALLOC_EMPTY,
+	POOL_FREE,
+} POOL_PathTypeDef;
+
+static void *Block[POOL_MAX];
+
+
+/**		Pools without static allocation take the heap
+*/
+void *pvPortMalloc(size_t xSize)
+{
+	return malloc(xSize);
+}
+
+void vPortFree(void *pv)
+{
+	free(pv);
+}
+
+/**		Median masked span of one path [estimated cycles], 0 = not masked
+*/
+static uint32_t Path(osPoolId Id, uint32_t Size, POOL_PathTypeDef Type)
+{
+	static uint32_t Span[POOL_RUNS];
+	uint32_t Run, i;
+	void *pBlock;
+
+	for (Run = 0; Run < POOL_RUNS; Run++)
+	{
+		for (i = 0; i < Size; i++)
+			Block[i] = osPoolAlloc(Id);
+		if (Type == POOL_ALLOC_FIRST)
+			osPoolFree(Id, Block[0]);
+		if (Type != POOL_FREE)
+		{
+			TEST_CYCLE_Masked = 0;
+			pBlock = osPoolAlloc(Id);
+			if (pBlock != NULL)
+				Block[0] = pBlock;
+		}
+		else
+		{
+			osPoolFree(Id, Block[1]);
+			TEST_CYCLE_Masked = 0;
+			osPoolFree(Id, Block[0]);
+			Block[0] = Block[1] = NULL;
+		}
+		Span[Run] = TEST_CYCLE_Masked;
+
+		for (i = 0; i < Size; i++)
+			if (Block[i] != NULL)
+				osPoolFree(Id, Block[i]);
+	}
+	return TEST_CYCLE_Median(Span, POOL_RUNS);
+}
+
+static void Print(uint32_t Cycles)
+{
+	if (Cycles)
+		printf(" %7u %6.2f", Cycles, (double)Cycles / CYCLES_PER_US);
+	else
+		printf(" %7s %6s", "-", "-");
+}
+
+int main(void)
+{
+	const osPoolDef_t *pDef[] = { osPool(Pool4), osPool(Pool16), osPool(Pool64) };
+	uint8_t Fail = 0;
+	uint32_t p;
+
+	TEST_CYCLE_Calibrate();
+	printf("estimated M0 cycles / us masked, median of %u runs\n", POOL_RUNS);
+	printf("%6s %14s %14s %14s\n", "blocks", "alloc first", "alloc empty", "free");
+	for (p = 0; p < sizeof(pDef) / sizeof(pDef[0]); p++)
+	{
+		osPoolId Id = osPoolCreate(pDef[p]);
+		void *pBlock;
+
+		if (Id == NULL)
+		{
+			fprintf(stderr, "pool: no pool of %u\n", pDef[p]->pool_sz);
+			return 1;
+		}
+		printf("%6u", pDef[p]->pool_sz);
+		Print(Path(Id, pDef[p]->pool_sz, POOL_ALLOC_FIRST));
+		Print(Path(Id, pDef[p]->pool_sz, POOL_ALLOC_EMPTY));
+		Print(Path(Id, pDef[p]->pool_sz, POOL_FREE));
+		printf("\n");
+
+		pBlock = osPoolAlloc(Id);
+		if (osPoolFree(Id, pBlock) != osOK || osPoolFree(Id, pBlock) == osOK)
+		{
+			fprintf(stderr, "pool: double free of %u block pool not refused\n", pDef[p]->pool_sz);
+			Fail = 1;
+		}
+	}
+	return Fail;
+}
+
+/*****************************END OF FILE************************************/
@@ -0,0 +1,397 @@
+/**
+  ******************************************************************************
+  * File Name          : stack.c
+  * Description        : worst case stack depth from gcc call graph files
+  ******************************************************************************
+  * author: Tomas Krejci <info@tomaskrejci.com>
+  *
+  *	usage: stack <stack.txt> <file.ci>...
+  *
+  *	Reads the -fcallgraph-info=su output of the firmware sources (make ram)
+  *	and sums the frames along the deepest call path of each stack described
+  *	in stack.txt:
+  *
+  *	call <caller> <callee>...			targets of the indirect calls in caller
+  *	size <function> <bytes>				frame of a function without call graph
+  *																(assembler, library)
+  *	stack <name> <bytes> <term>...	one stack of <bytes> (0 = not allocated),
+  *																need = sum of terms, a term is
+  *																[<bytes>+]<root>[|<root>...] = bytes plus
+  *																the deepest of the roots, or <bytes>
+  *
+  *	Frames are the host (i386 -Os) ones, the report is an estimate of the
+  *	ARMCC frames, see the notes in stack.txt.
+  ******************************************************************************
+  */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_FUNC			4096
+#define MAX_EDGE			16384
+#define MAX_NAME			160
+#define MAX_LINE			1024
+
+typedef struct
+{
+	char Name[MAX_NAME];		/*!< call graph title, "file:name" for static ones */
+	int  Frame;							/*!< own frame [B], -1 unknown */
+	int  Dynamic;						/*!< frame not static (alloca, VLA) */
+	int  First;							/*!< first edge */
+	int  Depth;							/*!< deepest path [B], -1 not done */
+	int  Next;							/*!< callee on the deepest path, -1 none */
+	int  Busy;							/*!< on the walk, recursion check */
+	int  Recursive;
+	int  Resolved;					/*!< indirect calls listed in stack.txt */
+	int  Unresolved;				/*!< indirect call not listed, not counted */
+} FuncTypeDef;
+
+typedef struct
+{
+	int To;
+	int Next;
+} EdgeTypeDef;
+
+static FuncTypeDef Func[MAX_FUNC];
+static EdgeTypeDef Edge[MAX_EDGE];
+static int FuncCnt, EdgeCnt;
+static int Indirect;
+
+
+static int Find(const char *pName, int Add)
+{
+	int i;
+
+	for (i = 0; i < FuncCnt; i++)
+		if (strcmp(Func[i].Name, pName) == 0)
+			return i;
+
+	if (!Add)
+		return -1;
+	if (FuncCnt == MAX_FUNC)
+	{
+		fprintf(stderr, "stack: too many functions\n");
+		exit(1);
+	}
+
+	strncpy(Func[FuncCnt].Name, pName, MAX_NAME - 1);
+	Func[FuncCnt].Frame = -1;
+	Func[FuncCnt].First = -1;
+	Func[FuncCnt].Depth = -1;
+	Func[FuncCnt].Next = -1;
+	return FuncCnt++;
+}
+
+/**		Function by plain name, static ones match "file:name" too
+*/
+static int FindName(const char *pName)
+{
+	int i, Len = strlen(pName);
+	int Res = Find(pName, 0);
+
+	if (Res >= 0)
+		return Res;
+
+	for (i = 0; i < FuncCnt; i++)
+	{
+		int NameLen = strlen(Func[i].Name);
+
+		if (NameLen > Len && Func[i].Name[NameLen - Len - 1] == ':'
+				&& strcmp(Func[i].Name + NameLen - Len, pName) == 0)
+			return i;
+	}
+	return -1;
+}
+
+static void AddEdge(int From, int To)
+{
+	int e;
+
+	for (e = Func[From].First; e >= 0; e = Edge[e].Next)
+		if (Edge[e].To == To)
+			return;
+
+	if (EdgeCnt == MAX_EDGE)
+	{
+		fprintf(stderr, "stack: too many calls\n");
+		exit(1);
+	}
+
+	Edge[EdgeCnt].To = To;
+	Edge[EdgeCnt].Next = Func[From].First;
+	Func[From].First = EdgeCnt++;
+}
+
+// value of key: "..." in a call graph line
+static int Field(const char *pLine, const char *pKey, char *pOut)
+{
+	const char *p = strstr(pLine, pKey);
+	int Len = 0;
+
+	if (p == NULL)
+		return 0;
+
+	p += strlen(pKey);
+	while (*p != '\0' && *p != '"' && Len < MAX_NAME - 1)
+		pOut[Len++] = *p++;
+	pOut[Len] = '\0';
+	return 1;
+}
+
+static void ReadGraph(const char *pFile)
+{
+	char Line[MAX_LINE], Title[MAX_NAME], Label[MAX_NAME], To[MAX_NAME];
+	FILE *f = fopen(pFile, "r");
+
+	if (f == NULL)
+	{
+		perror(pFile);
+		exit(1);
+	}
+
+	while (fgets(Line, sizeof(Line), f) != NULL)
+	{
+		if (strncmp(Line, "node:", 5) == 0 && Field(Line, "title: \"", Title)
+				&& Field(Line, "label: \"", Label))
+		{
+			int i = Find(Title, 1);
+			const char *p = strstr(Line, " bytes (");
+
+			// frame only where the function is compiled
+			if (p != NULL)
+			{
+				while (p > Line && p[-1] >= '0' && p[-1] <= '9')
+					p--;
+				Func[i].Frame = atoi(p);
+				Func[i].Dynamic = strstr(p, "(static)") == NULL;
+			}
+		}
+		else if (strncmp(Line, "edge:", 5) == 0 && Field(Line, "sourcename: \"", Title)
+						 && Field(Line, "targetname: \"", To))
+			AddEdge(Find(Title, 1), Find(To, 1));
+	}
+	fclose(f);
+}
+
+static int Walk(int f)
+{
+	int e, Best = 0;
+
+	if (Func[f].Depth >= 0)
+		return Func[f].Depth;
+	if (Func[f].Busy)
+	{
+		Func[f].Recursive = 1;
+		return 0;
+	}
+
+	Func[f].Busy = 1;
+	for (e = Func[f].First; e >= 0; e = Edge[e].Next)
+	{
+		int d;
+
+		if (Edge[e].To == Indirect)
+		{
+			Func[f].Unresolved = !Func[f].Resolved;
+			continue;
+		}
+
+		d = Walk(Edge[e].To);
+		if (d > Best || Func[f].Next < 0)
+		{
+			Best = d;
+			Func[f].Next = Edge[e].To;
+		}
+	}
+	Func[f].Busy = 0;
+
+	Func[f].Depth = (Func[f].Frame > 0 ? Func[f].Frame : 0) + Best;
+	return Func[f].Depth;
+}
+
+static void Path(int f)
+{
+	for (; f >= 0; f = Func[f].Next)
+	{
+		const char *pName = strrchr(Func[f].Name, ':');
+
+		printf("    %5d %s%s%s%s%s\n", Func[f].Depth, pName ? pName + 1 : Func[f].Name,
+					 Func[f].Frame < 0 ? " (no frame)" : "", Func[f].Dynamic ? " (dynamic)" : "",
+					 Func[f].Recursive ? " (recursive)" : "",
+					 Func[f].Unresolved ? " (indirect call not counted)" : "");
+		if (Func[f].Depth == (Func[f].Frame > 0 ? Func[f].Frame : 0))
+			break;
+	}
+}
+
+/**		One term: [bytes+]root[|root...], returns bytes, *pRoot deepest root
+*/
+static int Term(char *pTerm, int *pRoot)
+{
+	char *pPlus = strchr(pTerm, '+');
+	char *pName;
+	int Res = 0, Best = -1;
+
+	*pRoot = -1;
+	if (pPlus != NULL)
+	{
+		*pPlus = '\0';
+		Res = atoi(pTerm);
+		pTerm = pPlus + 1;
+	}
+	else if (*pTerm >= '0' && *pTerm <= '9')
+		return atoi(pTerm);
+
+	for (pName = strtok(pTerm, "|"); pName != NULL; pName = strtok(NULL, "|"))
+	{
+		int f = FindName(pName);
+
+		if (f < 0)
+		{
+			fprintf(stderr, "stack: no function %s\n", pName);
+			exit(1);
+		}
+		if (Walk(f) > Best)
+		{
+			Best = Func[f].Depth;
+			*pRoot = f;
+		}
+	}
+	return Res + (Best > 0 ? Best : 0);
+}
+
+static void Stacks(const char *pFile)
+{
+	char Line[MAX_LINE];
+	FILE *f = fopen(pFile, "r");
+	int Bad = 0;
+
+	if (f == NULL)
+	{
+		perror(pFile);
+		exit(1);
+	}
+
+	printf("%-10s %6s %6s %6s\n", "stack", "size", "need", "free");
+	while (fgets(Line, sizeof(Line), f) != NULL)
+	{
+		char *pWord[32];
+		int Cnt = 0, i, Need = 0, Size;
+		char *p;
+
+		if ((p = strchr(Line, '#')) != NULL)
+			*p = '\0';
+		for (p = strtok(Line, " \t\r\n"); p != NULL && Cnt < 32; p = strtok(NULL, " \t\r\n"))
+			pWord[Cnt++] = p;
+		if (Cnt < 3 || strcmp(pWord[0], "stack") != 0)
+			continue;
+
+		// strtok of the terms below reuses the line buffer, copy the terms
+		Size = atoi(pWord[2]);
+		{
+			char Terms[32][MAX_LINE];
+			int Root[32], Part[32];
+
+			for (i = 3; i < Cnt; i++)
+				strncpy(Terms[i], pWord[i], MAX_LINE - 1), Terms[i][MAX_LINE - 1] = '\0';
+			for (i = 3; i < Cnt; i++)
+			{
+				Part[i] = Term(Terms[i], &Root[i]);
+				Need += Part[i];
+			}
+
+			if (Size > 0)
+				printf("%-10s %6d %6d %6d%s\n", pWord[1], Size, Need, Size - Need,
+							 Need > Size ? "  OVERFLOW" : "");
+			else
+				printf("%-10s %6s %6d\n", pWord[1], "-", Need);
+			for (i = 3; i < Cnt; i++)
+			{
+				printf("  %5d  %s\n", Part[i], Root[i] >= 0 ? Func[Root[i]].Name : "(fixed)");
+				if (Root[i] >= 0)
+					Path(Root[i]);
+			}
+			Bad |= Size > 0 && Need > Size;
+		}
+	}
+	fclose(f);
+
+	if (Bad)
+		exit(2);
+}
+
+/**		call and size lines, before the walk
+*/
+static void Config(const char *pFile)
+{
+	char Line[MAX_LINE];
+	FILE *f = fopen(pFile, "r");
+
+	if (f == NULL)
+	{
+		perror(pFile);
+		exit(1);
+	}
+
+	while (fgets(Line, sizeof(Line), f) != NULL)
+	{
+		char *pWord[32];
+		int Cnt = 0, i, From;
+		char *p;
+
+		if ((p = strchr(Line, '#')) != NULL)
+			*p = '\0';
+		for (p = strtok(Line, " \t\r\n"); p != NULL && Cnt < 32; p = strtok(NULL, " \t\r\n"))
+			pWord[Cnt++] = p;
+		if (Cnt < 3)
+			continue;
+
+		if (strcmp(pWord[0], "size") == 0)
+		{
+			From = FindName(pWord[1]);
+			if (From < 0)
+				From = Find(pWord[1], 1);
+			Func[From].Frame = atoi(pWord[2]);
+		}
+		else if (strcmp(pWord[0], "call") == 0)
+		{
+			From = FindName(pWord[1]);
+			if (From < 0)
+			{
+				fprintf(stderr, "stack: no function %s\n", pWord[1]);
+				exit(1);
+			}
+			for (i = 2; i < Cnt; i++)
+			{
+				int To = FindName(pWord[i]);
+
+				if (To < 0)
+				{
+					fprintf(stderr, "stack: no function %s\n", pWord[i]);
+					exit(1);
+				}
+				AddEdge(From, To);
+			}
+			Func[From].Resolved = 1;
+		}
+	}
+	fclose(f);
+}
+
+int main(int argc, char **argv)
+{
+	int i;
+
+	if (argc < 3)
+	{
+		fprintf(stderr, "usage: stack <stack.txt> <file.ci>...\n");
+		return 1;
+	}
+
+	Indirect = Find("__indirect_call", 1);
+	for (i = 2; i < argc; i++)
+		ReadGraph(argv[i]);
+	Config(argv[1]);
+	Stacks(argv[1]);
+	return 0;
+}
@@ -0,0 +1,148 @@
+/**
+  ******************************************************************************
+  * File Name          : trace2json.c
+  * Description        : trace ring download -> Chrome trace JSON (chrome://tracing)
+  ******************************************************************************
+  * author: Tomas Krejci <info@tomaskrejci.com>
+  *
+  *	usage: trace2json <pages.bin> > trace.json
+  *	pages.bin = answer data of <CMD_READ_DATA> <TAR_TRACE> pages 0, 1, ...
+  *	            concatenated (trace frozen by mask 0 before download)
+  *	build:  cc -I../cubemx/lasertag/Inc -o trace2json trace2json.c
+  *
+  *	Hit response to stderr, one line per hit done record: from the last
+  *	EXTI0_1 enter (IR RX edge) and as the firmware measured it from its edge
+  *	time stamp, worst of the download at the end. Take the ring frozen by
+  *	LASERTAG_TRACE_HOLD_HIT for the worst hit response of a game.
+  ******************************************************************************
+  */
+#include <stdio.h>
+#include <stdint.h>
+
+#define LASERTAG_TRACE_PC
+#include "lasertag_trace.h"
+
+// IR RX and B1 edges
+#define IRQ_EXTI0_1		5
+
+static const char *IrqName[32] =
+{
+	"WWDG", "PVD", "RTC", "FLASH", "RCC", "EXTI0_1", "EXTI2_3", "EXTI4_15",
+	"TSC", "DMA1_Ch1", "DMA1_Ch2_3", "DMA1_Ch4_5", "ADC1_COMP", "TIM1_BRK", "TIM1_CC", "TIM2",
+	"TIM3", "TIM6_DAC", "IRQ18", "TIM14", "TIM15", "TIM16", "TIM17", "I2C1",
+	"I2C2", "SPI1", "SPI2", "USART1", "USART2", "IRQ29", "CEC_CAN", "IRQ31"
+};
+
+static const char *AppName[] =
+{
+	"hit", "shot", "storage begin", "storage end", "stop enter", "stop exit", "hit done"
+};
+
+static uint32_t Get32(const uint8_t *p)
+{
+	return p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static const char *Irq(uint32_t Arg)
+{
+	return (Arg == LASERTAG_TRACE_IRQ_SYSTICK) ? "SysTick" : IrqName[Arg & 0x1F];
+}
+
+int main(int argc, char *argv[])
+{
+	uint8_t Head[9], Rec[LASERTAG_TRACE_REC_SIZE];
+	uint32_t Clock = 48000000, Time, Prev = 0, Arg, i, Cnt;
+	uint64_t Cycles = 0, Edge = 0;
+	double Us, HitUs, HitMax = 0;
+	uint32_t Hits = 0;
+	char Task[4] = "";
+	int First = 1, Comma = 0, EdgeSeen = 0;
+	FILE *f;
+	
+	if (argc != 2 || (f = fopen(argv[1], "rb")) == NULL)
+	{
+		fprintf(stderr, "usage: trace2json <pages.bin>\n");
+		return 1;
+	}
+	
+	printf("{\"traceEvents\":[\n");
+	
+	while (fread(Head, 1, sizeof(Head), f) == sizeof(Head))
+	{
+		Clock = Get32(&Head[4]);
+		Cnt = Head[8];
+		
+		for (i = 0; i < Cnt && fread(Rec, 1, sizeof(Rec), f) == sizeof(Rec); i++)
+		{
+			// 32 bit cycle counter wraps, records are in order
+			Time = Get32(Rec);
+			if (!First)
+				Cycles += (uint32_t)(Time - Prev);
+			Prev = Time;
+			First = 0;
+			Us = (double)Cycles * 1e6 / Clock;
+			Arg = Rec[5] | ((uint32_t)Rec[6] << 8) | ((uint32_t)Rec[7] << 16);
+			
+			if (Comma)
+				printf(",\n");
+			Comma = 1;
+			
+			if (Rec[4] == LASERTAG_TRACE_ISR_ENTER && Arg == IRQ_EXTI0_1)
+			{
+				Edge = Cycles;
+				EdgeSeen = 1;
+			}
+			if (Rec[4] == LASERTAG_TRACE_HIT_DONE && EdgeSeen)
+			{
+				HitUs = (double)(Cycles - Edge) * 1e6 / Clock;
+				fprintf(stderr, "hit %.1f us from EXTI0_1 enter, firmware %.1f us\n",
+								HitUs, (double)Arg * 1e6 / Clock);
+				if (HitUs > HitMax)
+					HitMax = HitUs;
+				Hits++;
+			}
+			
+			switch (Rec[4])
+			{
+				case LASERTAG_TRACE_ISR_ENTER:
+				case LASERTAG_TRACE_ISR_EXIT:
+					printf("{\"name\":\"%s\",\"ph\":\"%s\",\"pid\":1,\"tid\":1,\"ts\":%.3f}",
+								 Irq(Arg), Rec[4] == LASERTAG_TRACE_ISR_ENTER ? "B" : "E", Us);
+					break;
+					
+				case LASERTAG_TRACE_TASK_IN:
+					if (Task[0] != 0)
+						printf("{\"name\":\"%s\",\"ph\":\"E\",\"pid\":1,\"tid\":2,\"ts\":%.3f},\n", Task, Us);
+					Task[0] = (char)(Arg);
+					Task[1] = (char)(Arg >> 8);
+					Task[2] = (char)(Arg >> 16);
+					printf("{\"name\":\"%s\",\"ph\":\"B\",\"pid\":1,\"tid\":2,\"ts\":%.3f}", Task, Us);
+					break;
+					
+				default:
+					if (Rec[4] >= LASERTAG_TRACE_HIT && Rec[4] <= LASERTAG_TRACE_HIT_DONE)
+						printf("{\"name\":\"%s\",", AppName[Rec[4] - LASERTAG_TRACE_HIT]);
+					else
+						printf("{\"name\":\"event 0x%02X\",", Rec[4]);
+					printf("\"ph\":\"i\",\"s\":\"t\",\"pid\":1,\"tid\":3,\"ts\":%.3f,\"args\":{\"arg\":%u}}",
+								 Us, (unsigned)Arg);
+					break;
+			}
+		}
+	}
+	
+	if (Comma)
+		printf(",\n");
+	printf("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":1,\"args\":{\"name\":\"ISR\"}},\n");
+	printf("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":2,\"args\":{\"name\":\"tasks\"}},\n");
+	printf("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":3,\"args\":{\"name\":\"events\"}}\n");
+	printf("]}\n");
+	fclose(f);
+	
+	if (Hits != 0)
+		fprintf(stderr, "%u hits, worst %.1f us\n", (unsigned)Hits, HitMax);
+	
+	return 0;
+}
+
+/*****************************END OF FILE************************************/